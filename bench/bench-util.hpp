@@ -0,0 +1,126 @@
+#ifndef __BENCH_UTIL_HPP__
+#define __BENCH_UTIL_HPP__
+
+/*
+ * Helpers shared by the benchmark programs: a minimal keep-alive HTTP/1.1
+ * client on raw sockets and process resource readings.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+inline int connectTo(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// sends one request and reads one full response from a kept-alive connection
+inline bool roundTrip(int fd, const std::string &request, std::string &buffer)
+{
+    std::size_t sent = 0;
+    while (sent < request.length())
+    {
+        ssize_t n = send(fd, request.data() + sent, request.length() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += static_cast<std::size_t>(n);
+    }
+
+    char chunk[4096];
+    for (;;)
+    {
+        std::size_t headerEnd = buffer.find("\r\n\r\n");
+        if (headerEnd != std::string::npos)
+        {
+            std::size_t bodyLength = 0;
+            std::size_t pos = buffer.find("Content-Length:");
+            if (pos != std::string::npos && pos < headerEnd)
+                bodyLength = std::strtoul(buffer.c_str() + pos + 15, nullptr, 10);
+            std::size_t total = headerEnd + 4 + bodyLength;
+            if (buffer.length() >= total)
+            {
+                bool ok = buffer.compare(0, 12, "HTTP/1.1 200") == 0;
+                buffer.erase(0, total);
+                return ok;
+            }
+        }
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            return false;
+        buffer.append(chunk, static_cast<std::size_t>(n));
+    }
+}
+
+// p in [0, 1] of an already sorted sample
+inline double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    return sorted[static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1))];
+}
+
+// user + system CPU time of the whole process, in microseconds
+inline long long cpuMicros()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (static_cast<long long>(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000LL +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+// peak resident set size (VmHWM) in kB, 0 when /proc is unavailable
+inline long peakRssKb()
+{
+    FILE *status = fopen("/proc/self/status", "r");
+    if (status == NULL)
+        return 0;
+    char line[256];
+    long kb = 0;
+    while (fgets(line, sizeof(line), status) != NULL)
+    {
+        if (strncmp(line, "VmHWM:", 6) == 0)
+        {
+            kb = std::strtol(line + 6, nullptr, 10);
+            break;
+        }
+    }
+    fclose(status);
+    return kb;
+}
+
+// restart peak RSS tracking so consecutive runs are measured separately
+inline void resetPeakRss()
+{
+    FILE *refs = fopen("/proc/self/clear_refs", "w");
+    if (refs == NULL)
+        return;
+    fputs("5", refs);
+    fclose(refs);
+}
+
+#endif
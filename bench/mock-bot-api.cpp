@@ -0,0 +1,51 @@
+/*
+ * Standalone mock Bot API server.
+ *
+ *   tessergram-mock-api [port] [latency-ms] [429-every-n] [queued-updates]
+ *
+ * Serves until interrupted. Point a bot at http://127.0.0.1:<port> with
+ * `Telegram(token, baseUrl)` or `telegram.setBaseUrl(baseUrl)`.
+ */
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include "mock-bot-api.hpp"
+
+static volatile std::sig_atomic_t interrupted = 0;
+
+static void onSignal(int)
+{
+    interrupted = 1;
+}
+
+int main(int argc, char **argv)
+{
+    int port = argc > 1 ? std::atoi(argv[1]) : 18081;
+    int latency = argc > 2 ? std::atoi(argv[2]) : 0;
+    int every = argc > 3 ? std::atoi(argv[3]) : 0;
+    int queued = argc > 4 ? std::atoi(argv[4]) : 0;
+
+    MockBotApi api("http://127.0.0.1:" + std::to_string(port));
+    api.setLatency(latency);
+    api.setRateLimit(static_cast<unsigned int>(every));
+    for (int i = 0; i < queued; i++)
+        api.pushMessage(1000 + i % 16, "message " + std::to_string(i));
+
+    if (!api.start())
+        return 1;
+    printf("mock Bot API on %s (latency %d ms, 429 every %d, %d updates queued)\n", api.getBaseUrl().c_str(), latency, every, queued);
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    while (!interrupted)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    api.stop();
+    printf("served %llu requests, %llu rate limited\n",
+           static_cast<unsigned long long>(api.getRequestCount()),
+           static_cast<unsigned long long>(api.getRateLimitedCount()));
+    return 0;
+}
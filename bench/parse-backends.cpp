@@ -0,0 +1,155 @@
+/*
+ * Update parsing benchmark.
+ *
+ *   tessergram-parse-bench [batches] [updates-per-batch] [rounds]
+ *
+ * Builds one corpus of getUpdates responses mixing text messages, photo
+ * messages with size variants, callback queries and update kinds the
+ * library skips, then decodes it with every UpdateDecoder backend compiled
+ * in. Each backend sees the same bytes; the best of the rounds is reported.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+#include "update-decoder.hpp"
+#include "log.hpp"
+
+namespace
+{
+    std::string user(long long id)
+    {
+        std::string uid = std::to_string(id);
+        return "{\"id\":" + uid + ",\"is_bot\":false,\"first_name\":\"User " + uid +
+               "\",\"last_name\":\"Example\",\"username\":\"user" + uid + "\",\"language_code\":\"en\"}";
+    }
+
+    std::string chat(long long id, bool group)
+    {
+        if (group)
+            return "{\"id\":-100" + std::to_string(id) + ",\"title\":\"Group " + std::to_string(id) + "\",\"type\":\"supergroup\"}";
+        std::string uid = std::to_string(id);
+        return "{\"id\":" + uid + ",\"first_name\":\"User " + uid + "\",\"username\":\"user" + uid + "\",\"type\":\"private\"}";
+    }
+
+    std::string message(long long id, long long from, bool group, const std::string &body)
+    {
+        return "{\"message_id\":" + std::to_string(id) + ",\"from\":" + user(from) + ",\"chat\":" + chat(from, group) +
+               ",\"date\":1700000000" + body + "}";
+    }
+
+    // one update of every 8 is a callback, one a photo and one an unmodelled kind
+    std::string update(long long updateId)
+    {
+        long long from = 1000 + updateId % 97;
+        bool group = updateId % 3 == 0;
+        std::string head = "{\"update_id\":" + std::to_string(updateId) + ",";
+        switch (updateId % 8)
+        {
+        case 0:
+            return head + "\"callback_query\":{\"id\":\"" + std::to_string(4382900000000LL + updateId) + "\",\"from\":" + user(from) +
+                   ",\"message\":" + message(updateId, from, group, ",\"text\":\"Pick one\"") +
+                   ",\"chat_instance\":\"-7421\",\"data\":\"vote:" + std::to_string(updateId % 5) + "\"}}";
+        case 1:
+        {
+            std::string sizes;
+            for (int i = 0; i < 4; i++)
+            {
+                sizes += std::string(i ? "," : "") + "{\"file_id\":\"AgACAgIAAxkBAAI" + std::to_string(updateId * 10 + i) +
+                         "\",\"file_unique_id\":\"AQAD" + std::to_string(i) + "\",\"file_size\":" + std::to_string(1500 << (i * 2)) +
+                         ",\"width\":" + std::to_string(90 << i) + ",\"height\":" + std::to_string(60 << i) + "}";
+            }
+            return head + "\"message\":" + message(updateId, from, group, ",\"photo\":[" + sizes + "],\"caption\":\"holiday\"") + "}";
+        }
+        case 2:
+            return head + "\"edited_message\":" + message(updateId, from, group, ",\"edit_date\":1700000100,\"text\":\"fixed\"") + "}";
+        default:
+            return head + "\"message\":" +
+                   message(updateId, from, group,
+                           ",\"text\":\"/start hello world " + std::to_string(updateId) +
+                               "\",\"entities\":[{\"offset\":0,\"length\":6,\"type\":\"bot_command\"}]") +
+                   "}";
+        }
+    }
+
+    std::vector<std::string> corpus(int batches, int perBatch)
+    {
+        std::vector<std::string> responses;
+        long long updateId = 1;
+        for (int b = 0; b < batches; b++)
+        {
+            std::string body = "{\"ok\":true,\"result\":[";
+            for (int i = 0; i < perBatch; i++)
+                body += (i ? "," : "") + update(updateId++);
+            responses.push_back(body + "]}");
+        }
+        return responses;
+    }
+
+    void runBackend(UpdateDecoder::Backend backend, const std::vector<std::string> &responses, std::size_t bytes, int rounds)
+    {
+        UpdateDecoder decoder(backend);
+        std::deque<NodeMessage> messages;
+        double best = 0.0;
+        long long decoded = 0, skipped = 0;
+        for (int r = 0; r < rounds; r++)
+        {
+            decoded = 0;
+            skipped = 0;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (const std::string &response : responses)
+            {
+                messages.clear();
+                decoder.decodeUpdates(
+                    response,
+                    [&](const UpdateFilter::Scan &) -> NodeMessage *
+                    {
+                        messages.emplace_back();
+                        return &messages.back();
+                    },
+                    [&](NodeMessage &, JSONReader::Status status)
+                    {
+                        if (status == JSONReader::Status::OK)
+                            decoded++;
+                        else
+                            skipped++;
+                    });
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (r == 0 || seconds < best)
+                best = seconds;
+        }
+        long long updates = decoded + skipped;
+        printf("%9s %10lld %9lld %12.0f %10.1f %9.3f\n", UpdateDecoder::backendToString(backend), decoded, skipped,
+               static_cast<double>(updates) / best, static_cast<double>(bytes) / best / (1024.0 * 1024.0),
+               best * 1e6 / static_cast<double>(updates));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int batches = argc > 1 ? std::max(1, std::atoi(argv[1])) : 500;
+    int perBatch = argc > 2 ? std::max(1, std::atoi(argv[2])) : 100;
+    int rounds = argc > 3 ? std::max(1, std::atoi(argv[3])) : 5;
+
+    Log::setLevel(Log::ERROR);
+
+    std::vector<std::string> responses = corpus(batches, perBatch);
+    std::size_t bytes = 0;
+    for (const std::string &response : responses)
+        bytes += response.size();
+
+    printf("%d responses x %d updates, %.1f MB, best of %d\n", batches, perBatch, static_cast<double>(bytes) / (1024.0 * 1024.0), rounds);
+    printf("%9s %10s %9s %12s %10s %9s\n", "backend", "decoded", "skipped", "upd/s", "MB/s", "us/upd");
+    for (UpdateDecoder::Backend backend : {UpdateDecoder::Backend::NLOHMANN, UpdateDecoder::Backend::SIMDJSON})
+    {
+        if (UpdateDecoder::available(backend))
+            runBackend(backend, responses, bytes, rounds);
+        else
+            printf("%9s (not built, configure with -DTESSERGRAM_SIMDJSON=ON)\n", UpdateDecoder::backendToString(backend));
+    }
+    return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * End-to-end throughput benchmark.
+ *
+ *   tessergram-throughput [polling|webhook] [updates] [threads,...] [bots] [mock-latency-ms]
+ *
+ * Runs the full pipeline against a local MockBotApi: updates are ingested
+ * (getUpdates polling or webhook deliveries), parsed, dispatched by a BotHost
+ * with the given number of worker threads, and every handler replies with
+ * apiSendMessage. Each update carries its creation time, so the reported
+ * latency covers ingest to completed reply.
+ *
+ * CPU and peak RSS are process-wide and therefore include the mock server
+ * and, in webhook mode, the load clients running in the same process.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bot-host.hpp"
+#include "mock-bot-api.hpp"
+#include "log.hpp"
+#include "bench-util.hpp"
+
+namespace
+{
+    const int WEBHOOK_CLIENTS = 16;
+
+    long long nowMicros()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    class Run
+    {
+    public:
+        std::atomic<long long> done;
+        std::atomic<long long> failedReplies;
+        std::mutex mutex;
+        std::vector<double> latencies;
+
+        Run() : done(0), failedReplies(0), mutex(), latencies() {}
+    };
+
+    std::string webhookUpdate(long long updateId, long long chatId)
+    {
+        std::string id = std::to_string(updateId);
+        std::string chat = std::to_string(chatId);
+        return "{\"update_id\":" + id +
+               ",\"message\":{\"message_id\":" + id + ",\"date\":1700000000,"
+               "\"from\":{\"id\":" + chat + ",\"is_bot\":false,\"first_name\":\"u\",\"username\":\"u\"},"
+               "\"chat\":{\"id\":" + chat + ",\"type\":\"private\",\"first_name\":\"u\",\"username\":\"u\"},"
+               "\"text\":\"t=" + std::to_string(nowMicros()) + "\"}}";
+    }
+
+    void driveWebhook(int port, int bots, long long updates)
+    {
+        std::atomic<long long> next(0);
+        std::vector<std::thread> clients;
+        for (int i = 0; i < WEBHOOK_CLIENTS; i++)
+        {
+            clients.emplace_back(
+                [&, port]()
+                {
+                    std::string buffer;
+                    int fd = connectTo(port);
+                    for (long long n = next++; n < updates && fd >= 0; n = next++)
+                    {
+                        std::string body = webhookUpdate(n + 1, 1000 + n % 64);
+                        std::string request = "POST /hook/" + std::to_string(n % bots) +
+                                              " HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: application/json\r\nContent-Length: " +
+                                              std::to_string(body.length()) + "\r\n\r\n" + body;
+                        if (!roundTrip(fd, request, buffer))
+                        {
+                            close(fd);
+                            buffer.clear();
+                            fd = connectTo(port);
+                        }
+                    }
+                    if (fd >= 0)
+                        close(fd);
+                });
+        }
+        for (std::thread &client : clients)
+            client.join();
+    }
+
+    void runOnce(bool webhook, long long updates, int threads, int bots, int latencyMs, int port)
+    {
+        MockBotApi api("http://127.0.0.1:" + std::to_string(port));
+        api.setLatency(latencyMs);
+        if (!api.start())
+            return;
+
+        Run run;
+        std::function<void(Telegram &, const NodeMessage &)> handler =
+            [&run](Telegram &t, const NodeMessage &message)
+        {
+            message.processMessage(
+                [&](const Message &m)
+                {
+                    long long created = 0;
+                    if (m.text.compare(0, 2, "t=") == 0)
+                        created = std::strtoll(m.text.c_str() + 2, nullptr, 10);
+                    if (!t.apiSendMessage(m.chat.id, "ok"))
+                        run.failedReplies++;
+                    double ms = static_cast<double>(nowMicros() - created) / 1000.0;
+                    std::lock_guard<std::mutex> guard(run.mutex);
+                    run.latencies.push_back(ms);
+                });
+            run.done++;
+        };
+
+        BotHost host(static_cast<std::size_t>(threads));
+        for (int b = 0; b < bots; b++)
+        {
+            std::string token = std::to_string(b + 1) + ":bench";
+            Telegram &telegram = webhook ? host.addWebhook(token, "/hook/" + std::to_string(b), "", handler)
+                                         : host.addPolling(token, handler);
+            telegram.setBaseUrl(api.getBaseUrl());
+            telegram.setMinPollInterval(0);
+        }
+        WebhookServer::Config config;
+        config.listenAddress = "http://127.0.0.1:" + std::to_string(port + 1);
+        config.maxConnections = WEBHOOK_CLIENTS * 2;
+        if (webhook)
+            host.listen(config);
+
+        resetPeakRss();
+        long long cpuStart = cpuMicros();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        if (!webhook)
+        {
+            // stamp every update up front: latency includes time spent queued
+            for (long long n = 0; n < updates; n++)
+                api.pushMessage(1000 + n % 64, "t=" + std::to_string(nowMicros()), std::to_string(n % bots + 1) + ":bench");
+        }
+
+        std::thread loop(
+            [&host]()
+            {
+                host.run();
+            });
+        if (webhook)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            driveWebhook(port + 1, bots, updates);
+        }
+
+        std::chrono::steady_clock::time_point giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(120);
+        while (run.done < updates && std::chrono::steady_clock::now() < giveUp)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        long long cpu = cpuMicros() - cpuStart;
+        host.stop();
+        loop.join();
+        api.stop();
+
+        std::sort(run.latencies.begin(), run.latencies.end());
+        long long handled = run.done;
+        printf("%7d %10lld %10.0f %9.2f %9.2f %9.2f %11.1f %9.1f %8lld\n",
+               threads,
+               handled,
+               elapsed > 0 ? static_cast<double>(handled) / elapsed : 0.0,
+               percentile(run.latencies, 0.50),
+               percentile(run.latencies, 0.90),
+               percentile(run.latencies, 0.99),
+               handled > 0 ? static_cast<double>(cpu) / static_cast<double>(handled) : 0.0,
+               static_cast<double>(peakRssKb()) / 1024.0,
+               run.failedReplies.load());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool webhook = argc > 1 && std::string(argv[1]) == "webhook";
+    long long updates = argc > 2 ? std::atoll(argv[2]) : 20000;
+    std::string threadList = argc > 3 ? argv[3] : "1,2,4,8";
+    int bots = argc > 4 ? std::max(1, std::atoi(argv[4])) : 8;
+    int latencyMs = argc > 5 ? std::atoi(argv[5]) : 0;
+
+    // measure the pipeline, not the console
+    Log::setLevel(Log::ERROR);
+
+    std::vector<int> threadCounts;
+    std::stringstream list(threadList);
+    std::string item;
+    while (std::getline(list, item, ','))
+    {
+        if (std::atoi(item.c_str()) > 0)
+            threadCounts.push_back(std::atoi(item.c_str()));
+    }
+
+    printf("mode %s, %lld updates, %d bots, mock latency %d ms\n", webhook ? "webhook" : "polling", updates, bots, latencyMs);
+    printf("%7s %10s %10s %9s %9s %9s %11s %9s %8s\n",
+           "threads", "updates", "upd/s", "p50 ms", "p90 ms", "p99 ms", "cpu us/upd", "peak MB", "errors");
+
+    int port = 18600;
+    for (int threads : threadCounts)
+    {
+        runOnce(webhook, updates, threads, bots, latencyMs, port);
+        port += 2;
+    }
+    return 0;
+}
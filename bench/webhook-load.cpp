@@ -0,0 +1,115 @@
+/*
+ * Local load test for the webhook server.
+ *
+ *   tessergram-webhook-load [connections] [requests-per-connection] [port]
+ *
+ * Starts a Telegram webhook server on 127.0.0.1 and drives it with keep-alive
+ * clients, one thread per connection, each posting updates back to back the
+ * way Telegram does with max_connections. Prints throughput, latency
+ * percentiles and how many updates reached the handler.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "telegram.hpp"
+#include "bench-util.hpp"
+
+static std::atomic<long long> nextUpdateId(1);
+
+static std::string makeUpdate()
+{
+    std::string id = std::to_string(nextUpdateId++);
+    return "{\"update_id\":" + id +
+           ",\"message\":{\"message_id\":" + id + ",\"date\":1700000000,"
+           "\"from\":{\"id\":1,\"is_bot\":false,\"first_name\":\"Load\",\"username\":\"load\"},"
+           "\"chat\":{\"id\":1,\"type\":\"private\",\"first_name\":\"Load\",\"username\":\"load\"},"
+           "\"text\":\"hello\"}}";
+}
+
+int main(int argc, char **argv)
+{
+    int connections = argc > 1 ? std::atoi(argv[1]) : 40;
+    int requests = argc > 2 ? std::atoi(argv[2]) : 2000;
+    int port = argc > 3 ? std::atoi(argv[3]) : 18443;
+
+    std::atomic<long long> handled(0);
+    Telegram telegram;
+    WebhookServer::Config config;
+    config.listenAddress = "http://127.0.0.1:" + std::to_string(port);
+    config.maxConnections = static_cast<std::size_t>(connections);
+    config.backlog = connections * 2;
+    telegram.setWebhookConfig(config);
+    telegram.setWebhookCallback(
+        [&](Telegram &, const NodeMessage &)
+        {
+            handled++;
+        });
+
+    std::thread server(
+        [&]()
+        {
+            telegram.servWebhook();
+        });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::mutex latencyMutex;
+    std::vector<double> latencies;
+    latencies.reserve(static_cast<std::size_t>(connections) * static_cast<std::size_t>(requests));
+    std::atomic<long long> failures(0);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (int i = 0; i < connections; i++)
+    {
+        clients.emplace_back(
+            [&]()
+            {
+                std::vector<double> local;
+                local.reserve(static_cast<std::size_t>(requests));
+                std::string buffer;
+                int fd = connectTo(port);
+                for (int r = 0; r < requests && fd >= 0; r++)
+                {
+                    std::string body = makeUpdate();
+                    std::string request = "POST /hook HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: application/json\r\nContent-Length: " +
+                                          std::to_string(body.length()) + "\r\n\r\n" + body;
+                    std::chrono::steady_clock::time_point sentAt = std::chrono::steady_clock::now();
+                    if (!roundTrip(fd, request, buffer))
+                    {
+                        failures++;
+                        close(fd);
+                        buffer.clear();
+                        fd = connectTo(port);
+                        continue;
+                    }
+                    local.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sentAt).count());
+                }
+                if (fd >= 0)
+                    close(fd);
+                std::lock_guard<std::mutex> guard(latencyMutex);
+                latencies.insert(latencies.end(), local.begin(), local.end());
+            });
+    }
+    for (std::thread &client : clients)
+        client.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // let the dispatcher drain before reporting
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    telegram.stopWebhook();
+    server.join();
+
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("connections      : %d\n", connections);
+    printf("requests         : %zu ok, %lld failed\n", latencies.size(), failures.load());
+    printf("throughput       : %.0f req/s\n", elapsed > 0 ? static_cast<double>(latencies.size()) / elapsed : 0.0);
+    printf("latency p50/p99  : %.3f / %.3f ms (max %.3f)\n", percentile(latencies, 0.50), percentile(latencies, 0.99), percentile(latencies, 1.0));
+    printf("handled updates  : %lld\n", handled.load());
+    return failures.load() == 0 ? 0 : 1;
+}
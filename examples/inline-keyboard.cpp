@@ -29,7 +29,13 @@ int main(int argc, char **argv)
 
         const nlohmann::json &jTarget = env["bot"]["target_id"];
         long long targetId = jTarget.is_number() ? jTarget.get<long long>() : std::stoll(jTarget.get<std::string>());
-        telegram.apiSendKeyboard(targetId, keyboard);
+        Message sent;
+        if (telegram.apiSendKeyboard(targetId, keyboard, sent))
+        {
+            TKeyboard edited(TKeyboard::Type::INLINE_KEYBOARD, "Test Keyboard (edited)!");
+            edited.add(buttons);
+            telegram.apiEditInlineKeyboard(targetId, sent.id, edited);
+        }
     }
     else
     {
@@ -31,12 +31,15 @@ private:
 
     void processMedia(Telegram &telegram, const std::vector<Media> &media)
     {
-        if (media.size() == 0)
-            return;
-        std::string path = telegram.apiGetMediaPath(media.at(media.size() - 1).fileId);
-        Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "Media path of \"%s\": %s\n", media.at(media.size() - 1).fileId.c_str(), path.c_str());
-        std::vector<unsigned char> mediaPayload = telegram.apiDownloadMediaByPath(path);
-        this->writeFile(path, mediaPayload);
+        for (const Media &item : media)
+        {
+            // bots can download up to 20 MB; photos pick the largest size under that
+            Media::Size file = item.bestFor(20 * 1024 * 1024);
+            std::string path = telegram.apiGetMediaPath(file.fileId);
+            Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "Media path of \"%s\": %s\n", file.fileId.c_str(), path.c_str());
+            std::vector<unsigned char> mediaPayload = telegram.apiDownloadMediaByPath(path);
+            this->writeFile(path, mediaPayload);
+        }
     }
 
     std::string getReplay(const std::string &message)
@@ -126,7 +129,6 @@ public:
                         {
                             this->handler(telegram, message);
                         });
-                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
                 }
             }
             else
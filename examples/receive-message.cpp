@@ -3,7 +3,6 @@
 #include <sstream>
 #include <string>
 #include <unistd.h>
-#include <thread>
 #include "telegram.hpp"
 #include "utils/include/nlohmann/json.hpp"
 #include "utils/include/debug.hpp"
@@ -19,27 +18,23 @@ int main(int argc, char **argv)
         telegram.info();
         telegram.clearUpdates();
 
-        for (;;)
-        {
-            telegram.getUpdates(
-                [](Telegram &t, const NodeMessage &message)
-                {
-                    message.display();
-                    message
-                        .processMessage(
-                            [&](const Message &m)
-                            {
-                                t.apiSendMessage(m.chat.id, "Hi...");
-                            })
-                        .processCallbackQuery(
-                            [&](const CallbackQuery &c)
-                            {
-                                t.apiSendMessage(c.message->chat.id, "Hello...");
-                            });
-                    exit(0);
-                });
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-        }
+        telegram.run(
+            [](Telegram &t, const NodeMessage &message)
+            {
+                message.display();
+                message
+                    .processMessage(
+                        [&](const Message &m)
+                        {
+                            t.apiSendMessage(m.chat.id, "Hi...");
+                        })
+                    .processCallbackQuery(
+                        [&](const CallbackQuery &c)
+                        {
+                            t.apiSendMessage(c.message->chat.id, "Hello...");
+                        });
+                t.stop();
+            });
     }
     else
     {
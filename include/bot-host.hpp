@@ -0,0 +1,82 @@
+#ifndef __BOT_HOST_HPP__
+#define __BOT_HOST_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "telegram.hpp"
+#include "worker-pool.hpp"
+
+struct mg_connection;
+
+/**
+ * Runs many bots in one process.
+ *
+ * A single event loop thread owns the webhook listener and decides which
+ * polling bots are due; the polls and handlers themselves run on a shared
+ * worker pool, so the number of threads does not grow with the number of
+ * bots. Work for one bot is never run concurrently: handlers of a bot see
+ * its updates in order.
+ *
+ * Webhook deliveries are routed by URL path first and by the
+ * X-Telegram-Bot-Api-Secret-Token header second. Keep long polling off for
+ * hosted polling bots: a long poll occupies a worker for its whole duration.
+ */
+class BotHost
+{
+public:
+    explicit BotHost(std::size_t workers = 4);
+    ~BotHost();
+
+    Telegram &addPolling(const std::string &token, std::function<void(Telegram &, const NodeMessage &)> handler);
+    Telegram &addWebhook(const std::string &token, const std::string &path, const std::string &secretToken, std::function<void(Telegram &, const NodeMessage &)> handler);
+    void listen(const std::string &address);
+    void listen(const WebhookServer::Config &config);
+
+    void run();
+    void stop();
+    bool isRunning() const;
+
+    std::size_t size() const;
+    Telegram *route(const std::string &path, const std::string &secretToken) const;
+
+private:
+    class Bot
+    {
+    public:
+        std::unique_ptr<Telegram> telegram;
+        std::function<void(Telegram &, const NodeMessage &)> handler;
+        std::string secretToken;
+        bool polling;
+        bool busy;
+        bool webhookPending;
+    };
+
+    std::deque<Bot> bots;
+    std::unordered_map<std::string, std::size_t> byPath;
+    std::unordered_map<std::string, std::size_t> bySecret;
+    WebhookServer::Config webhookConfig;
+    std::atomic<std::size_t> connections;
+    std::atomic<bool> running;
+
+    mutable std::mutex mutex;
+    std::condition_variable idle;
+
+    // last member: destroyed first, so in-flight jobs finish while the
+    // state they touch is still alive
+    WorkerPool workers;
+
+    Bot &add(const std::string &token, std::function<void(Telegram &, const NodeMessage &)> handler);
+    long routeUnlocked(const std::string &path, const std::string &secretToken) const;
+    int schedule();
+    void release(Bot &bot);
+    static void onHttp(struct mg_connection *c, int ev, void *ev_data);
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef __JSON_READER_HPP__
+#define __JSON_READER_HPP__
+
+#include <string>
+#include <cstdint>
+#include "utils/include/nlohmann/json_fwd.hpp"
+
+/**
+ * Exception-free field access for inbound Bot API payloads.
+ *
+ * Accessors report a missing key or a wrong type through `Status` instead of
+ * throwing, and leave the output untouched on failure. Rejecting an update
+ * therefore costs a branch, not an unwind plus a formatted message.
+ */
+class JSONReader
+{
+public:
+    enum class Status : uint8_t
+    {
+        OK = 0,
+        MALFORMED,    // not JSON at all
+        MISSING,      // a mandatory key is absent
+        WRONG_TYPE,   // a mandatory key has an unexpected type
+        UNKNOWN_KIND  // an update kind this library does not model
+    };
+
+    static const char *statusToString(Status status);
+
+    static bool parse(const std::string &text, nlohmann::json &out);
+
+    static Status get(const nlohmann::json &json, const char *key, long long &out);
+    static Status get(const nlohmann::json &json, const char *key, std::string &out);
+    static Status get(const nlohmann::json &json, const char *key, bool &out);
+    static const nlohmann::json *find(const nlohmann::json &json, const char *key);
+    static const nlohmann::json *object(const nlohmann::json &json, const char *key);
+    static const nlohmann::json *array(const nlohmann::json &json, const char *key);
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef __JSON_WRITER_HPP__
+#define __JSON_WRITER_HPP__
+
+#include <string>
+#include <cstdint>
+
+/**
+ * Minimal streaming JSON serializer for outbound Bot API payloads.
+ *
+ * Values are escaped and appended directly into one string buffer, so no
+ * intermediate DOM is built. `JSONWriter::local()` hands out a per-thread
+ * instance whose buffer keeps its capacity between requests.
+ */
+class JSONWriter
+{
+public:
+    JSONWriter();
+    ~JSONWriter();
+
+    /**
+     * Returns the calling thread's shared writer, already cleared.
+     * The previous content is invalidated, so the returned buffer must be
+     * consumed before the same thread calls `local()` again.
+     */
+    static JSONWriter &local();
+
+    JSONWriter &clear();
+
+    JSONWriter &beginObject();
+    JSONWriter &endObject();
+    JSONWriter &beginArray();
+    JSONWriter &endArray();
+
+    JSONWriter &key(const char *name);
+    JSONWriter &key(const std::string &name);
+
+    JSONWriter &value(const char *val);
+    JSONWriter &value(const std::string &val);
+    JSONWriter &value(long long val);
+    JSONWriter &value(int val);
+    JSONWriter &value(bool val);
+
+    template <typename T>
+    JSONWriter &field(const char *name, const T &val)
+    {
+        return this->key(name).value(val);
+    }
+
+    const std::string &str() const;
+    bool empty() const;
+
+private:
+    static const uint8_t MAX_DEPTH = 64;
+
+    std::string buffer;
+    uint64_t populated;
+    uint8_t depth;
+    bool afterKey;
+
+    void separate();
+    void open(char bracket);
+    void close(char bracket);
+    void appendEscaped(const char *str, std::size_t length);
+};
+
+#endif
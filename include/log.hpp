@@ -0,0 +1,78 @@
+#ifndef __TESSERGRAM_LOG_HPP__
+#define __TESSERGRAM_LOG_HPP__
+
+#include <string>
+#include <cstdint>
+
+/*
+ * Lowest level compiled into the library: 0 = INFO, 1 = WARNING, 2 = ERROR,
+ * 3 = NONE. Calls below it are removed by the compiler together with the
+ * evaluation of their arguments. Set via -DTESSERGRAM_LOG_LEVEL=<n>.
+ */
+#ifndef TESSERGRAM_LOG_LEVEL
+#define TESSERGRAM_LOG_LEVEL 0
+#endif
+
+/**
+ * Cost-controlled front end for Debug::log used on hot paths.
+ *
+ * Messages pass a compile-time gate, then a runtime gate (one relaxed atomic
+ * load). In async mode a record is pushed into a lock-free ring buffer and a
+ * background thread writes it out. Request/response payloads are sampled and
+ * truncated; the calling thread only copies the bytes, formatting happens on
+ * the background thread.
+ */
+class Log
+{
+public:
+    enum Level : uint8_t
+    {
+        INFO = 0,
+        WARNING = 1,
+        ERROR = 2,
+        NONE = 3
+    };
+
+    static constexpr bool compiled(Level level)
+    {
+        // a difference, so a level of 0 does not compare unsigned against 0 (-Wtype-limits)
+        return static_cast<int>(level) - TESSERGRAM_LOG_LEVEL >= 0 && level != NONE;
+    }
+
+    static bool enabled(Level level);
+    static void setLevel(Level level);
+    static Level getLevel();
+
+    /** Logs one payload out of every `every` calls (1 = all, 0 = none). */
+    static void setPayloadSampling(unsigned int every);
+    /** Payloads longer than `bytes` are cut and suffixed with their full size. */
+    static void setPayloadLimit(std::size_t bytes);
+
+    static void startAsync();
+    static void stopAsync();
+    static bool isAsync();
+    static unsigned long long dropped();
+
+    static void write(Level level, const char *file, int line, const char *func, const char *fmt, ...)
+#if defined(__GNUC__) || defined(__clang__)
+        __attribute__((format(printf, 5, 6)))
+#endif
+        ;
+    static void payload(Level level, const char *file, int line, const char *func, const char *label, const std::string &data);
+};
+
+#define TG_LOG(level, ...)                                                        \
+    do                                                                            \
+    {                                                                             \
+        if (Log::compiled(level) && Log::enabled(level))                          \
+            Log::write(level, __FILE__, __LINE__, __func__, __VA_ARGS__);         \
+    } while (0)
+
+#define TG_LOG_PAYLOAD(level, label, data)                                        \
+    do                                                                            \
+    {                                                                             \
+        if (Log::compiled(level) && Log::enabled(level))                          \
+            Log::payload(level, __FILE__, __LINE__, __func__, label, data);       \
+    } while (0)
+
+#endif
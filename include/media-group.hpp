@@ -0,0 +1,103 @@
+#ifndef __MEDIA_GROUP_HPP__
+#define __MEDIA_GROUP_HPP__
+
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "node-message.hpp"
+#include "type.hpp"
+
+class Telegram;
+
+/**
+ * One album: the messages sharing a `media_group_id`, combined.
+ *
+ * `media` and `messageIds` follow message order; the caption is the one
+ * the album carries (Telegram puts it on a single item).
+ */
+class MediaGroup
+{
+public:
+    std::string id;
+    Chat chat;
+    User from;
+    std::string caption;
+    std::vector<Media> media;
+    std::vector<long long> messageIds;
+    time_t dtime;
+
+    MediaGroup();
+};
+
+/**
+ * Handler stage buffering album parts until the album is complete.
+ *
+ * Wrap the update handler with `handler()`: messages without a
+ * `media_group_id` go straight to it, album parts are held per chat and
+ * group id and delivered once to the `onGroup` handler when no new part
+ * arrived for `windowMs`, or as soon as the tenth (Telegram's maximum)
+ * is in. Group handlers run on the aggregator's timer thread, or on the
+ * caller's thread for full albums and `flush()`; one that throws is
+ * logged. The destructor delivers what is still pending, so destroy the
+ * aggregator before the Telegram instances it was fed from.
+ *
+ * Parts are held after the wrapped handler has returned, so a polling bot
+ * would commit their offset before the album is handled and lose it in a
+ * crash. Pass `oldestPendingUpdateId()` to `Telegram::setCommitHold()` to
+ * keep the offset below the held parts.
+ */
+class MediaGroupAggregator
+{
+public:
+    typedef std::function<void(Telegram &, const NodeMessage &)> Handler;
+    typedef std::function<void(Telegram &, const MediaGroup &)> GroupHandler;
+
+    static const std::size_t MAX_GROUP_SIZE = 10;
+
+    explicit MediaGroupAggregator(int windowMs = 500);
+    ~MediaGroupAggregator();
+
+    MediaGroupAggregator &onGroup(GroupHandler handler);
+    Handler handler(Handler next = nullptr);
+
+    // delivers every pending album now
+    void flush();
+    std::size_t pending() const;
+    // lowest update id of a held part, 0 when nothing is held
+    long long oldestPendingUpdateId() const;
+
+private:
+    class Pending
+    {
+    public:
+        Telegram *telegram;
+        MediaGroup group;
+        std::map<long long, std::vector<Media>> parts; // by message id
+        long long firstUpdateId;
+        std::chrono::steady_clock::time_point deadline;
+
+        Pending();
+    };
+
+    std::chrono::milliseconds window;
+    GroupHandler groupHandler;
+    std::unordered_map<std::string, Pending> groups;
+    bool stopping;
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    std::thread timer;
+
+    bool add(Telegram &telegram, long long updateId, const Message &message);
+    void deliver(Pending &pending);
+    void run();
+};
+
+#endif
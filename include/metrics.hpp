@@ -0,0 +1,112 @@
+#ifndef __METRICS_HPP__
+#define __METRICS_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Process-wide metrics registry.
+ *
+ * Series are registered once (under a mutex) and handed out as stable
+ * references; updating a series afterwards is a handful of relaxed atomic
+ * operations. `snapshot()` copies the current values and `exportPrometheus()`
+ * renders them in the Prometheus text exposition format.
+ */
+class Metrics
+{
+public:
+    enum class Kind : uint8_t
+    {
+        COUNTER = 0,
+        GAUGE,
+        HISTOGRAM
+    };
+
+    class Counter
+    {
+    public:
+        Counter();
+        void add(uint64_t n = 1);
+        uint64_t value() const;
+
+    private:
+        std::atomic<uint64_t> count;
+    };
+
+    class Gauge
+    {
+    public:
+        Gauge();
+        void set(long long val);
+        void add(long long delta);
+        long long value() const;
+
+    private:
+        std::atomic<long long> current;
+    };
+
+    class Histogram
+    {
+    public:
+        static const std::size_t BUCKET_COUNT = 12;
+        static const double BOUNDS[BUCKET_COUNT];
+
+        Histogram();
+        void observe(double seconds);
+        void observeMicros(uint64_t micros);
+
+    private:
+        friend class Metrics;
+        std::atomic<uint64_t> buckets[BUCKET_COUNT + 1];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sumMicros;
+    };
+
+    class Sample
+    {
+    public:
+        Kind kind;
+        std::string name;
+        std::string labels;
+        std::string help;
+        double value;
+        uint64_t count;
+        double sum;
+        std::vector<uint64_t> buckets;
+    };
+
+    static Metrics &global();
+
+    Counter &counter(const std::string &name, const std::string &labels, const std::string &help);
+    Gauge &gauge(const std::string &name, const std::string &labels, const std::string &help);
+    Histogram &histogram(const std::string &name, const std::string &labels, const std::string &help);
+
+    std::vector<Sample> snapshot() const;
+    std::string exportPrometheus() const;
+
+    static std::string label(const std::string &key, const std::string &value);
+
+private:
+    class Entry
+    {
+    public:
+        Kind kind;
+        std::string name;
+        std::string labels;
+        std::string help;
+        Counter counter;
+        Gauge gauge;
+        Histogram histogram;
+    };
+
+    std::deque<Entry> entries;
+    mutable std::mutex mutex;
+
+    Entry &lookup(Kind kind, const std::string &name, const std::string &labels, const std::string &help);
+};
+
+#endif
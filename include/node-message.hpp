@@ -7,6 +7,8 @@
 
 class NodeMessage
 {
+    friend class UpdateDecoder;
+
 private:
     long long updateId;
     CallbackQuery callbackQuery;
@@ -18,6 +20,7 @@ public:
     ~NodeMessage();
 
     void parse(const nlohmann::json &message);
+    JSONReader::Status tryParse(const nlohmann::json &message);
     void display() const;
 
     long long getId() const;
@@ -0,0 +1,61 @@
+#ifndef __OFFSET_STORE_HPP__
+#define __OFFSET_STORE_HPP__
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+/**
+ * Persists the highest update id whose handlers have finished.
+ *
+ * Telegram loads the value once when the store is attached and calls
+ * `commit()` after each handled batch; `flush()` is called when polling
+ * stops. Implementations must be safe to call from the dispatcher thread
+ * while another thread is fetching.
+ */
+class OffsetStore
+{
+public:
+    virtual ~OffsetStore();
+
+    virtual long long load() = 0;
+    virtual void commit(long long updateId) = 0;
+    virtual void flush() = 0;
+};
+
+/**
+ * Offset store backed by a single fixed-size record in a file.
+ *
+ * Every commit overwrites the record in place; the file is synced to disk
+ * only every `syncEvery` commits or `syncIntervalMs` milliseconds, so a crash
+ * replays at most that many batches instead of losing them.
+ */
+class FileOffsetStore : public OffsetStore
+{
+public:
+    FileOffsetStore(const std::string &path, unsigned int syncEvery = 32, int syncIntervalMs = 1000);
+    ~FileOffsetStore();
+
+    long long load() override;
+    void commit(long long updateId) override;
+    void flush() override;
+
+    const std::string &getPath() const;
+
+    static std::string defaultPath(const std::string &token);
+
+private:
+    std::string path;
+    int fd;
+    unsigned int syncEvery;
+    int syncIntervalMs;
+    unsigned int pending;
+    long long lastCommitted;
+    std::chrono::steady_clock::time_point lastSync;
+    std::mutex mutex;
+
+    void writeUnlocked(long long updateId);
+    void syncUnlocked();
+};
+
+#endif
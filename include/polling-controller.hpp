@@ -3,28 +3,80 @@
 
 #include <functional>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
 
+/**
+ * Adaptive poll scheduler.
+ *
+ * `run()` sleeps until the next poll is due and then polls once. Failed
+ * polls back off exponentially (with jitter) from the normal interval up to
+ * the slow interval; polls that return updates (reported through
+ * `observe()`) halve the interval down to the minimum interval, and idle
+ * polls relax it back to the normal one.
+ * `runUntil()` additionally gives up once a deadline passes, and
+ * `runIfDue()` never waits, for callers that schedule many controllers.
+ * `runNow()` polls at once and only records the outcome, for callers that
+ * pace themselves but still want failures to back off.
+ *
+ * With a limit range set it also sizes getUpdates batches: a full batch
+ * means a backlog and doubles the limit, while the measured handler rate
+ * caps it so one batch takes about the target batch time to handle.
+ */
 class PollingController
 {
 public:
-    enum class State : uint8_t { NORMAL, SLOW };
+    enum class State : uint8_t { NORMAL, SLOW, BUSY };
 
     PollingController(int normalIntervalMs = 3000, int slowIntervalMs = 10000);
     void run(std::function<bool()> func);
+    bool runUntil(std::chrono::steady_clock::time_point deadline, std::function<bool()> func);
+    bool runIfDue(std::function<bool()> func);
+    void runNow(std::function<bool()> func);
+    void observe(std::size_t updates);
+    void cancel();
+    void resume();
+
+    void setMinInterval(int minIntervalMs);
+    void setFailureThreshold(int failures);
+    void setLimitRange(int minLimit, int maxLimit);
+    void setTargetBatchTime(int milliseconds);
+    void observeFetched(std::size_t received);
+    void observeHandled(std::size_t updates, std::chrono::steady_clock::duration elapsed);
+
     State getState() const;
+    int getCurrentInterval() const;
+    int getLimit() const;
+    std::chrono::steady_clock::time_point getNextPollTime() const;
 
 private:
-    static const int FAILURE_THRESHOLD = 3;
-
+    bool waitUntilDue(const std::chrono::steady_clock::time_point *deadline);
     void performPolling(std::function<bool()> func);
     void transition(bool success);
-    int getCurrentInterval() const;
+    void enter(State next);
+    int backoff();
+    void capLimit();
 
     State state;
     int normalInterval;
     int slowInterval;
+    int minInterval;
+    int interval;
+    int failureThreshold;
     int consecutiveFailures;
-    std::chrono::steady_clock::time_point lastPollTime;
+    std::size_t lastBatch;
+    int minLimit;
+    int maxLimit; // 0: no limit is sent, the server default applies
+    int limit;
+    int targetBatchMs;
+    double handledPerSecond; // moving average, 0 until measured
+    bool cancelled;
+    std::chrono::steady_clock::time_point nextPollTime;
+    std::minstd_rand rng;
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
 };
 
 #endif
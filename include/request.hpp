@@ -2,6 +2,7 @@
 #define __REQUEST_API_HPP__
 
 #include <string>
+#include <vector>
 #include "utils/include/nlohmann/json_fwd.hpp"
 
 #if __cplusplus >= 201703L
@@ -12,12 +13,14 @@
 #  define NODISCARD
 #endif
 
+class JSONWriter;
+class Endpoint;
+
 class Request
 {
 private:
     bool success;
-    std::string url;
-    std::string response;
+    std::string *response;
 
 public:
     enum class Type : uint8_t
@@ -37,15 +40,56 @@ public:
         SEND_VOICE,
         SEND_DOCUMENT,
         SET_WEBHOOK,
-        UNSET_WEBHOOK
+        UNSET_WEBHOOK,
+        COPY_MESSAGE,
+        FORWARD_MESSAGE,
+        COPY_MESSAGES,
+        FORWARD_MESSAGES,
+        DELETE_MESSAGE,
+        DELETE_MESSAGES
     };
-    Request(const std::string &url, const std::string &token, Type req);
-    Request(const std::string &url, const std::string &token, Type req, const std::string &data);
-    Request(const std::string &url, const std::string &token, Type req, const nlohmann::json &data);
-    Request(const std::string &url, const std::string &token, Type req, const std::string &ref, std::vector<unsigned char> &data);
+    Request(const Endpoint &endpoint, Type req);
+    Request(const Endpoint &endpoint, Type req, const std::string &data);
+    Request(const Endpoint &endpoint, Type req, const nlohmann::json &data);
+    Request(const Endpoint &endpoint, Type req, const JSONWriter &data);
+    Request(const Endpoint &endpoint, Type req, const std::string &ref, std::vector<unsigned char> &data);
+    Request(const Request &) = delete;
+    Request &operator=(const Request &) = delete;
     ~Request();
     NODISCARD bool isSuccess() const;
     const std::string &getResponse() const;
+
+    static const char *typeToString(Type req);
+
+private:
+    void upload(const Endpoint &endpoint, Type req, const std::string &mimeParts);
 };
 
-#endif
\ No newline at end of file
+/**
+ * Per-bot set of Bot API endpoint URLs.
+ *
+ * Every method URL (`<base>/bot<token>/<method>`) is built once when the
+ * base URL or token changes, so issuing a request never concatenates URLs.
+ */
+class Endpoint
+{
+private:
+    std::string baseUrl;
+    std::string token;
+    std::string fileUrl;
+    std::vector<std::string> urls;
+
+public:
+    Endpoint();
+    Endpoint(const std::string &baseUrl, const std::string &token);
+    ~Endpoint();
+
+    void configure(const std::string &baseUrl, const std::string &token);
+
+    const std::string &getBaseUrl() const;
+    const std::string &getToken() const;
+    const std::string &getUrl(Request::Type req) const;
+    const std::string &getFileUrl() const;
+};
+
+#endif
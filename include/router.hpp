@@ -0,0 +1,75 @@
+#ifndef __ROUTER_HPP__
+#define __ROUTER_HPP__
+
+#include <cstdint>
+#include <functional>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "telegram.hpp"
+
+/**
+ * Update dispatcher for commands, callback data and text patterns.
+ *
+ * `/command` routes live in a hash table keyed by the lower-cased command,
+ * and callback-data prefixes in a trie where the longest registered prefix
+ * wins. Both lookups cost the length of the input, however many routes
+ * exist. Regex routes are tried in registration order after the command
+ * table, and the fallback gets whatever is left.
+ *
+ * Register every route before dispatching. After that `dispatch()` is
+ * read-only and can run on several threads at once.
+ */
+class Router
+{
+public:
+    typedef std::function<void(Telegram &, const Message &, const std::string &)> CommandHandler;
+    typedef std::function<void(Telegram &, const CallbackQuery &, const std::string &)> CallbackHandler;
+    typedef std::function<void(Telegram &, const Message &, const std::smatch &)> PatternHandler;
+    typedef std::function<void(Telegram &, const NodeMessage &)> FallbackHandler;
+
+    Router();
+    ~Router();
+
+    Router &command(const std::string &name, CommandHandler handler);
+    Router &callback(const std::string &prefix, CallbackHandler handler);
+    Router &pattern(const std::string &regex, PatternHandler handler);
+    Router &fallback(FallbackHandler handler);
+    void setUsername(const std::string &botUsername);
+
+    bool dispatch(Telegram &telegram, const NodeMessage &message) const;
+    std::function<void(Telegram &, const NodeMessage &)> handler() const;
+
+private:
+    class Trie
+    {
+    public:
+        Trie();
+        void insert(const std::string &key, std::size_t value);
+        bool longest(const std::string &input, std::size_t &value, std::size_t &length) const;
+
+    private:
+        class Node
+        {
+        public:
+            std::vector<std::pair<char, uint32_t>> next; // sorted by character
+            long value;
+        };
+        std::vector<Node> nodes;
+    };
+
+    std::unordered_map<std::string, CommandHandler> commands;
+    Trie prefixes;
+    std::vector<CallbackHandler> callbacks;
+    std::vector<std::pair<std::regex, PatternHandler>> patterns;
+    FallbackHandler fallbackHandler;
+    std::string username;
+
+    bool routeMessage(Telegram &telegram, const Message &message) const;
+    bool routeCallback(Telegram &telegram, const CallbackQuery &query) const;
+};
+
+#endif
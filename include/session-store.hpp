@@ -0,0 +1,77 @@
+#ifndef __SESSION_STORE_HPP__
+#define __SESSION_STORE_HPP__
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "type.hpp"
+#include "utils/include/nlohmann/json_fwd.hpp"
+
+/**
+ * Per-conversation state shared by update handlers.
+ *
+ * Sessions are keyed by chat id, or by chat id plus sender id, and hold a
+ * JSON value (an empty object for a session `update()` creates). Keys are
+ * spread over independently locked shards so handlers running on different
+ * workers rarely wait for each other. A session not
+ * touched for `ttlSeconds` is gone (0 keeps sessions forever); expired
+ * entries are dropped on access and by `expire()`.
+ *
+ * `snapshot()` writes every live session to a file (via a temporary file and
+ * rename) and `restore()` loads it back, keeping the remaining lifetime.
+ */
+class SessionStore
+{
+public:
+    enum class Scope : uint8_t
+    {
+        CHAT = 0,
+        CHAT_USER
+    };
+
+    SessionStore(Scope scope = Scope::CHAT, int ttlSeconds = 0, std::size_t shards = 64);
+    ~SessionStore();
+
+    bool get(long long chatId, long long userId, nlohmann::json &state) const;
+    void set(long long chatId, long long userId, const nlohmann::json &state);
+    void update(long long chatId, long long userId, const std::function<void(nlohmann::json &)> &fn);
+    bool erase(long long chatId, long long userId);
+
+    bool get(const Message &message, nlohmann::json &state) const;
+    void set(const Message &message, const nlohmann::json &state);
+    void update(const Message &message, const std::function<void(nlohmann::json &)> &fn);
+    bool erase(const Message &message);
+
+    std::size_t size() const;
+    std::size_t expire();
+    void clear();
+
+    bool snapshot(const std::string &path) const;
+    bool restore(const std::string &path);
+
+private:
+    typedef std::pair<long long, long long> Key;
+
+    class KeyHash
+    {
+    public:
+        std::size_t operator()(const Key &key) const;
+    };
+
+    class Entry;
+    class Shard;
+
+    Scope scope;
+    std::chrono::seconds ttl;
+    std::size_t shardMask;
+    std::unique_ptr<Shard[]> shards;
+
+    Key makeKey(long long chatId, long long userId) const;
+    Shard &shardFor(const Key &key) const;
+    bool expired(const Entry &entry, std::chrono::steady_clock::time_point now) const;
+};
+
+#endif
@@ -1,28 +1,41 @@
 #ifndef __TELEGRAM_API_HPP__
 #define __TELEGRAM_API_HPP__
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <deque>
+#include <map>
 #include <mutex>
+#include <condition_variable>
 #include <functional>
+#include <memory>
 
 #include "type.hpp"
 #include "node-message.hpp"
 #include "keyboard.hpp"
 #include "polling-controller.hpp"
 #include "webhook-server.hpp"
+#include "webhook-reply.hpp"
+#include "update-decoder.hpp"
+#include "request.hpp"
+#include "offset-store.hpp"
 
+#ifndef TELEGRAM_BASE_URL
 #define TELEGRAM_BASE_URL "https://api.telegram.org"
+#endif
 
 class Telegram
 {
 public:
     Telegram();
     Telegram(const std::string &token);
+    Telegram(const std::string &token, const std::string &baseUrl);
     ~Telegram();
 
     void setToken(const std::string &token);
+    void setBaseUrl(const std::string &baseUrl);
+    const std::string &getBaseUrl() const;
 
     long long getId() const;
     const std::string &getName() const;
@@ -32,19 +45,56 @@ public:
     void clearUpdates();
     bool getUpdates(std::function<void(Telegram &, const NodeMessage &)> handler);
     void getUpdatesPoll(std::function<void(Telegram &, const NodeMessage &)> handler);
+    void run(std::function<void(Telegram &, const NodeMessage &)> handler);
+    void runFor(int durationMs, std::function<void(Telegram &, const NodeMessage &)> handler);
+    void stop();
+    bool isRunning() const;
+    void setPipelining(bool enabled);
+    void setLongPollTimeout(int seconds);
+    void setMinPollInterval(int milliseconds);
+    void setOffsetStore(std::shared_ptr<OffsetStore> store);
+    void setCommitHold(std::function<long long()> hold);
+    void setUpdateFilter(const UpdateFilter &filter);
+    void setAllowedUpdates(const std::vector<std::string> &updates);
+    void setPollLimit(int minLimit, int maxLimit);
+    long long getCommittedUpdateId() const;
 
     bool apiGetMe();
     bool apiGetUpdates();
     bool apiSendMessage(long long targetId, const std::string &message);
+    bool apiSendMessage(long long targetId, const std::string &message, Message &result);
     bool apiEditMessageText(long long targetId, long long messageId, const std::string &message);
     bool apiSendChatAction(long long targetId, Chat::Action action);
+    bool apiCopyMessage(long long targetId, long long fromChatId, long long messageId);
+    bool apiCopyMessage(long long targetId, long long fromChatId, long long messageId, long long &resultId);
+    bool apiForwardMessage(long long targetId, long long fromChatId, long long messageId);
+    bool apiForwardMessage(long long targetId, long long fromChatId, long long messageId, Message &result);
+    bool apiCopyMessages(long long targetId, long long fromChatId, const std::vector<long long> &messageIds);
+    bool apiCopyMessages(long long targetId, long long fromChatId, const std::vector<long long> &messageIds, std::vector<long long> &resultIds);
+    bool apiForwardMessages(long long targetId, long long fromChatId, const std::vector<long long> &messageIds);
+    bool apiForwardMessages(long long targetId, long long fromChatId, const std::vector<long long> &messageIds, std::vector<long long> &resultIds);
+    bool apiDeleteMessage(long long chatId, long long messageId);
+    bool apiDeleteMessages(long long chatId, const std::vector<long long> &messageIds);
+    bool apiDeleteMessages(const std::map<long long, std::vector<long long>> &messagesByChat, std::size_t parallelism = 4);
 
     bool apiSendDocument(long long targetId, const std::string &label, const std::string &filePath);
+    bool apiSendDocument(long long targetId, const std::string &label, const std::string &filePath, Message &result);
     bool apiSendPhoto(long long targetId, const std::string &label, const std::string &filePath);
+    bool apiSendPhoto(long long targetId, const std::string &label, const std::string &filePath, Message &result);
     bool apiSendAudio(long long targetId, const std::string &label, const std::string &filePath);
+    bool apiSendAudio(long long targetId, const std::string &label, const std::string &filePath, Message &result);
     bool apiSendVoice(long long targetId, const std::string &label, const std::string &filePath);
+    bool apiSendVoice(long long targetId, const std::string &label, const std::string &filePath, Message &result);
     bool apiSendAnimation(long long targetId, const std::string &label, const std::string &filePath);
+    bool apiSendAnimation(long long targetId, const std::string &label, const std::string &filePath, Message &result);
     bool apiSendVideo(long long targetId, const std::string &label, const std::string &filePath);
+    bool apiSendVideo(long long targetId, const std::string &label, const std::string &filePath, Message &result);
+    bool apiSendMediaById(long long targetId, Media::Type type, const std::string &label, const std::string &fileId);
+    bool apiSendMediaById(long long targetId, Media::Type type, const std::string &label, const std::string &fileId, Message &result);
+    bool apiSendMediaByUrl(long long targetId, Media::Type type, const std::string &label, const std::string &url);
+    bool apiSendMediaByUrl(long long targetId, Media::Type type, const std::string &label, const std::string &url, Message &result);
+    bool apiSendMedia(long long targetId, const Media &media, const std::string &label);
+    bool apiSendMedia(long long targetId, const Media &media, const std::string &label, Message &result);
     std::string apiGetMediaPath(const std::string &fileId);
     std::vector<unsigned char> apiDownloadMediaById(const std::string &fileId);
     std::vector<unsigned char> apiDownloadMediaByPath(const std::string &mediaPath);
@@ -55,32 +105,74 @@ public:
     bool apiSetWebhook(const std::string &url);
     bool apiUnsetWebhook();
     void setWebhookCallback(std::function<void(Telegram &, const NodeMessage &)> handler);
+    void setWebhookReplyCallback(std::function<WebhookReply(Telegram &, const NodeMessage &)> handler);
+    bool hasWebhookReplyCallback() const;
+    void setWebhookConfig(const WebhookServer::Config &config);
     void execWebhookCallback();
+    WebhookReply execWebhookReply(const NodeMessage &message);
+    bool apiSendReply(const WebhookReply &reply);
     void servWebhook();
     void stopWebhook();
 
     bool apiSendKeyboard(long long targetId, const TKeyboard &keyboard);
+    bool apiSendKeyboard(long long targetId, const TKeyboard &keyboard, Message &result);
     bool apiEditInlineKeyboard(long long targetId, long long messageId, const TKeyboard &keyboard);
 
     bool parseGetUpdatesResponse(const std::string &buffer);
+    bool parseWebhookUpdate(const std::string &body);
+    bool parseWebhookUpdate(const std::string &body, NodeMessage &message);
 
 private:
+    friend class BotHost;
+
     long long id;
     long long lastUpdateId;
+    std::atomic<long long> committedUpdateId;
+    std::atomic<long long> handledUpdateId; // pipelining: last update the dispatcher has finished
     std::string name;
     std::string username;
-    std::string token;
 
+    Endpoint endpoint;
+
+    std::shared_ptr<OffsetStore> offsetStore;
+    std::function<long long()> commitHold;
     std::function<void(Telegram &, const NodeMessage &)> webhookCallback;
+    std::function<WebhookReply(Telegram &, const NodeMessage &)> webhookReplyCallback;
     std::deque<NodeMessage> messages;
+    UpdateDecoder decoder;
+    UpdateFilter filter;
+    std::vector<std::string> allowedUpdates;
+    bool hasAllowedUpdates;
 
     PollingController controller;
     WebhookServer server;
+    std::atomic<bool> running;
+    std::atomic<bool> stopRequested; // a stop() not yet seen by run()/runFor()
+    bool pipelining;
+    int longPollTimeout;
+    bool batchReady;
+    std::mutex pipelineMutex;
+    std::condition_variable pipelineSignal;
 
     mutable std::mutex mutex;
 
-    bool sendMediaImpl(long long targetId, Media::Type type, const std::string &label, const std::string &filePath);
+    bool sendMessageImpl(long long targetId, const std::string &message, Message *result);
+    bool sendKeyboardImpl(long long targetId, const TKeyboard &keyboard, Message *result);
+    bool sendMediaImpl(long long targetId, Media::Type type, const std::string &label, const std::string &filePath, Message *result);
+    bool sendMediaRefImpl(long long targetId, Media::Type type, const std::string &label, const std::string &ref, Message *result);
+    bool relayMessageImpl(Request::Type type, long long targetId, long long fromChatId, long long messageId, long long *resultId, Message *result);
+    bool messageBatchImpl(Request::Type type, long long chatId, const long long *fromChatId, const std::vector<long long> &messageIds, std::vector<long long> *resultIds);
+    void parseSentMessage(const std::string &buffer, Message &result) const;
     bool parseUpdatesUnlocked(const std::string &buffer);
+    bool queueUpdatesUnlocked(const std::string &buffer, bool dedupe, std::size_t &received);
+    bool pollOnce(const std::function<void(Telegram &, const NodeMessage &)> &handler);
+    bool beginRun();
+    void endRun();
+    void runPipelined(const std::function<void(Telegram &, const NodeMessage &)> &handler, const std::chrono::steady_clock::time_point *deadline);
+    void trackQueueDepth(long long delta) const;
+    void commitOffset(long long updateId);
+    long long nextOffset() const;
+    void runHandler(const std::function<void(Telegram &, const NodeMessage &)> &handler, const NodeMessage &message, bool fromWebhook);
 };
 
 #endif
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <memory>
 #include <functional>
 #include "utils/include/nlohmann/json_fwd.hpp"
+#include "json-reader.hpp"
 
 class User
 {
@@ -22,6 +23,7 @@ public:
     ~User();
     bool empty() const;
     bool parse(const nlohmann::json &json);
+    JSONReader::Status tryParse(const nlohmann::json &json);
     void reset();
 };
 
@@ -59,13 +61,14 @@ public:
     ~Chat();
     bool empty() const;
     bool parse(const nlohmann::json &json);
+    JSONReader::Status tryParse(const nlohmann::json &json);
     void reset();
 
     static const std::string &actionToString(const Chat::Action &action);
 
 private:
-    bool parsePrivateFields(const nlohmann::json &json);
-    bool parseGroupFields(const nlohmann::json &json);
+    JSONReader::Status parsePrivateFields(const nlohmann::json &json);
+    JSONReader::Status parseGroupFields(const nlohmann::json &json);
 };
 
 class Media
@@ -85,19 +88,43 @@ public:
         CONTACT = 0x09
     };
 
+    // one resolution of a photo (Telegram's PhotoSize)
+    class Size
+    {
+    public:
+        long long fileSize; // 0 when not reported
+        int width;
+        int height;
+        std::string fileId;
+        std::string fileUniqueId;
+
+        Size();
+        JSONReader::Status tryParse(const nlohmann::json &json);
+    };
+
     Type type;
     long long fileSize;
+    int width;
+    int height;
     std::string fileId;
     std::string fileUniqueId;
     std::string fileName;
+    std::vector<Size> sizes; // photo variants as sent, smallest first; the fields above hold the largest
 
     Media();
     ~Media();
     bool empty() const;
     bool parse(Type type, const nlohmann::json &json);
+    JSONReader::Status tryParse(Type type, const nlohmann::json &json);
+    JSONReader::Status tryParseSizes(Type type, const nlohmann::json &json);
     void reset();
     const std::string getType() const;
 
+    // takes the largest of `sizes` as the item itself, MISSING when there is none
+    JSONReader::Status useLargestSize();
+    // largest variant within both limits (0 means no limit), else the smallest
+    Size bestFor(long long maxBytes, int maxDimension = 0) const;
+
     static const std::string &typeToString(const Type &type);
     static void typeIteration(std::function<void(const Type &, const std::string &)> handler);
 };
@@ -110,6 +137,7 @@ public:
     long long threadId;
     std::string text;
     std::string caption;
+    std::string mediaGroupId; // shared by the messages of one album
     User from;
     Chat chat;
     std::vector<Media> media;
@@ -119,6 +147,7 @@ public:
     ~Message();
     bool empty() const;
     bool parse(const nlohmann::json &json);
+    JSONReader::Status tryParse(const nlohmann::json &json);
     void reset();
 };
 
@@ -135,6 +164,7 @@ public:
     ~CallbackQuery();
     bool empty() const;
     bool parse(const nlohmann::json &json);
+    JSONReader::Status tryParse(const nlohmann::json &json);
     void reset();
 };
 
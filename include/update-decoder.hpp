@@ -0,0 +1,68 @@
+#ifndef __UPDATE_DECODER_HPP__
+#define __UPDATE_DECODER_HPP__
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "type.hpp"
+#include "node-message.hpp"
+#include "json-reader.hpp"
+#include "update-filter.hpp"
+
+/**
+ * Turns raw Bot API payloads (getUpdates responses, webhook bodies and
+ * method results) into the library's types without exceptions.
+ *
+ * The nlohmann::json backend is always built. Configuring the library with
+ * TESSERGRAM_SIMDJSON adds simdjson's on-demand backend, which reads fields
+ * straight from the buffer without building a DOM, and makes it the default.
+ * Both backends accept and reject the same payloads.
+ */
+class UpdateDecoder
+{
+public:
+    enum class Backend : uint8_t
+    {
+        NLOHMANN = 0,
+        SIMDJSON
+    };
+
+    // asked for a slot before the update is parsed; nullptr skips it
+    typedef std::function<NodeMessage *(const UpdateFilter::Scan &scan)> Slot;
+    // reports how the slot handed out last was filled
+    typedef std::function<void(NodeMessage &message, JSONReader::Status status)> Done;
+
+    static const Backend DEFAULT;
+
+    explicit UpdateDecoder(Backend backend = DEFAULT);
+    ~UpdateDecoder();
+
+    Backend getBackend() const;
+
+    /**
+     * A getUpdates response, or a webhook body holding a single Update. The
+     * slot's scan carries only the update id unless `summarize` is set.
+     */
+    JSONReader::Status decodeUpdates(const std::string &buffer, const Slot &slot, const Done &done, bool summarize = false) const;
+    JSONReader::Status decodeUpdate(const std::string &body, NodeMessage &message) const;
+    /** A response whose "result" is a Message, e.g. from sendMessage. */
+    JSONReader::Status decodeResult(const std::string &buffer, Message &message) const;
+    /** A response whose "result" is a User, i.e. from getMe. */
+    JSONReader::Status decodeResult(const std::string &buffer, User &user) const;
+    /** One string field of the "result" object, e.g. getFile's file_path. */
+    JSONReader::Status decodeResult(const std::string &buffer, const char *key, std::string &out) const;
+    /** One integer field of the "result" object, e.g. copyMessage's message_id. */
+    JSONReader::Status decodeResult(const std::string &buffer, const char *key, long long &out) const;
+    /** That field of every object in the "result" array, e.g. copyMessages' ids. */
+    JSONReader::Status decodeResult(const std::string &buffer, const char *key, std::vector<long long> &out) const;
+
+    static bool available(Backend backend);
+    static const char *backendToString(Backend backend);
+
+private:
+    Backend backend;
+
+    static void bind(NodeMessage &node, long long *&updateId, Message *&message, CallbackQuery *&callbackQuery);
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef __UPDATE_FILTER_HPP__
+#define __UPDATE_FILTER_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "type.hpp"
+
+/**
+ * Prefilter applied to the raw update before it is parsed.
+ *
+ * The decoder fills a `Scan` with the update kind, the chat and the text
+ * (message text or callback data) and nothing else; updates the filter
+ * rejects are acknowledged but never materialized. Each criterion left
+ * unset accepts everything, set ones must all match.
+ */
+class UpdateFilter
+{
+public:
+    enum class Kind : uint8_t
+    {
+        MESSAGE = 0,
+        CALLBACK_QUERY,
+        OTHER
+    };
+
+    class Scan
+    {
+    public:
+        long long updateId;
+        Kind kind;
+        bool hasChat;
+        Chat::Type chatType;
+        long long chatId;
+        const char *text; // points into the raw buffer, valid during the call only
+        std::size_t textLength;
+
+        Scan();
+    };
+
+    UpdateFilter();
+    ~UpdateFilter();
+
+    UpdateFilter &kind(Kind kind);
+    UpdateFilter &chatType(Chat::Type type);
+    UpdateFilter &chat(long long chatId);
+    UpdateFilter &textPrefix(const std::string &prefix);
+
+    bool empty() const;
+    bool accept(const Scan &scan) const;
+
+private:
+    uint8_t kinds;     // bit per Kind
+    uint8_t chatTypes; // bit per Chat::Type
+    std::unordered_set<long long> chats;
+    std::vector<std::string> prefixes;
+};
+
+#endif
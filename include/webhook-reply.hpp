@@ -0,0 +1,39 @@
+#ifndef __WEBHOOK_REPLY_HPP__
+#define __WEBHOOK_REPLY_HPP__
+
+#include <string>
+
+#include "type.hpp"
+#include "request.hpp"
+
+/**
+ * One Bot API call a webhook handler wants to make in reply to an update.
+ *
+ * Telegram accepts a single method call in the body of the webhook
+ * response, which saves a separate outbound request. When the reply is not
+ * ready before the server's deadline it is sent as a normal request instead.
+ * A default constructed reply is empty and means "nothing to send".
+ */
+class WebhookReply
+{
+public:
+    WebhookReply();
+    ~WebhookReply();
+
+    static WebhookReply sendMessage(long long chatId, const std::string &text);
+    static WebhookReply sendChatAction(long long chatId, Chat::Action action);
+    static WebhookReply editMessageText(long long chatId, long long messageId, const std::string &text);
+
+    bool empty() const;
+    Request::Type getType() const;
+    const std::string &getParams() const;
+    std::string toResponseBody() const;
+
+private:
+    Request::Type type;
+    std::string params; // JSON object, without "method"
+
+    WebhookReply(Request::Type type, const std::string &params);
+};
+
+#endif
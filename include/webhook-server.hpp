@@ -5,18 +5,64 @@
 #include <string>
 
 class Telegram;
+struct mg_connection;
+struct mg_http_message;
 
+/**
+ * HTTP listener for webhook deliveries.
+ *
+ * Connections are kept alive between deliveries. The event loop only parses
+ * and acknowledges; handlers run on a separate dispatcher thread in arrival
+ * order, so a slow handler does not stall the other connections.
+ *
+ * With a reply callback set, the response to a delivery is held until the
+ * handler returns, so its `WebhookReply` can travel in the response body.
+ * After `replyDeadlineMs` the delivery is acknowledged with a plain 200 and
+ * the reply goes out as a normal request.
+ *
+ * `GET /metrics` is off by default; setting `metricsToken` turns it on for
+ * scrapers that present the token.
+ */
 class WebhookServer
 {
 public:
+    class Config
+    {
+    public:
+        std::string listenAddress;
+        std::size_t maxConnections; // match max_connections given to setWebhook
+        std::size_t maxBodySize;    // larger deliveries get 413
+        int readTimeoutMs;          // idle keep-alive connections are closed after this
+        int backlog;                // listen() queue length, 0 keeps the mongoose default
+        int replyDeadlineMs;        // inline replies not ready by then are sent as separate requests
+        std::string metricsToken;   // non-empty: GET /metrics is served to "Authorization: Bearer <token>"
+
+        Config();
+    };
+
     WebhookServer();
     ~WebhookServer();
 
+    void configure(const Config &config);
+    const Config &getConfig() const;
+
+    void run(Telegram *tg);
     void run(const std::string &listenAddr, Telegram *tg);
     void stop();
+    std::size_t getConnectionCount() const;
+    int getPort() const; // bound port while running, 0 otherwise
+
+    static bool admit(struct mg_connection *c, int ev, void *ev_data, const Config &config, std::atomic<std::size_t> &connections);
+    static bool serveMetrics(struct mg_connection *c, struct mg_http_message *hm, const Config &config);
 
 private:
+    Config config;
     std::atomic<bool> running;
+    std::atomic<std::size_t> connections;
+    std::atomic<int> port;
+
+    static void onHttp(struct mg_connection *c, int ev, void *ev_data);
+    static void dispatchInline(void *context, struct mg_connection *c, struct mg_http_message *hm);
 };
 
 #endif
@@ -0,0 +1,41 @@
+#ifndef __WORKER_POOL_HPP__
+#define __WORKER_POOL_HPP__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of threads draining a FIFO job queue.
+ *
+ * A job that throws is logged and dropped; the worker keeps running.
+ * `shutdown()` (also run by the destructor) finishes the queued jobs and
+ * joins the threads.
+ */
+class WorkerPool
+{
+public:
+    explicit WorkerPool(std::size_t threads);
+    ~WorkerPool();
+
+    void submit(std::function<void()> job);
+    void shutdown();
+
+    std::size_t size() const;
+    std::size_t pending() const;
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    bool stopping;
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+
+    void work();
+};
+
+#endif
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <stdexcept>
+#include <sys/socket.h>
+#include "bot-host.hpp"
+#include "metrics.hpp"
+#include "log.hpp"
+#include "utils/include/error.hpp"
+
+extern "C"
+{
+#include "mongoose.h"
+}
+
+namespace
+{
+    // upper bound on how long the loop sleeps, so stop() and newly due polls
+    // are noticed promptly
+    const int MAX_WAIT_MS = 50;
+}
+
+BotHost::BotHost(std::size_t workers)
+    : bots(), byPath(), bySecret(), webhookConfig(), connections(0), running(false), mutex(), idle(), workers(workers)
+{
+    // no listener until listen() is called: a host may only poll
+    this->webhookConfig.listenAddress.clear();
+}
+
+BotHost::~BotHost()
+{
+    this->stop();
+}
+
+BotHost::Bot &BotHost::add(const std::string &token, std::function<void(Telegram &, const NodeMessage &)> handler)
+{
+    if (token.empty() || !handler)
+        throw std::runtime_error(Error::common(__FILE__, __LINE__, __func__, "invalid input"));
+
+    this->bots.emplace_back();
+    Bot &bot = this->bots.back();
+    bot.telegram.reset(new Telegram(token));
+    bot.handler = handler;
+    bot.polling = false;
+    bot.busy = false;
+    bot.webhookPending = false;
+    return bot;
+}
+
+Telegram &BotHost::addPolling(const std::string &token, std::function<void(Telegram &, const NodeMessage &)> handler)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    Bot &bot = this->add(token, handler);
+    bot.polling = true;
+    return *bot.telegram;
+}
+
+Telegram &BotHost::addWebhook(const std::string &token, const std::string &path, const std::string &secretToken, std::function<void(Telegram &, const NodeMessage &)> handler)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    if ((path.empty() && secretToken.empty()) || this->byPath.count(path) || this->bySecret.count(secretToken))
+        throw std::runtime_error(Error::common(__FILE__, __LINE__, __func__, "invalid input"));
+
+    Bot &bot = this->add(token, handler);
+    bot.secretToken = secretToken;
+    bot.telegram->setWebhookCallback(handler);
+
+    std::size_t index = this->bots.size() - 1;
+    if (!path.empty())
+        this->byPath[path] = index;
+    if (!secretToken.empty())
+        this->bySecret[secretToken] = index;
+    return *bot.telegram;
+}
+
+void BotHost::listen(const std::string &address)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->webhookConfig.listenAddress = address;
+}
+
+void BotHost::listen(const WebhookServer::Config &config)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->webhookConfig = config;
+}
+
+void BotHost::run()
+{
+    struct mg_mgr mgr;
+    mg_mgr_init(&mgr);
+    std::string address;
+    int backlog = 0;
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        address = this->webhookConfig.listenAddress;
+        backlog = this->webhookConfig.backlog;
+    }
+    if (!address.empty())
+    {
+        struct mg_connection *listener = mg_http_listen(&mgr, address.c_str(), BotHost::onHttp, this);
+        if (listener == NULL)
+            TG_LOG(Log::ERROR, "listen on %s failed!\n", address.c_str());
+        else if (backlog > 0)
+            ::listen(static_cast<int>(reinterpret_cast<size_t>(listener->fd)), backlog);
+    }
+
+    this->running = true;
+    while (this->running)
+    {
+        mg_mgr_poll(&mgr, this->schedule());
+    }
+    mg_mgr_free(&mgr);
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->idle.wait(lock,
+                    [this]()
+                    {
+                        return std::none_of(this->bots.begin(), this->bots.end(),
+                                            [](const Bot &bot)
+                                            { return bot.busy; });
+                    });
+    for (Bot &bot : this->bots)
+    {
+        if (bot.telegram->offsetStore)
+            bot.telegram->offsetStore->flush();
+    }
+}
+
+void BotHost::stop()
+{
+    this->running = false;
+}
+
+bool BotHost::isRunning() const
+{
+    return this->running;
+}
+
+std::size_t BotHost::size() const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    return this->bots.size();
+}
+
+Telegram *BotHost::route(const std::string &path, const std::string &secretToken) const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    long index = this->routeUnlocked(path, secretToken);
+    return index < 0 ? nullptr : this->bots[static_cast<std::size_t>(index)].telegram.get();
+}
+
+long BotHost::routeUnlocked(const std::string &path, const std::string &secretToken) const
+{
+    std::unordered_map<std::string, std::size_t>::const_iterator it = this->byPath.find(path);
+    if (it != this->byPath.end())
+    {
+        // a bot registered with a secret only accepts deliveries carrying it
+        const Bot &bot = this->bots[it->second];
+        if (!bot.secretToken.empty() && bot.secretToken != secretToken)
+            return -1;
+        return static_cast<long>(it->second);
+    }
+    if (secretToken.empty())
+        return -1;
+    it = this->bySecret.find(secretToken);
+    return it == this->bySecret.end() ? -1 : static_cast<long>(it->second);
+}
+
+int BotHost::schedule()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point wakeAt = now + std::chrono::milliseconds(MAX_WAIT_MS);
+
+    std::lock_guard<std::mutex> guard(this->mutex);
+    for (Bot &bot : this->bots)
+    {
+        if (bot.busy)
+            continue;
+        if (bot.webhookPending)
+        {
+            bot.busy = true;
+            bot.webhookPending = false;
+            this->workers.submit(
+                [this, &bot]()
+                {
+                    try
+                    {
+                        bot.telegram->execWebhookCallback();
+                    }
+                    catch (const std::exception &e)
+                    {
+                        TG_LOG(Log::ERROR, "handler failed: %s!\n", e.what());
+                    }
+                    this->release(bot);
+                });
+            continue;
+        }
+        if (!bot.polling)
+            continue;
+
+        std::chrono::steady_clock::time_point due = bot.telegram->controller.getNextPollTime();
+        if (due > now)
+        {
+            wakeAt = std::min(wakeAt, due);
+            continue;
+        }
+        bot.busy = true;
+        this->workers.submit(
+            [this, &bot]()
+            {
+                try
+                {
+                    Telegram &telegram = *bot.telegram;
+                    telegram.controller.runIfDue(
+                        [&]()
+                        {
+                            return telegram.pollOnce(bot.handler);
+                        });
+                }
+                catch (const std::exception &e)
+                {
+                    TG_LOG(Log::ERROR, "handler failed: %s!\n", e.what());
+                }
+                this->release(bot);
+            });
+    }
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(wakeAt - now).count());
+}
+
+void BotHost::release(Bot &bot)
+{
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        bot.busy = false;
+    }
+    this->idle.notify_all();
+}
+
+void BotHost::onHttp(struct mg_connection *c, int ev, void *ev_data)
+{
+    BotHost *host = static_cast<BotHost *>(c->fn_data);
+    // the configuration is only replaced before run(), so no lock is needed here
+    if (!WebhookServer::admit(c, ev, ev_data, host->webhookConfig, host->connections))
+        return;
+
+    static Metrics::Counter &requests = Metrics::global().counter("tessergram_webhook_requests_total", "", "Webhook deliveries received");
+    static Metrics::Counter &unrouted = Metrics::global().counter("tessergram_webhook_unrouted_total", "", "Webhook deliveries that matched no hosted bot");
+
+    struct mg_http_message *hm = static_cast<struct mg_http_message *>(ev_data);
+    if (WebhookServer::serveMetrics(c, hm, host->webhookConfig))
+        return;
+
+    std::string path(hm->uri.buf, hm->uri.len);
+    std::string secretToken;
+    struct mg_str *header = mg_http_get_header(hm, "X-Telegram-Bot-Api-Secret-Token");
+    if (header != NULL)
+        secretToken.assign(header->buf, header->len);
+
+    Bot *bot = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(host->mutex);
+        long index = host->routeUnlocked(path, secretToken);
+        if (index >= 0)
+            bot = &host->bots[static_cast<std::size_t>(index)];
+    }
+    if (bot == nullptr)
+    {
+        unrouted.add();
+        mg_http_reply(c, 404, "", "");
+        return;
+    }
+
+    requests.add();
+    bool queued = bot->telegram->parseWebhookUpdate(std::string(hm->body.buf, hm->body.len));
+
+    mg_http_reply(c, 200,
+                  "Content-Type: application/json\r\n",
+                  "{%m:%m,%m:{%m:%m}}",
+                  MG_ESC("status"), MG_ESC("success"),
+                  MG_ESC("data"), MG_ESC("message"), MG_ESC("message received"));
+
+    if (queued)
+    {
+        // handlers run on the worker pool once the bot is not busy
+        std::lock_guard<std::mutex> guard(host->mutex);
+        bot->webhookPending = true;
+    }
+}
@@ -0,0 +1,96 @@
+#include <cerrno>
+#include <cstdlib>
+#include "json-reader.hpp"
+#include "nlohmann/json.hpp"
+
+const char *JSONReader::statusToString(Status status)
+{
+    switch (status)
+    {
+    case Status::OK:
+        return "ok";
+    case Status::MALFORMED:
+        return "malformed json";
+    case Status::MISSING:
+        return "missing field";
+    case Status::WRONG_TYPE:
+        return "wrong field type";
+    case Status::UNKNOWN_KIND:
+        return "unknown update kind";
+    }
+    return "unknown";
+}
+
+bool JSONReader::parse(const std::string &text, nlohmann::json &out)
+{
+    out = nlohmann::json::parse(text, nullptr, false);
+    return !out.is_discarded();
+}
+
+const nlohmann::json *JSONReader::find(const nlohmann::json &json, const char *key)
+{
+    if (!json.is_object())
+        return nullptr;
+    nlohmann::json::const_iterator it = json.find(key);
+    return it != json.end() ? &*it : nullptr;
+}
+
+const nlohmann::json *JSONReader::object(const nlohmann::json &json, const char *key)
+{
+    const nlohmann::json *value = JSONReader::find(json, key);
+    return value != nullptr && value->is_object() ? value : nullptr;
+}
+
+const nlohmann::json *JSONReader::array(const nlohmann::json &json, const char *key)
+{
+    const nlohmann::json *value = JSONReader::find(json, key);
+    return value != nullptr && value->is_array() ? value : nullptr;
+}
+
+JSONReader::Status JSONReader::get(const nlohmann::json &json, const char *key, long long &out)
+{
+    const nlohmann::json *value = JSONReader::find(json, key);
+    if (value == nullptr)
+        return Status::MISSING;
+    if (value->is_number_integer())
+    {
+        out = value->get<long long>();
+        return Status::OK;
+    }
+    // some fields (callback query ids, file sizes) may arrive as numeric strings
+    if (value->is_string())
+    {
+        const std::string &text = value->get_ref<const std::string &>();
+        char *end = nullptr;
+        errno = 0;
+        long long parsed = std::strtoll(text.c_str(), &end, 10);
+        if (!text.empty() && *end == '\0' && errno == 0)
+        {
+            out = parsed;
+            return Status::OK;
+        }
+    }
+    return Status::WRONG_TYPE;
+}
+
+JSONReader::Status JSONReader::get(const nlohmann::json &json, const char *key, std::string &out)
+{
+    const nlohmann::json *value = JSONReader::find(json, key);
+    if (value == nullptr)
+        return Status::MISSING;
+    if (!value->is_string())
+        return Status::WRONG_TYPE;
+    out = value->get_ref<const std::string &>();
+    return Status::OK;
+}
+
+JSONReader::Status JSONReader::get(const nlohmann::json &json, const char *key, bool &out)
+{
+    const nlohmann::json *value = JSONReader::find(json, key);
+    if (value == nullptr)
+        return Status::MISSING;
+    if (!value->is_boolean())
+        return Status::WRONG_TYPE;
+    out = value->get<bool>();
+    return Status::OK;
+}
@@ -0,0 +1,203 @@
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include "json-writer.hpp"
+#include "utils/include/error.hpp"
+
+JSONWriter::JSONWriter() : buffer(), populated(0), depth(0), afterKey(false)
+{
+    this->buffer.reserve(256);
+}
+
+JSONWriter::~JSONWriter()
+{
+}
+
+JSONWriter &JSONWriter::local()
+{
+    static thread_local JSONWriter writer;
+    return writer.clear();
+}
+
+JSONWriter &JSONWriter::clear()
+{
+    this->buffer.clear();
+    this->populated = 0;
+    this->depth = 0;
+    this->afterKey = false;
+    return *this;
+}
+
+void JSONWriter::separate()
+{
+    if (this->afterKey)
+    {
+        this->afterKey = false;
+        return;
+    }
+    if (this->depth == 0)
+        return;
+
+    uint64_t bit = 1ULL << (this->depth - 1);
+    if (this->populated & bit)
+        this->buffer.push_back(',');
+    else
+        this->populated |= bit;
+}
+
+void JSONWriter::open(char bracket)
+{
+    if (this->depth >= MAX_DEPTH)
+        throw std::runtime_error(Error::common(__FILE__, __LINE__, __func__, "nesting too deep"));
+    this->separate();
+    this->buffer.push_back(bracket);
+    this->depth++;
+    this->populated &= ~(1ULL << (this->depth - 1));
+}
+
+void JSONWriter::close(char bracket)
+{
+    if (this->depth == 0)
+        throw std::runtime_error(Error::common(__FILE__, __LINE__, __func__, "unbalanced container"));
+    this->buffer.push_back(bracket);
+    this->depth--;
+}
+
+JSONWriter &JSONWriter::beginObject()
+{
+    this->open('{');
+    return *this;
+}
+
+JSONWriter &JSONWriter::endObject()
+{
+    this->close('}');
+    return *this;
+}
+
+JSONWriter &JSONWriter::beginArray()
+{
+    this->open('[');
+    return *this;
+}
+
+JSONWriter &JSONWriter::endArray()
+{
+    this->close(']');
+    return *this;
+}
+
+void JSONWriter::appendEscaped(const char *str, std::size_t length)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    this->buffer.push_back('"');
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < length; i++)
+    {
+        unsigned char c = static_cast<unsigned char>(str[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+
+        this->buffer.append(str + start, i - start);
+        start = i + 1;
+        switch (c)
+        {
+        case '"':
+            this->buffer.append("\\\"", 2);
+            break;
+        case '\\':
+            this->buffer.append("\\\\", 2);
+            break;
+        case '\b':
+            this->buffer.append("\\b", 2);
+            break;
+        case '\f':
+            this->buffer.append("\\f", 2);
+            break;
+        case '\n':
+            this->buffer.append("\\n", 2);
+            break;
+        case '\r':
+            this->buffer.append("\\r", 2);
+            break;
+        case '\t':
+            this->buffer.append("\\t", 2);
+            break;
+        default:
+        {
+            char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F]};
+            this->buffer.append(esc, sizeof(esc));
+            break;
+        }
+        }
+    }
+    this->buffer.append(str + start, length - start);
+    this->buffer.push_back('"');
+}
+
+JSONWriter &JSONWriter::key(const char *name)
+{
+    this->separate();
+    this->appendEscaped(name, std::strlen(name));
+    this->buffer.push_back(':');
+    this->afterKey = true;
+    return *this;
+}
+
+JSONWriter &JSONWriter::key(const std::string &name)
+{
+    this->separate();
+    this->appendEscaped(name.data(), name.length());
+    this->buffer.push_back(':');
+    this->afterKey = true;
+    return *this;
+}
+
+JSONWriter &JSONWriter::value(const char *val)
+{
+    this->separate();
+    this->appendEscaped(val, std::strlen(val));
+    return *this;
+}
+
+JSONWriter &JSONWriter::value(const std::string &val)
+{
+    this->separate();
+    this->appendEscaped(val.data(), val.length());
+    return *this;
+}
+
+JSONWriter &JSONWriter::value(long long val)
+{
+    char num[24];
+    int length = snprintf(num, sizeof(num), "%lld", val);
+    this->separate();
+    this->buffer.append(num, static_cast<std::size_t>(length));
+    return *this;
+}
+
+JSONWriter &JSONWriter::value(int val)
+{
+    return this->value(static_cast<long long>(val));
+}
+
+JSONWriter &JSONWriter::value(bool val)
+{
+    this->separate();
+    if (val)
+        this->buffer.append("true", 4);
+    else
+        this->buffer.append("false", 5);
+    return *this;
+}
+
+const std::string &JSONWriter::str() const
+{
+    return this->buffer;
+}
+
+bool JSONWriter::empty() const
+{
+    return this->buffer.empty();
+}
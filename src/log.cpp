@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include "log.hpp"
+#include "utils/include/debug.hpp"
+
+namespace
+{
+    const std::size_t RING_CAPACITY = 256;
+    const std::size_t SLOT_TEXT_SIZE = 512;
+
+    struct Record
+    {
+        std::atomic<std::size_t> sequence;
+        Log::Level level;
+        bool isPayload;
+        int line;
+        const char *file;
+        const char *func;
+        const char *label;
+        std::size_t total;
+        std::size_t length;
+        char text[SLOT_TEXT_SIZE];
+    };
+
+    /**
+     * Bounded multi-producer / single-consumer ring (Vyukov sequence scheme).
+     * Producers never block: when the ring is full the record is dropped.
+     */
+    class Ring
+    {
+    public:
+        Ring() : head(0), tail(0)
+        {
+            for (std::size_t i = 0; i < RING_CAPACITY; i++)
+                this->slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        Record *claim()
+        {
+            std::size_t pos = this->tail.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Record &slot = this->slots[pos & (RING_CAPACITY - 1)];
+                std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+                long long diff = static_cast<long long>(seq) - static_cast<long long>(pos);
+                if (diff == 0)
+                {
+                    if (this->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        return &slot;
+                }
+                else if (diff < 0)
+                {
+                    return nullptr;
+                }
+                else
+                {
+                    pos = this->tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void publish(Record *slot)
+        {
+            std::size_t pos = slot->sequence.load(std::memory_order_relaxed);
+            slot->sequence.store(pos + 1, std::memory_order_release);
+        }
+
+        Record *peek()
+        {
+            Record &slot = this->slots[this->head & (RING_CAPACITY - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != this->head + 1)
+                return nullptr;
+            return &slot;
+        }
+
+        void consume(Record *slot)
+        {
+            slot->sequence.store(this->head + RING_CAPACITY, std::memory_order_release);
+            this->head++;
+        }
+
+    private:
+        Record slots[RING_CAPACITY];
+        std::size_t head;
+        std::atomic<std::size_t> tail;
+    };
+
+    static_assert((RING_CAPACITY & (RING_CAPACITY - 1)) == 0, "RING_CAPACITY must be a power of two");
+
+    std::atomic<int> runtimeLevel(TESSERGRAM_LOG_LEVEL);
+    std::atomic<unsigned int> payloadEvery(1);
+    std::atomic<std::size_t> payloadLimit(1024);
+    std::atomic<unsigned int> payloadCounter(0);
+    std::atomic<unsigned long long> droppedCount(0);
+    std::atomic<bool> asyncEnabled(false);
+
+    std::mutex workerMutex;
+    std::condition_variable workerWake;
+    std::thread worker;
+    bool workerStop = false;
+
+    Ring &ring()
+    {
+        static Ring instance;
+        return instance;
+    }
+
+    typedef decltype(Debug::INFO) DebugLevel;
+
+    DebugLevel toDebugLevel(Log::Level level)
+    {
+        switch (level)
+        {
+        case Log::WARNING:
+            return Debug::WARNING;
+        case Log::ERROR:
+            return Debug::ERROR;
+        default:
+            return Debug::INFO;
+        }
+    }
+
+    void emitPayload(Log::Level level, const char *file, int line, const char *func, const char *label, const char *data, std::size_t length, std::size_t total)
+    {
+        if (length < total)
+            Debug::log(toDebugLevel(level), file, line, func, "%s: %.*s... (%zu bytes)\n", label, static_cast<int>(length), data, total);
+        else
+            Debug::log(toDebugLevel(level), file, line, func, "%s: %.*s\n", label, static_cast<int>(length), data);
+    }
+
+    void drain()
+    {
+        Ring &r = ring();
+        Record *rec;
+        while ((rec = r.peek()) != nullptr)
+        {
+            // a level raised since the record was queued still applies
+            if (Log::enabled(rec->level))
+            {
+                if (rec->isPayload)
+                    emitPayload(rec->level, rec->file, rec->line, rec->func, rec->label, rec->text, rec->length, rec->total);
+                else
+                    Debug::log(toDebugLevel(rec->level), rec->file, rec->line, rec->func, "%s", rec->text);
+            }
+            r.consume(rec);
+        }
+    }
+
+    void workerLoop()
+    {
+        unsigned long long reported = 0;
+        std::unique_lock<std::mutex> lock(workerMutex);
+        while (!workerStop)
+        {
+            workerWake.wait_for(lock, std::chrono::milliseconds(50));
+            lock.unlock();
+            drain();
+            unsigned long long lost = droppedCount.load(std::memory_order_relaxed);
+            if (lost != reported)
+            {
+                Debug::log(Debug::WARNING, __FILE__, __LINE__, __func__, "log ring full: %llu records dropped\n", lost - reported);
+                reported = lost;
+            }
+            lock.lock();
+        }
+        lock.unlock();
+        drain();
+    }
+}
+
+bool Log::enabled(Log::Level level)
+{
+    return static_cast<int>(level) >= runtimeLevel.load(std::memory_order_relaxed);
+}
+
+void Log::setLevel(Log::Level level)
+{
+    runtimeLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+Log::Level Log::getLevel()
+{
+    return static_cast<Log::Level>(runtimeLevel.load(std::memory_order_relaxed));
+}
+
+void Log::setPayloadSampling(unsigned int every)
+{
+    payloadEvery.store(every, std::memory_order_relaxed);
+}
+
+void Log::setPayloadLimit(std::size_t bytes)
+{
+    payloadLimit.store(bytes, std::memory_order_relaxed);
+}
+
+void Log::startAsync()
+{
+    std::lock_guard<std::mutex> guard(workerMutex);
+    if (worker.joinable())
+        return;
+    ring();
+    workerStop = false;
+    worker = std::thread(workerLoop);
+    asyncEnabled.store(true, std::memory_order_release);
+}
+
+void Log::stopAsync()
+{
+    std::thread stopped;
+    {
+        std::lock_guard<std::mutex> guard(workerMutex);
+        if (!worker.joinable())
+            return;
+        asyncEnabled.store(false, std::memory_order_release);
+        workerStop = true;
+        stopped.swap(worker);
+    }
+    workerWake.notify_one();
+    stopped.join();
+}
+
+bool Log::isAsync()
+{
+    return asyncEnabled.load(std::memory_order_acquire);
+}
+
+unsigned long long Log::dropped()
+{
+    return droppedCount.load(std::memory_order_relaxed);
+}
+
+void Log::write(Log::Level level, const char *file, int line, const char *func, const char *fmt, ...)
+{
+    va_list args;
+    if (asyncEnabled.load(std::memory_order_acquire))
+    {
+        Record *rec = ring().claim();
+        if (rec == nullptr)
+        {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        rec->level = level;
+        rec->isPayload = false;
+        rec->file = file;
+        rec->line = line;
+        rec->func = func;
+        va_start(args, fmt);
+        vsnprintf(rec->text, sizeof(rec->text), fmt, args);
+        va_end(args);
+        ring().publish(rec);
+        return;
+    }
+
+    // only the async slot is bounded; a longer message is formatted again in full
+    char text[SLOT_TEXT_SIZE];
+    va_start(args, fmt);
+    int length = vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    if (length < static_cast<int>(sizeof(text)))
+    {
+        Debug::log(toDebugLevel(level), file, line, func, "%s", text);
+        return;
+    }
+    std::string full(static_cast<std::size_t>(length) + 1, '\0');
+    va_start(args, fmt);
+    vsnprintf(&full[0], full.size(), fmt, args);
+    va_end(args);
+    Debug::log(toDebugLevel(level), file, line, func, "%s", full.c_str());
+}
+
+void Log::payload(Log::Level level, const char *file, int line, const char *func, const char *label, const std::string &data)
+{
+    unsigned int every = payloadEvery.load(std::memory_order_relaxed);
+    if (every == 0)
+        return;
+    if (every > 1 && payloadCounter.fetch_add(1, std::memory_order_relaxed) % every != 0)
+        return;
+
+    std::size_t length = std::min(data.length(), payloadLimit.load(std::memory_order_relaxed));
+
+    if (asyncEnabled.load(std::memory_order_acquire))
+    {
+        Record *rec = ring().claim();
+        if (rec == nullptr)
+        {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        length = std::min(length, sizeof(rec->text));
+        rec->level = level;
+        rec->isPayload = true;
+        rec->file = file;
+        rec->line = line;
+        rec->func = func;
+        rec->label = label;
+        rec->total = data.length();
+        rec->length = length;
+        std::memcpy(rec->text, data.data(), length);
+        ring().publish(rec);
+        return;
+    }
+
+    emitPayload(level, file, line, func, label, data.data(), length, data.length());
+}
\ No newline at end of file
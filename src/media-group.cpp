@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <stdexcept>
+#include "media-group.hpp"
+#include "metrics.hpp"
+#include "log.hpp"
+
+const std::size_t MediaGroupAggregator::MAX_GROUP_SIZE;
+
+MediaGroup::MediaGroup() : id(), chat(), from(), caption(), media(), messageIds(), dtime(0) {}
+
+MediaGroupAggregator::Pending::Pending() : telegram(nullptr), group(), parts(), firstUpdateId(0), deadline() {}
+
+MediaGroupAggregator::MediaGroupAggregator(int windowMs)
+    : window(std::max(1, windowMs)), groupHandler(nullptr), groups(), stopping(false), mutex(), changed(), timer()
+{
+    this->timer = std::thread(&MediaGroupAggregator::run, this);
+}
+
+MediaGroupAggregator::~MediaGroupAggregator()
+{
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        this->stopping = true;
+    }
+    this->changed.notify_all();
+    if (this->timer.joinable())
+        this->timer.join();
+    this->flush();
+}
+
+MediaGroupAggregator &MediaGroupAggregator::onGroup(GroupHandler handler)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->groupHandler = std::move(handler);
+    return *this;
+}
+
+MediaGroupAggregator::Handler MediaGroupAggregator::handler(Handler next)
+{
+    return [this, next](Telegram &telegram, const NodeMessage &update)
+    {
+        bool buffered = false;
+        update.processMessage([&](const Message &message)
+                              { buffered = this->add(telegram, update.getId(), message); });
+        if (!buffered && next)
+            next(telegram, update);
+    };
+}
+
+void MediaGroupAggregator::flush()
+{
+    std::vector<Pending> ready;
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        ready.reserve(this->groups.size());
+        for (auto &entry : this->groups)
+            ready.push_back(std::move(entry.second));
+        this->groups.clear();
+    }
+    for (Pending &pending : ready)
+        this->deliver(pending);
+}
+
+std::size_t MediaGroupAggregator::pending() const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    return this->groups.size();
+}
+
+long long MediaGroupAggregator::oldestPendingUpdateId() const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    long long oldest = 0;
+    for (const auto &entry : this->groups)
+    {
+        if (oldest == 0 || entry.second.firstUpdateId < oldest)
+            oldest = entry.second.firstUpdateId;
+    }
+    return oldest;
+}
+
+bool MediaGroupAggregator::add(Telegram &telegram, long long updateId, const Message &message)
+{
+    if (message.mediaGroupId.empty())
+        return false;
+
+    Pending full;
+    bool complete = false;
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        if (!this->groupHandler)
+            return false;
+        // group ids are only meaningful within their chat
+        std::string key = std::to_string(message.chat.id) + ":" + message.mediaGroupId;
+        Pending &pending = this->groups[key];
+        if (pending.parts.empty())
+        {
+            pending.telegram = &telegram;
+            pending.group.id = message.mediaGroupId;
+            pending.group.chat = message.chat;
+            pending.group.from = message.from;
+            pending.group.dtime = message.dtime;
+        }
+        pending.parts[message.id] = message.media;
+        if (pending.firstUpdateId == 0 || updateId < pending.firstUpdateId)
+            pending.firstUpdateId = updateId;
+        if (pending.group.caption.empty())
+            pending.group.caption = message.caption;
+        pending.deadline = std::chrono::steady_clock::now() + this->window;
+
+        if (pending.parts.size() >= MAX_GROUP_SIZE)
+        {
+            full = std::move(pending);
+            this->groups.erase(key);
+            complete = true;
+        }
+    }
+    if (complete)
+        this->deliver(full);
+    else
+        this->changed.notify_one();
+    return true;
+}
+
+void MediaGroupAggregator::deliver(Pending &pending)
+{
+    static Metrics::Counter &delivered = Metrics::global().counter("tessergram_media_groups_total", "", "Albums delivered as one combined event");
+    static Metrics::Counter &parts = Metrics::global().counter("tessergram_media_group_parts_total", "", "Album messages folded into combined events");
+
+    MediaGroup &group = pending.group;
+    for (auto &part : pending.parts)
+    {
+        group.messageIds.push_back(part.first);
+        group.media.insert(group.media.end(), part.second.begin(), part.second.end());
+    }
+    delivered.add();
+    parts.add(pending.parts.size());
+
+    GroupHandler handler;
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        handler = this->groupHandler;
+    }
+    if (!handler || pending.telegram == nullptr)
+        return;
+    try
+    {
+        handler(*pending.telegram, group);
+    }
+    catch (const std::exception &e)
+    {
+        TG_LOG(Log::ERROR, "media group handler failed: %s!\n", e.what());
+    }
+}
+
+void MediaGroupAggregator::run()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (!this->stopping)
+    {
+        if (this->groups.empty())
+        {
+            this->changed.wait(lock);
+            continue;
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point next = std::chrono::steady_clock::time_point::max();
+        std::vector<Pending> ready;
+        for (auto it = this->groups.begin(); it != this->groups.end();)
+        {
+            if (it->second.deadline <= now)
+            {
+                ready.push_back(std::move(it->second));
+                it = this->groups.erase(it);
+            }
+            else
+            {
+                next = std::min(next, it->second.deadline);
+                ++it;
+            }
+        }
+
+        if (ready.empty())
+        {
+            this->changed.wait_until(lock, next);
+            continue;
+        }
+        lock.unlock();
+        for (Pending &pending : ready)
+            this->deliver(pending);
+        lock.lock();
+    }
+}
@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <cstdio>
+#include "metrics.hpp"
+
+const double Metrics::Histogram::BOUNDS[Metrics::Histogram::BUCKET_COUNT] = {
+    0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+
+Metrics::Counter::Counter() : count(0)
+{
+}
+
+void Metrics::Counter::add(uint64_t n)
+{
+    this->count.fetch_add(n, std::memory_order_relaxed);
+}
+
+uint64_t Metrics::Counter::value() const
+{
+    return this->count.load(std::memory_order_relaxed);
+}
+
+Metrics::Gauge::Gauge() : current(0)
+{
+}
+
+void Metrics::Gauge::set(long long val)
+{
+    this->current.store(val, std::memory_order_relaxed);
+}
+
+void Metrics::Gauge::add(long long delta)
+{
+    this->current.fetch_add(delta, std::memory_order_relaxed);
+}
+
+long long Metrics::Gauge::value() const
+{
+    return this->current.load(std::memory_order_relaxed);
+}
+
+Metrics::Histogram::Histogram() : count(0), sumMicros(0)
+{
+    for (std::size_t i = 0; i <= BUCKET_COUNT; i++)
+        this->buckets[i].store(0, std::memory_order_relaxed);
+}
+
+void Metrics::Histogram::observe(double seconds)
+{
+    this->observeMicros(seconds <= 0 ? 0 : static_cast<uint64_t>(seconds * 1e6));
+}
+
+void Metrics::Histogram::observeMicros(uint64_t micros)
+{
+    double seconds = static_cast<double>(micros) / 1e6;
+    std::size_t idx = 0;
+    while (idx < BUCKET_COUNT && seconds > BOUNDS[idx])
+        idx++;
+    this->buckets[idx].fetch_add(1, std::memory_order_relaxed);
+    this->count.fetch_add(1, std::memory_order_relaxed);
+    this->sumMicros.fetch_add(micros, std::memory_order_relaxed);
+}
+
+Metrics &Metrics::global()
+{
+    static Metrics registry;
+    return registry;
+}
+
+Metrics::Entry &Metrics::lookup(Metrics::Kind kind, const std::string &name, const std::string &labels, const std::string &help)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    for (Entry &entry : this->entries)
+    {
+        if (entry.kind == kind && entry.name == name && entry.labels == labels)
+            return entry;
+    }
+    this->entries.emplace_back();
+    Entry &entry = this->entries.back();
+    entry.kind = kind;
+    entry.name = name;
+    entry.labels = labels;
+    entry.help = help;
+    return entry;
+}
+
+Metrics::Counter &Metrics::counter(const std::string &name, const std::string &labels, const std::string &help)
+{
+    return this->lookup(Kind::COUNTER, name, labels, help).counter;
+}
+
+Metrics::Gauge &Metrics::gauge(const std::string &name, const std::string &labels, const std::string &help)
+{
+    return this->lookup(Kind::GAUGE, name, labels, help).gauge;
+}
+
+Metrics::Histogram &Metrics::histogram(const std::string &name, const std::string &labels, const std::string &help)
+{
+    return this->lookup(Kind::HISTOGRAM, name, labels, help).histogram;
+}
+
+std::vector<Metrics::Sample> Metrics::snapshot() const
+{
+    std::vector<Sample> result;
+    std::lock_guard<std::mutex> guard(this->mutex);
+    result.reserve(this->entries.size());
+    for (const Entry &entry : this->entries)
+    {
+        result.emplace_back();
+        Sample &sample = result.back();
+        sample.kind = entry.kind;
+        sample.name = entry.name;
+        sample.labels = entry.labels;
+        sample.help = entry.help;
+        sample.value = 0;
+        sample.count = 0;
+        sample.sum = 0;
+        switch (entry.kind)
+        {
+        case Kind::COUNTER:
+            sample.value = static_cast<double>(entry.counter.value());
+            break;
+        case Kind::GAUGE:
+            sample.value = static_cast<double>(entry.gauge.value());
+            break;
+        case Kind::HISTOGRAM:
+            for (std::size_t i = 0; i <= Histogram::BUCKET_COUNT; i++)
+                sample.buckets.push_back(entry.histogram.buckets[i].load(std::memory_order_relaxed));
+            sample.count = entry.histogram.count.load(std::memory_order_relaxed);
+            sample.sum = static_cast<double>(entry.histogram.sumMicros.load(std::memory_order_relaxed)) / 1e6;
+            break;
+        }
+    }
+    return result;
+}
+
+static std::string joinLabels(const std::string &labels, const std::string &extra)
+{
+    if (labels.empty() && extra.empty())
+        return "";
+    if (labels.empty())
+        return "{" + extra + "}";
+    if (extra.empty())
+        return "{" + labels + "}";
+    return "{" + labels + "," + extra + "}";
+}
+
+static void appendNumber(std::string &out, double val)
+{
+    char num[32];
+    snprintf(num, sizeof(num), "%.17g", val);
+    out.append(num);
+}
+
+std::string Metrics::exportPrometheus() const
+{
+    static const char *kindNames[] = {"counter", "gauge", "histogram"};
+
+    std::vector<Sample> samples = this->snapshot();
+    std::stable_sort(samples.begin(), samples.end(),
+                     [](const Sample &a, const Sample &b)
+                     { return a.name < b.name; });
+
+    std::string out;
+    out.reserve(samples.size() * 96);
+
+    const std::string *family = nullptr;
+    for (const Sample &sample : samples)
+    {
+        if (family == nullptr || *family != sample.name)
+        {
+            family = &sample.name;
+            out.append("# HELP ").append(sample.name).append(" ").append(sample.help).append("\n");
+            out.append("# TYPE ").append(sample.name).append(" ").append(kindNames[static_cast<std::size_t>(sample.kind)]).append("\n");
+        }
+
+        if (sample.kind != Kind::HISTOGRAM)
+        {
+            out.append(sample.name).append(joinLabels(sample.labels, ""));
+            out.push_back(' ');
+            appendNumber(out, sample.value);
+            out.push_back('\n');
+            continue;
+        }
+
+        uint64_t cumulative = 0;
+        for (std::size_t i = 0; i <= Histogram::BUCKET_COUNT; i++)
+        {
+            char bound[32];
+            cumulative += sample.buckets[i];
+            if (i < Histogram::BUCKET_COUNT)
+                snprintf(bound, sizeof(bound), "le=\"%g\"", Histogram::BOUNDS[i]);
+            else
+                snprintf(bound, sizeof(bound), "le=\"+Inf\"");
+            out.append(sample.name).append("_bucket").append(joinLabels(sample.labels, bound));
+            out.push_back(' ');
+            out.append(std::to_string(cumulative)).push_back('\n');
+        }
+        out.append(sample.name).append("_sum").append(joinLabels(sample.labels, "")).push_back(' ');
+        appendNumber(out, sample.sum);
+        out.push_back('\n');
+        out.append(sample.name).append("_count").append(joinLabels(sample.labels, "")).push_back(' ');
+        out.append(std::to_string(sample.count)).push_back('\n');
+    }
+    return out;
+}
+
+std::string Metrics::label(const std::string &key, const std::string &value)
+{
+    std::string out = key + "=\"";
+    for (char c : value)
+    {
+        if (c == '\\' || c == '"')
+            out.push_back('\\');
+        if (c == '\n')
+        {
+            out.append("\\n");
+            continue;
+        }
+        out.push_back(c);
+    }
+    out.push_back('"');
+    return out;
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "offset-store.hpp"
+#include "log.hpp"
+#include "utils/include/error.hpp"
+
+namespace
+{
+    // "%020lld\n": fits any update id and is rewritten in place with a single
+    // pwrite, so a reader never sees a half-updated number
+    const std::size_t RECORD_SIZE = 21;
+}
+
+OffsetStore::~OffsetStore()
+{
+}
+
+FileOffsetStore::FileOffsetStore(const std::string &path, unsigned int syncEvery, int syncIntervalMs)
+    : path(path),
+      fd(-1),
+      syncEvery(syncEvery == 0 ? 1 : syncEvery),
+      syncIntervalMs(syncIntervalMs < 0 ? 0 : syncIntervalMs),
+      pending(0),
+      lastCommitted(0),
+      lastSync(std::chrono::steady_clock::now()),
+      mutex()
+{
+    std::size_t slash = path.find_last_of('/');
+    if (slash != std::string::npos && slash > 0)
+        mkdir(path.substr(0, slash).c_str(), 0700);
+
+    this->fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (this->fd < 0)
+        throw std::runtime_error(Error::common(__FILE__, __LINE__, __func__, "cannot open offset file"));
+}
+
+FileOffsetStore::~FileOffsetStore()
+{
+    this->flush();
+    close(this->fd);
+}
+
+long long FileOffsetStore::load()
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    char record[RECORD_SIZE + 1];
+    ssize_t length = pread(this->fd, record, RECORD_SIZE, 0);
+    if (length <= 0)
+        return 0;
+    record[length] = '\0';
+
+    long long updateId = std::strtoll(record, nullptr, 10);
+    if (updateId < 0)
+        updateId = 0;
+    this->lastCommitted = updateId;
+    return updateId;
+}
+
+void FileOffsetStore::commit(long long updateId)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    if (updateId <= this->lastCommitted)
+        return;
+    this->writeUnlocked(updateId);
+
+    this->pending++;
+    if (this->pending >= this->syncEvery ||
+        std::chrono::steady_clock::now() - this->lastSync >= std::chrono::milliseconds(this->syncIntervalMs))
+        this->syncUnlocked();
+}
+
+void FileOffsetStore::flush()
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    if (this->pending > 0)
+        this->syncUnlocked();
+}
+
+const std::string &FileOffsetStore::getPath() const
+{
+    return this->path;
+}
+
+std::string FileOffsetStore::defaultPath(const std::string &token)
+{
+    // the numeric bot id in front of ':' identifies the bot without leaking the secret
+    return std::string(__TESSERGRAM_DATA_DIRECTORY__) + token.substr(0, token.find(':')) + ".offset";
+}
+
+void FileOffsetStore::writeUnlocked(long long updateId)
+{
+    char record[RECORD_SIZE + 1];
+    snprintf(record, sizeof(record), "%020lld\n", updateId);
+    if (pwrite(this->fd, record, RECORD_SIZE, 0) != static_cast<ssize_t>(RECORD_SIZE))
+    {
+        TG_LOG(Log::ERROR, "offset write failed: %s!\n", strerror(errno));
+        return;
+    }
+    this->lastCommitted = updateId;
+}
+
+void FileOffsetStore::syncUnlocked()
+{
+    if (fdatasync(this->fd) != 0)
+        TG_LOG(Log::ERROR, "offset sync failed: %s!\n", strerror(errno));
+    this->pending = 0;
+    this->lastSync = std::chrono::steady_clock::now();
+}
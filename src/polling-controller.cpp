@@ -1,63 +1,284 @@
+#include <algorithm>
 #include "polling-controller.hpp"
+#include "metrics.hpp"
+
+namespace
+{
+    const char *stateName(PollingController::State state)
+    {
+        switch (state)
+        {
+        case PollingController::State::SLOW:
+            return "slow";
+        case PollingController::State::BUSY:
+            return "busy";
+        default:
+            return "normal";
+        }
+    }
+
+    void recordTransition(PollingController::State from, PollingController::State to)
+    {
+        Metrics &metrics = Metrics::global();
+        metrics.counter("tessergram_polling_transitions_total",
+                        Metrics::label("from", stateName(from)) + "," + Metrics::label("to", stateName(to)),
+                        "PollingController state transitions")
+            .add();
+        metrics.gauge("tessergram_polling_state", "", "PollingController state (0 normal, 1 slow, 2 busy)")
+            .set(static_cast<long long>(to));
+    }
+}
 
 PollingController::PollingController(int normalIntervalMs, int slowIntervalMs)
     : state(State::NORMAL),
       normalInterval(normalIntervalMs),
-      slowInterval(slowIntervalMs),
+      slowInterval(std::max(slowIntervalMs, normalIntervalMs)),
+      minInterval(std::min(250, normalIntervalMs)),
+      interval(normalIntervalMs),
+      failureThreshold(3),
       consecutiveFailures(0),
-      lastPollTime(std::chrono::steady_clock::now())
+      lastBatch(0),
+      minLimit(0),
+      maxLimit(0),
+      limit(0),
+      targetBatchMs(1000),
+      handledPerSecond(0.0),
+      cancelled(false),
+      nextPollTime(std::chrono::steady_clock::now()),
+      rng(static_cast<std::minstd_rand::result_type>(std::chrono::steady_clock::now().time_since_epoch().count())),
+      mutex(),
+      wakeup()
 {
 }
 
 void PollingController::run(std::function<bool()> func)
 {
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastPollTime).count();
+    if (waitUntilDue(nullptr))
+        performPolling(func);
+}
+
+bool PollingController::runUntil(std::chrono::steady_clock::time_point deadline, std::function<bool()> func)
+{
+    if (!waitUntilDue(&deadline))
+        return false;
+    performPolling(func);
+    return true;
+}
 
-    if (elapsed >= getCurrentInterval())
+bool PollingController::runIfDue(std::function<bool()> func)
+{
     {
-        performPolling(func);
-        lastPollTime = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> guard(this->mutex);
+        if (std::chrono::steady_clock::now() < this->nextPollTime)
+            return false;
+        this->lastBatch = 0;
+    }
+    performPolling(func);
+    return true;
+}
+
+void PollingController::runNow(std::function<bool()> func)
+{
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        this->lastBatch = 0;
     }
+    performPolling(func);
+}
+
+bool PollingController::waitUntilDue(const std::chrono::steady_clock::time_point *deadline)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    std::chrono::steady_clock::time_point wakeAt = this->nextPollTime;
+    if (deadline != nullptr && *deadline < wakeAt)
+        wakeAt = *deadline;
+
+    this->wakeup.wait_until(lock, wakeAt,
+                            [this]()
+                            { return this->cancelled; });
+    if (this->cancelled)
+    {
+        this->cancelled = false;
+        return false;
+    }
+    if (std::chrono::steady_clock::now() < this->nextPollTime)
+        return false;
+    this->lastBatch = 0;
+    return true;
+}
+
+void PollingController::observe(std::size_t updates)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->lastBatch = updates;
+}
+
+void PollingController::cancel()
+{
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        this->cancelled = true;
+    }
+    this->wakeup.notify_all();
+}
+
+void PollingController::resume()
+{
+    // drops a cancel() that no wait has consumed
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->cancelled = false;
+}
+
+void PollingController::setMinInterval(int minIntervalMs)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->minInterval = std::max(0, std::min(minIntervalMs, this->normalInterval));
+}
+
+void PollingController::setFailureThreshold(int failures)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->failureThreshold = std::max(1, failures);
+}
+
+void PollingController::setLimitRange(int minLimit, int maxLimit)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    // the Bot API accepts 1-100
+    this->maxLimit = std::max(0, std::min(maxLimit, 100));
+    this->minLimit = std::max(1, std::min(minLimit, this->maxLimit));
+    this->limit = this->maxLimit > 0 ? this->minLimit : 0;
+}
+
+void PollingController::setTargetBatchTime(int milliseconds)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->targetBatchMs = std::max(1, milliseconds);
+    this->capLimit();
+}
+
+void PollingController::observeFetched(std::size_t received)
+{
+    static Metrics::Gauge &limitGauge = Metrics::global().gauge("tessergram_polling_limit", "", "getUpdates limit chosen for the next poll");
+
+    std::lock_guard<std::mutex> guard(this->mutex);
+    if (this->maxLimit == 0)
+        return;
+    // a full batch means more are waiting
+    if (received >= static_cast<std::size_t>(this->limit))
+        this->limit = std::min(this->maxLimit, this->limit * 2);
+    this->capLimit();
+    limitGauge.set(this->limit);
+}
+
+void PollingController::observeHandled(std::size_t updates, std::chrono::steady_clock::duration elapsed)
+{
+    if (updates == 0)
+        return;
+    double seconds = std::max(1e-6, std::chrono::duration<double>(elapsed).count());
+    double rate = static_cast<double>(updates) / seconds;
+
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->handledPerSecond = this->handledPerSecond > 0.0 ? 0.7 * this->handledPerSecond + 0.3 * rate : rate;
+    this->capLimit();
+}
+
+void PollingController::capLimit()
+{
+    if (this->maxLimit == 0 || this->handledPerSecond <= 0.0)
+        return;
+    double fits = this->handledPerSecond * this->targetBatchMs / 1000.0;
+    int cap = fits >= this->maxLimit ? this->maxLimit : std::max(this->minLimit, static_cast<int>(fits));
+    this->limit = std::min(this->limit, cap);
 }
 
 void PollingController::performPolling(std::function<bool()> func)
 {
-    transition(func());
+    static Metrics::Counter &succeeded = Metrics::global().counter("tessergram_polls_total", "result=\"success\"", "Polling cycles by result");
+    static Metrics::Counter &failed = Metrics::global().counter("tessergram_polls_total", "result=\"failure\"", "Polling cycles by result");
+
+    bool success = func();
+    (success ? succeeded : failed).add();
+
+    std::lock_guard<std::mutex> guard(this->mutex);
+    transition(success);
+    this->nextPollTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(this->interval);
+}
+
+int PollingController::backoff()
+{
+    // exponential growth from twice the normal interval, capped at the slow
+    // interval, with "equal jitter": half fixed, half uniformly random. The
+    // fixed half keeps a retry from coming sooner than a normal poll would
+    long long ceiling = 2LL * this->normalInterval;
+    for (int i = 1; i < this->consecutiveFailures && ceiling < this->slowInterval; i++)
+        ceiling *= 2;
+    ceiling = std::min<long long>(ceiling, this->slowInterval);
+
+    long long half = ceiling / 2;
+    std::uniform_int_distribution<long long> jitter(0, ceiling - half);
+    return static_cast<int>(half + jitter(this->rng));
 }
 
 void PollingController::transition(bool success)
 {
-    switch (state)
-    {
-    case State::NORMAL:
-        if (success)
-        {
-            consecutiveFailures = 0;
-        }
-        else if (++consecutiveFailures >= FAILURE_THRESHOLD)
-        {
-            state = State::SLOW;
-        }
-        break;
+    static Metrics::Counter &backoffs = Metrics::global().counter("tessergram_polling_backoff_total", "", "Polls rescheduled with failure backoff");
+    static Metrics::Gauge &intervalGauge = Metrics::global().gauge("tessergram_polling_interval_ms", "", "Delay chosen before the next poll");
 
-    case State::SLOW:
-        if (success)
-        {
-            state = State::NORMAL;
-            consecutiveFailures = 0;
-        }
-        // failure in SLOW: remain in SLOW, counter unchanged
-        break;
+    if (!success)
+    {
+        this->consecutiveFailures++;
+        this->interval = this->backoff();
+        backoffs.add();
+        if (this->consecutiveFailures >= this->failureThreshold)
+            enter(State::SLOW);
+    }
+    else if (this->lastBatch > 0)
+    {
+        this->consecutiveFailures = 0;
+        this->interval = std::max(this->minInterval, std::min(this->interval, this->normalInterval) / 2);
+        enter(State::BUSY);
+    }
+    else
+    {
+        this->consecutiveFailures = 0;
+        if (this->state == State::SLOW)
+            this->interval = this->normalInterval;
+        else
+            this->interval = std::min(this->normalInterval, std::max(1, this->interval) * 2);
+        enter(State::NORMAL);
     }
+    intervalGauge.set(this->interval);
+}
+
+void PollingController::enter(State next)
+{
+    if (next == this->state)
+        return;
+    recordTransition(this->state, next);
+    this->state = next;
 }
 
 int PollingController::getCurrentInterval() const
 {
-    return (state == State::SLOW) ? slowInterval : normalInterval;
+    std::lock_guard<std::mutex> guard(this->mutex);
+    return this->interval;
+}
+
+int PollingController::getLimit() const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    return this->limit;
 }
 
 PollingController::State PollingController::getState() const
 {
-    return state;
+    std::lock_guard<std::mutex> guard(this->mutex);
+    return this->state;
 }
+
+std::chrono::steady_clock::time_point PollingController::getNextPollTime() const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    return this->nextPollTime;
+}
\ No newline at end of file
@@ -1,7 +1,11 @@
+#include <chrono>
+#include <memory>
 #include "request.hpp"
-#include "json-validator.hpp"
+#include "json-writer.hpp"
+#include "update-decoder.hpp"
 #include "nlohmann/json.hpp"
-#include "utils/include/debug.hpp"
+#include "log.hpp"
+#include "metrics.hpp"
 #include "utils/include/error.hpp"
 #include "fetchapi/include/fetch-api.hpp"
 
@@ -24,144 +28,315 @@ static const char *reqStr[] = {
     "sendVoice",
     "sendDocument",
     "setWebhook",
-    "deleteWebhook"};
+    "deleteWebhook",
+    "copyMessage",
+    "forwardMessage",
+    "copyMessages",
+    "forwardMessages",
+    "deleteMessage",
+    "deleteMessages"};
 
-Request::Request(const std::string &url, const std::string &token, Request::Type req)
+static const std::size_t reqCount = sizeof(reqStr) / sizeof(reqStr[0]);
+
+static_assert(reqCount == static_cast<std::size_t>(Request::Type::DELETE_MESSAGES) + 1,
+              "reqStr out of sync with Request::Type enum — update both together");
+
+namespace
+{
+    /**
+     * Per-thread free list of response buffers. Released buffers are cleared
+     * but keep their capacity, so steady-state requests reuse the same memory.
+     */
+    class BufferPool
+    {
+    public:
+        static const std::size_t MAX_POOLED = 8;
+        static const std::size_t MAX_RETAINED_CAPACITY = 1024 * 1024;
+
+        static std::string *acquire()
+        {
+            std::vector<std::unique_ptr<std::string>> &pool = local();
+            if (pool.empty())
+                return new std::string();
+            std::string *buffer = pool.back().release();
+            pool.pop_back();
+            return buffer;
+        }
+
+        static void release(std::string *buffer)
+        {
+            std::vector<std::unique_ptr<std::string>> &pool = local();
+            if (pool.size() >= MAX_POOLED || buffer->capacity() > MAX_RETAINED_CAPACITY)
+            {
+                delete buffer;
+                return;
+            }
+            buffer->clear();
+            pool.emplace_back(buffer);
+        }
+
+    private:
+        static std::vector<std::unique_ptr<std::string>> &local()
+        {
+            static thread_local std::vector<std::unique_ptr<std::string>> pool;
+            return pool;
+        }
+    };
+}
+
+namespace
+{
+    class RequestSeries
+    {
+    public:
+        Metrics::Counter *succeeded;
+        Metrics::Counter *failed;
+        Metrics::Histogram *latency;
+    };
+
+    RequestSeries &requestSeries(Request::Type req)
+    {
+        static std::vector<RequestSeries> series = []()
+        {
+            std::vector<RequestSeries> all(reqCount);
+            Metrics &metrics = Metrics::global();
+            for (std::size_t i = 0; i < reqCount; i++)
+            {
+                std::string method = Metrics::label("method", (reqStr[i][0] != '\0') ? reqStr[i] : "download");
+                all[i].succeeded = &metrics.counter("tessergram_api_requests_total", method + ",result=\"success\"", "Bot API requests by method and result");
+                all[i].failed = &metrics.counter("tessergram_api_requests_total", method + ",result=\"error\"", "Bot API requests by method and result");
+                all[i].latency = &metrics.histogram("tessergram_api_request_duration_seconds", method, "Bot API request latency");
+            }
+            return all;
+        }();
+        return series[static_cast<std::size_t>(req)];
+    }
+
+    void recordRequest(Request::Type req, bool success, std::chrono::steady_clock::time_point start)
+    {
+        RequestSeries &series = requestSeries(req);
+        (success ? series.succeeded : series.failed)->add();
+        series.latency->observeMicros(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()));
+    }
+
+    void recordError(Request::Type req, int code)
+    {
+        const char *method = reqStr[static_cast<std::size_t>(req)];
+        Metrics::global()
+            .counter("tessergram_api_errors_total",
+                     Metrics::label("method", (method[0] != '\0') ? method : "download") + "," + Metrics::label("code", std::to_string(code)),
+                     "Bot API transport errors by method and FetchAPI return code")
+            .add();
+    }
+}
+
+Endpoint::Endpoint() : baseUrl(), token(), fileUrl(), urls(reqCount)
+{
+}
+
+Endpoint::Endpoint(const std::string &baseUrl, const std::string &token) : Endpoint()
 {
-    this->url = url + (url.at(url.length() - 1) == '/' ? "bot" : "/bot") + token + "/" + reqStr[static_cast<std::size_t>(req)];
-    FetchAPI fapi(this->url, CONNECTION_TIMEOUT, ALL_TIMEOUT);
+    this->configure(baseUrl, token);
+}
 
-    fapi.confidential(token)
+Endpoint::~Endpoint()
+{
+}
+
+void Endpoint::configure(const std::string &baseUrl, const std::string &token)
+{
+    this->baseUrl = baseUrl;
+    this->token = token;
+
+    std::string root = baseUrl;
+    if (root.empty() || root.back() != '/')
+        root.push_back('/');
+
+    this->fileUrl = root + "file/bot" + token + "/";
+    for (std::size_t i = 0; i < reqCount; i++)
+    {
+        this->urls[i] = root + "bot" + token + "/" + reqStr[i];
+    }
+}
+
+const std::string &Endpoint::getBaseUrl() const
+{
+    return this->baseUrl;
+}
+
+const std::string &Endpoint::getToken() const
+{
+    return this->token;
+}
+
+const std::string &Endpoint::getUrl(Request::Type req) const
+{
+    return this->urls[static_cast<std::size_t>(req)];
+}
+
+const std::string &Endpoint::getFileUrl() const
+{
+    return this->fileUrl;
+}
+
+Request::Request(const Endpoint &endpoint, Request::Type req) : success(false), response(BufferPool::acquire())
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    FetchAPI fapi(endpoint.getUrl(req), CONNECTION_TIMEOUT, ALL_TIMEOUT);
+
+    fapi.confidential(endpoint.getToken())
         .get()
         .onSuccess(
             [this](const std::string &payload)
-            { 
+            {
                 this->success = true;
-                this->response = payload;
-                Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "response: %s\n", payload.c_str()); })
+                this->response->assign(payload);
+                TG_LOG_PAYLOAD(Log::INFO, "response", payload); })
         .onError(
-            [this](FetchAPI::ReturnCode code, const std::string &err)
+            [this, req](FetchAPI::ReturnCode code, const std::string &err)
             {
                 this->success = false;
-                Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "[%02X] %s\n", code, err.c_str()); });
+                recordError(req, static_cast<int>(code));
+                TG_LOG(Log::ERROR, "[%02X] %s\n", code, err.c_str()); });
+    recordRequest(req, this->success, start);
 }
 
-Request::Request(const std::string &url, const std::string &token, Request::Type req, const std::string &data)
+Request::Request(const Endpoint &endpoint, Request::Type req, const std::string &data) : success(false), response(BufferPool::acquire())
 {
-    this->url = url + (url.at(url.length() - 1) == '/' ? "bot" : "/bot") + token + "/" + reqStr[static_cast<std::size_t>(req)];
-    FetchAPI fapi(this->url, CONNECTION_TIMEOUT, ALL_TIMEOUT);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    FetchAPI fapi(endpoint.getUrl(req), CONNECTION_TIMEOUT, ALL_TIMEOUT);
 
-    Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "request: %s\n", data.c_str());
+    TG_LOG_PAYLOAD(Log::INFO, "request", data);
 
-    fapi.confidential(token)
+    fapi.confidential(endpoint.getToken())
         .header("Content-Type", "application/json")
         .post(data)
         .onSuccess(
             [this](const std::string &payload)
-            { 
+            {
                 this->success = true;
-                this->response = payload;
-                Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "response: %s\n", payload.c_str()); })
+                this->response->assign(payload);
+                TG_LOG_PAYLOAD(Log::INFO, "response", payload); })
         .onError(
-            [this](FetchAPI::ReturnCode code, const std::string &err)
+            [this, req](FetchAPI::ReturnCode code, const std::string &err)
             {
                 this->success = false;
-                Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "[%02X] %s\n", code, err.c_str()); });
+                recordError(req, static_cast<int>(code));
+                TG_LOG(Log::ERROR, "[%02X] %s\n", code, err.c_str()); });
+    recordRequest(req, this->success, start);
 }
 
-Request::Request(const std::string &url, const std::string &token, Request::Type req, const nlohmann::json &data)
+Request::Request(const Endpoint &endpoint, Request::Type req, const nlohmann::json &data) : success(false), response(BufferPool::acquire())
 {
-    this->url = url + (url.at(url.length() - 1) == '/' ? "bot" : "/bot") + token + "/" + reqStr[static_cast<std::size_t>(req)];
-    FetchAPI fapi(this->url, CONNECTION_TIMEOUT, ALL_TIMEOUT);
-
     if (!data.is_array())
     {
-        Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "upload data must be a JSON array of MIME parts\n");
+        TG_LOG(Log::ERROR, "upload data must be a JSON array of MIME parts\n");
         return;
     }
-    fapi.confidential(token)
-        .upload(data.dump())
+    this->upload(endpoint, req, data.dump());
+}
+
+Request::Request(const Endpoint &endpoint, Request::Type req, const JSONWriter &data) : success(false), response(BufferPool::acquire())
+{
+    if (data.empty() || data.str().front() != '[')
+    {
+        TG_LOG(Log::ERROR, "upload data must be a JSON array of MIME parts\n");
+        return;
+    }
+    this->upload(endpoint, req, data.str());
+}
+
+void Request::upload(const Endpoint &endpoint, Request::Type req, const std::string &mimeParts)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    FetchAPI fapi(endpoint.getUrl(req), CONNECTION_TIMEOUT, ALL_TIMEOUT);
+
+    fapi.confidential(endpoint.getToken())
+        .upload(mimeParts)
         .onSuccess(
             [this](const std::string &payload)
-            { 
+            {
                 this->success = true;
-                this->response = payload;
-                Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "response: %s\n", payload.c_str()); })
+                this->response->assign(payload);
+                TG_LOG_PAYLOAD(Log::INFO, "response", payload); })
         .onError(
-            [this](FetchAPI::ReturnCode code, const std::string &err)
+            [this, req](FetchAPI::ReturnCode code, const std::string &err)
             {
                 this->success = false;
-                Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "[%02X] %s\n", code, err.c_str()); });
+                recordError(req, static_cast<int>(code));
+                TG_LOG(Log::ERROR, "[%02X] %s\n", code, err.c_str()); });
+    recordRequest(req, this->success, start);
 }
 
-static std::string fetchMediaPath(const std::string &url, const std::string &token, const std::string &fileId)
+static std::string fetchMediaPath(const Endpoint &endpoint, const std::string &fileId)
 {
-    std::string apiUrl = url + (url.at(url.length() - 1) == '/' ? "bot" : "/bot") + token + "/" + reqStr[static_cast<std::size_t>(Request::Type::GET_MEDIA_PATH)];
-    FetchAPI fapi(apiUrl, CONNECTION_TIMEOUT, ALL_TIMEOUT);
+    FetchAPI fapi(endpoint.getUrl(Request::Type::GET_MEDIA_PATH), CONNECTION_TIMEOUT, ALL_TIMEOUT);
 
-    nlohmann::json body;
-    body["file_id"] = fileId;
+    JSONWriter &body = JSONWriter::local();
+    body.beginObject().field("file_id", fileId).endObject();
 
     std::string mediaPath;
-    fapi.confidential(token)
-        .post(body.dump())
+    fapi.confidential(endpoint.getToken())
+        .post(body.str())
         .onSuccess(
             [&](const std::string &payload)
             {
-                try
-                {
-                    nlohmann::json json = nlohmann::json::parse(payload);
-                    JSONValidator jval(__FILE__, __LINE__, __func__);
-                    nlohmann::json jsonResult = jval.getObject(json, "result");
-                    mediaPath = jval.get<std::string>(jsonResult, "file_path", "result");
-                }
-                catch (const std::exception &e)
+                UpdateDecoder decoder;
+                JSONReader::Status status = decoder.decodeResult(payload, "file_path", mediaPath);
+                if (status != JSONReader::Status::OK)
                 {
-                    Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "failed to parse payload: %s!\n", e.what());
+                    mediaPath.clear();
+                    TG_LOG(Log::ERROR, "failed to parse payload: %s!\n", JSONReader::statusToString(status));
                 }
             })
         .onError(
             [](FetchAPI::ReturnCode code, const std::string &err)
             {
-                Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "[%02X] %s\n", code, err.c_str());
+                TG_LOG(Log::ERROR, "[%02X] %s\n", code, err.c_str());
             });
 
     return mediaPath;
 }
 
-Request::Request(const std::string &url, const std::string &token, Request::Type req, const std::string &ref, std::vector<unsigned char> &data)
+Request::Request(const Endpoint &endpoint, Request::Type req, const std::string &ref, std::vector<unsigned char> &data) : success(false), response(BufferPool::acquire())
 {
-    this->success = false;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
     std::string mediaPath = ref;
 
     if (req == Request::Type::DOWNLOAD_MEDIA_BY_FILE_ID)
     {
-        mediaPath = fetchMediaPath(url, token, ref);
+        mediaPath = fetchMediaPath(endpoint, ref);
         if (mediaPath.empty())
             return;
     }
 
-    this->url = url + (url.at(url.length() - 1) == '/' ? "file/bot" : "/file/bot") + token + "/" + mediaPath;
-    FetchAPI fapi(this->url, CONNECTION_TIMEOUT, ALL_TIMEOUT);
+    std::string *url = BufferPool::acquire();
+    url->append(endpoint.getFileUrl()).append(mediaPath);
+    FetchAPI fapi(*url, CONNECTION_TIMEOUT, ALL_TIMEOUT);
 
-    fapi.confidential(token)
+    fapi.confidential(endpoint.getToken())
         .download(data)
         .onSuccess(
             [&](const std::string &payload)
             {
                 this->success = true;
-                this->response = mediaPath;
+                this->response->assign(mediaPath);
             })
         .onError(
-            [this](FetchAPI::ReturnCode code, const std::string &err)
+            [this, req](FetchAPI::ReturnCode code, const std::string &err)
             {
                 this->success = false;
-                Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "[%02X] %s\n", code, err.c_str());
+                recordError(req, static_cast<int>(code));
+                TG_LOG(Log::ERROR, "[%02X] %s\n", code, err.c_str());
             });
+    BufferPool::release(url);
+    recordRequest(req, this->success, start);
 }
 
 Request::~Request()
 {
+    BufferPool::release(this->response);
 }
 
 bool Request::isSuccess() const
@@ -171,5 +346,13 @@ bool Request::isSuccess() const
 
 const std::string &Request::getResponse() const
 {
-    return this->response;
+    return *(this->response);
+}
+
+const char *Request::typeToString(Request::Type req)
+{
+    std::size_t index = static_cast<std::size_t>(req);
+    if (index < reqCount)
+        return reqStr[index];
+    return "";
 }
\ No newline at end of file
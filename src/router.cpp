@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include "router.hpp"
+#include "utils/include/error.hpp"
+
+namespace
+{
+    std::string lowercase(const std::string &text)
+    {
+        std::string result(text);
+        std::transform(result.begin(), result.end(), result.begin(),
+                       [](unsigned char c)
+                       {
+                           return static_cast<char>(std::tolower(c));
+                       });
+        return result;
+    }
+
+    bool isSpace(char c)
+    {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+    }
+}
+
+Router::Trie::Trie() : nodes(1)
+{
+    this->nodes[0].value = -1;
+}
+
+void Router::Trie::insert(const std::string &key, std::size_t value)
+{
+    uint32_t current = 0;
+    for (char c : key)
+    {
+        std::vector<std::pair<char, uint32_t>> &next = this->nodes[current].next;
+        std::vector<std::pair<char, uint32_t>>::iterator it = std::lower_bound(
+            next.begin(), next.end(), std::make_pair(c, static_cast<uint32_t>(0)));
+        if (it != next.end() && it->first == c)
+        {
+            current = it->second;
+            continue;
+        }
+        uint32_t child = static_cast<uint32_t>(this->nodes.size());
+        next.insert(it, std::make_pair(c, child));
+        // `next` may dangle once nodes grows, so it is not touched again
+        this->nodes.push_back(Node());
+        this->nodes.back().value = -1;
+        current = child;
+    }
+    this->nodes[current].value = static_cast<long>(value);
+}
+
+bool Router::Trie::longest(const std::string &input, std::size_t &value, std::size_t &length) const
+{
+    bool found = false;
+    uint32_t current = 0;
+    for (std::size_t i = 0;; i++)
+    {
+        const Node &node = this->nodes[current];
+        if (node.value >= 0)
+        {
+            value = static_cast<std::size_t>(node.value);
+            length = i;
+            found = true;
+        }
+        if (i == input.length())
+            break;
+        std::vector<std::pair<char, uint32_t>>::const_iterator it = std::lower_bound(
+            node.next.begin(), node.next.end(), std::make_pair(input[i], static_cast<uint32_t>(0)));
+        if (it == node.next.end() || it->first != input[i])
+            break;
+        current = it->second;
+    }
+    return found;
+}
+
+Router::Router() : commands(), prefixes(), callbacks(), patterns(), fallbackHandler(), username()
+{
+}
+
+Router::~Router()
+{
+}
+
+Router &Router::command(const std::string &name, CommandHandler handler)
+{
+    std::string key = lowercase(!name.empty() && name[0] == '/' ? name.substr(1) : name);
+    if (key.empty() || !handler || std::find_if(key.begin(), key.end(), isSpace) != key.end())
+        throw std::runtime_error(Error::common(__FILE__, __LINE__, __func__, "invalid input"));
+    this->commands[key] = handler;
+    return *this;
+}
+
+Router &Router::callback(const std::string &prefix, CallbackHandler handler)
+{
+    if (!handler)
+        throw std::runtime_error(Error::common(__FILE__, __LINE__, __func__, "invalid input"));
+    // an empty prefix is allowed and catches every callback query
+    this->prefixes.insert(prefix, this->callbacks.size());
+    this->callbacks.push_back(handler);
+    return *this;
+}
+
+Router &Router::pattern(const std::string &regex, PatternHandler handler)
+{
+    if (!handler)
+        throw std::runtime_error(Error::common(__FILE__, __LINE__, __func__, "invalid input"));
+    try
+    {
+        this->patterns.emplace_back(std::regex(regex, std::regex::ECMAScript | std::regex::optimize), handler);
+    }
+    catch (const std::regex_error &e)
+    {
+        throw std::runtime_error(Error::common(__FILE__, __LINE__, __func__, "invalid input"));
+    }
+    return *this;
+}
+
+Router &Router::fallback(FallbackHandler handler)
+{
+    this->fallbackHandler = handler;
+    return *this;
+}
+
+void Router::setUsername(const std::string &botUsername)
+{
+    this->username = lowercase(!botUsername.empty() && botUsername[0] == '@' ? botUsername.substr(1) : botUsername);
+}
+
+bool Router::routeMessage(Telegram &telegram, const Message &message) const
+{
+    const std::string &text = message.text;
+    if (text.length() > 1 && text[0] == '/' && !this->commands.empty())
+    {
+        // "/name@bot args": the command ends at the first space or '@'
+        std::size_t end = 1;
+        while (end < text.length() && !isSpace(text[end]) && text[end] != '@')
+            end++;
+        std::size_t argsStart = end;
+        bool addressed = true;
+        if (end < text.length() && text[end] == '@')
+        {
+            while (argsStart < text.length() && !isSpace(text[argsStart]))
+                argsStart++;
+            // in groups a command may be meant for another bot
+            if (!this->username.empty())
+                addressed = lowercase(text.substr(end + 1, argsStart - end - 1)) == this->username;
+        }
+        if (addressed)
+        {
+            std::unordered_map<std::string, CommandHandler>::const_iterator it =
+                this->commands.find(lowercase(text.substr(1, end - 1)));
+            if (it != this->commands.end())
+            {
+                while (argsStart < text.length() && isSpace(text[argsStart]))
+                    argsStart++;
+                it->second(telegram, message, text.substr(argsStart));
+                return true;
+            }
+        }
+    }
+
+    for (const std::pair<std::regex, PatternHandler> &route : this->patterns)
+    {
+        std::smatch match;
+        if (std::regex_search(text, match, route.first))
+        {
+            route.second(telegram, message, match);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Router::routeCallback(Telegram &telegram, const CallbackQuery &query) const
+{
+    std::size_t index = 0;
+    std::size_t length = 0;
+    if (!this->prefixes.longest(query.data, index, length))
+        return false;
+    this->callbacks[index](telegram, query, query.data.substr(length));
+    return true;
+}
+
+bool Router::dispatch(Telegram &telegram, const NodeMessage &message) const
+{
+    bool routed = false;
+    message.processMessage(
+        [&](const Message &m)
+        {
+            routed = this->routeMessage(telegram, m);
+        });
+    message.processCallbackQuery(
+        [&](const CallbackQuery &q)
+        {
+            routed = routed || this->routeCallback(telegram, q);
+        });
+    if (!routed && this->fallbackHandler)
+    {
+        this->fallbackHandler(telegram, message);
+        return true;
+    }
+    return routed;
+}
+
+std::function<void(Telegram &, const NodeMessage &)> Router::handler() const
+{
+    // the router must outlive the bot it is installed on
+    const Router *router = this;
+    return [router](Telegram &telegram, const NodeMessage &message)
+    {
+        router->dispatch(telegram, message);
+    };
+}
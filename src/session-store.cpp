@@ -0,0 +1,253 @@
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include "session-store.hpp"
+#include "nlohmann/json.hpp"
+#include "log.hpp"
+
+class SessionStore::Entry
+{
+public:
+    nlohmann::json state;
+    std::chrono::steady_clock::time_point touched;
+};
+
+class SessionStore::Shard
+{
+public:
+    mutable std::mutex mutex;
+    std::unordered_map<Key, Entry, KeyHash> entries;
+    char padding[64]; // keeps neighbouring shard locks off one cache line
+};
+
+std::size_t SessionStore::KeyHash::operator()(const Key &key) const
+{
+    // splitmix64 finaliser: chat ids are sequential-ish and negative for
+    // groups, so spread them before masking
+    uint64_t x = static_cast<uint64_t>(key.first) * 0x9E3779B97F4A7C15ULL ^ static_cast<uint64_t>(key.second);
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return static_cast<std::size_t>(x);
+}
+
+SessionStore::SessionStore(Scope scope, int ttlSeconds, std::size_t shards)
+    : scope(scope), ttl(ttlSeconds > 0 ? ttlSeconds : 0), shardMask(0), shards()
+{
+    std::size_t count = 1;
+    while (count < shards && count < 4096)
+        count <<= 1;
+    this->shardMask = count - 1;
+    this->shards.reset(new Shard[count]);
+}
+
+SessionStore::~SessionStore()
+{
+}
+
+SessionStore::Key SessionStore::makeKey(long long chatId, long long userId) const
+{
+    return Key(chatId, this->scope == Scope::CHAT_USER ? userId : 0);
+}
+
+SessionStore::Shard &SessionStore::shardFor(const Key &key) const
+{
+    return this->shards[KeyHash()(key) & this->shardMask];
+}
+
+bool SessionStore::expired(const Entry &entry, std::chrono::steady_clock::time_point now) const
+{
+    return this->ttl.count() > 0 && now - entry.touched >= this->ttl;
+}
+
+bool SessionStore::get(long long chatId, long long userId, nlohmann::json &state) const
+{
+    Key key = this->makeKey(chatId, userId);
+    Shard &shard = this->shardFor(key);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+
+    std::unordered_map<Key, Entry, KeyHash>::iterator it = shard.entries.find(key);
+    if (it == shard.entries.end())
+        return false;
+    if (this->expired(it->second, std::chrono::steady_clock::now()))
+    {
+        shard.entries.erase(it);
+        return false;
+    }
+    state = it->second.state;
+    return true;
+}
+
+void SessionStore::set(long long chatId, long long userId, const nlohmann::json &state)
+{
+    Key key = this->makeKey(chatId, userId);
+    Shard &shard = this->shardFor(key);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+
+    Entry &entry = shard.entries[key];
+    entry.state = state;
+    entry.touched = std::chrono::steady_clock::now();
+}
+
+void SessionStore::update(long long chatId, long long userId, const std::function<void(nlohmann::json &)> &fn)
+{
+    Key key = this->makeKey(chatId, userId);
+    Shard &shard = this->shardFor(key);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::pair<std::unordered_map<Key, Entry, KeyHash>::iterator, bool> slot = shard.entries.emplace(key, Entry());
+    Entry &entry = slot.first->second;
+    // a new or expired session starts as an empty object
+    if (slot.second || this->expired(entry, now))
+        entry.state = nlohmann::json::object();
+    entry.touched = now;
+    // runs under the shard lock: keep it short and do not call back into the store
+    fn(entry.state);
+}
+
+bool SessionStore::erase(long long chatId, long long userId)
+{
+    Key key = this->makeKey(chatId, userId);
+    Shard &shard = this->shardFor(key);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    return shard.entries.erase(key) > 0;
+}
+
+bool SessionStore::get(const Message &message, nlohmann::json &state) const
+{
+    return this->get(message.chat.id, message.from.id, state);
+}
+
+void SessionStore::set(const Message &message, const nlohmann::json &state)
+{
+    this->set(message.chat.id, message.from.id, state);
+}
+
+void SessionStore::update(const Message &message, const std::function<void(nlohmann::json &)> &fn)
+{
+    this->update(message.chat.id, message.from.id, fn);
+}
+
+bool SessionStore::erase(const Message &message)
+{
+    return this->erase(message.chat.id, message.from.id);
+}
+
+std::size_t SessionStore::size() const
+{
+    std::size_t total = 0;
+    for (std::size_t i = 0; i <= this->shardMask; i++)
+    {
+        std::lock_guard<std::mutex> guard(this->shards[i].mutex);
+        total += this->shards[i].entries.size();
+    }
+    return total;
+}
+
+std::size_t SessionStore::expire()
+{
+    if (this->ttl.count() == 0)
+        return 0;
+
+    std::size_t removed = 0;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i <= this->shardMask; i++)
+    {
+        Shard &shard = this->shards[i];
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        for (std::unordered_map<Key, Entry, KeyHash>::iterator it = shard.entries.begin(); it != shard.entries.end();)
+        {
+            if (this->expired(it->second, now))
+            {
+                it = shard.entries.erase(it);
+                removed++;
+            }
+            else
+                ++it;
+        }
+    }
+    return removed;
+}
+
+void SessionStore::clear()
+{
+    for (std::size_t i = 0; i <= this->shardMask; i++)
+    {
+        std::lock_guard<std::mutex> guard(this->shards[i].mutex);
+        this->shards[i].entries.clear();
+    }
+}
+
+bool SessionStore::snapshot(const std::string &path) const
+{
+    std::string temp = path + ".tmp";
+    std::ofstream out(temp.c_str(), std::ios::trunc);
+    if (!out)
+    {
+        TG_LOG(Log::ERROR, "cannot write %s!\n", temp.c_str());
+        return false;
+    }
+
+    // one JSON object per line; shards are locked one at a time, so the
+    // snapshot is consistent per session but not across sessions
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i <= this->shardMask; i++)
+    {
+        const Shard &shard = this->shards[i];
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        for (const std::pair<const Key, Entry> &item : shard.entries)
+        {
+            if (this->expired(item.second, now))
+                continue;
+            nlohmann::json line = {
+                {"chat", item.first.first},
+                {"user", item.first.second},
+                {"age_ms", std::chrono::duration_cast<std::chrono::milliseconds>(now - item.second.touched).count()},
+                {"state", item.second.state}};
+            out << line.dump() << '\n';
+        }
+    }
+    out.close();
+    if (!out || std::rename(temp.c_str(), path.c_str()) != 0)
+    {
+        TG_LOG(Log::ERROR, "cannot replace %s!\n", path.c_str());
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SessionStore::restore(const std::string &path)
+{
+    std::ifstream in(path.c_str());
+    if (!in)
+        return false;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::string text;
+    std::size_t skipped = 0;
+    while (std::getline(in, text))
+    {
+        try
+        {
+            nlohmann::json line = nlohmann::json::parse(text);
+            Key key(line.at("chat").get<long long>(), line.at("user").get<long long>());
+            Shard &shard = this->shardFor(key);
+            std::lock_guard<std::mutex> guard(shard.mutex);
+            Entry &entry = shard.entries[key];
+            entry.state = line.at("state");
+            entry.touched = now - std::chrono::milliseconds(line.value("age_ms", 0LL));
+        }
+        catch (const std::exception &e)
+        {
+            skipped++;
+        }
+    }
+    if (skipped > 0)
+        TG_LOG(Log::WARNING, "skipped %zu malformed sessions in %s\n", skipped, path.c_str());
+    return true;
+}
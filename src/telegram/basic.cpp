@@ -3,49 +3,69 @@
 #include <cstring>
 #include "telegram.hpp"
 #include "request.hpp"
-#include "json-validator.hpp"
-#include "nlohmann/json.hpp"
-#include "utils/include/debug.hpp"
+#include "json-writer.hpp"
+#include "log.hpp"
+#include "metrics.hpp"
 #include "utils/include/error.hpp"
 
-bool Telegram::parseUpdatesUnlocked(const std::string &buffer)
+namespace
 {
-    try
+    Metrics::Counter &filteredUpdates()
     {
-        nlohmann::json json = nlohmann::json::parse(buffer);
-        JSONValidator jval(__FILE__, __LINE__, __func__);
-
-        jval.getArray(json, "result");
-
-        nlohmann::json &jsonResult = json["result"];
-
-        if (jsonResult.empty())
-            return false;
+        static Metrics::Counter &filtered = Metrics::global().counter("tessergram_updates_filtered_total", "", "Updates acknowledged without parsing because the prefilter rejected them");
+        return filtered;
+    }
+}
 
-        long long updateId = 0;
-        for (const nlohmann::json &el : jsonResult)
+bool Telegram::queueUpdatesUnlocked(const std::string &buffer, bool dedupe, std::size_t &received)
+{
+    std::size_t queued = this->messages.size();
+    std::size_t scanned = 0;
+    received = 0;
+    bool prefilter = !this->filter.empty();
+    JSONReader::Status status = this->decoder.decodeUpdates(
+        buffer,
+        [&](const UpdateFilter::Scan &scan) -> NodeMessage *
         {
-            try
+            scanned++;
+            // polling: already parsed, e.g. redelivered after a failed request
+            if (dedupe && scan.updateId <= this->lastUpdateId)
+                return nullptr;
+            // only new updates count towards the batch size the limit adapts to
+            received++;
+            // skipped updates count as seen so they are acknowledged too
+            if (this->lastUpdateId < scan.updateId)
+                this->lastUpdateId = scan.updateId;
+            if (prefilter && !this->filter.accept(scan))
             {
-                this->messages.emplace_back();
-                updateId = jval.get<long long>(el, "update_id");
-                this->messages.back().parse(el);
-                if (this->lastUpdateId < updateId)
-                    this->lastUpdateId = updateId;
+                filteredUpdates().add();
+                return nullptr;
             }
-            catch (const std::exception &e)
-            {
-                this->messages.pop_back();
-                Debug::log(Debug::WARNING, __FILE__, __LINE__, __func__, "skip: %s!\n", e.what());
-            }
-        }
-        return true;
-    }
-    catch (const std::exception &e)
-    {
-        Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "parse failed: %s!\n", e.what());
-    }
-    return false;
+            this->messages.emplace_back();
+            return &this->messages.back();
+        },
+        [&](NodeMessage &message, JSONReader::Status status)
+        {
+            if (status == JSONReader::Status::OK)
+                return;
+            this->messages.pop_back();
+            // kinds the bot does not model are common (edited_message, polls, ...)
+            if (status != JSONReader::Status::UNKNOWN_KIND)
+                TG_LOG(Log::WARNING, "skip %lld: %s!\n", message.getId(), JSONReader::statusToString(status));
+        },
+        prefilter);
+    if (status != JSONReader::Status::OK)
+        TG_LOG(Log::ERROR, "parse failed: %s!\n", JSONReader::statusToString(status));
+    this->trackQueueDepth(static_cast<long long>(this->messages.size() - queued));
+    return status == JSONReader::Status::OK && scanned > 0;
+}
+
+bool Telegram::parseUpdatesUnlocked(const std::string &buffer)
+{
+    std::size_t received = 0;
+    bool queued = this->queueUpdatesUnlocked(buffer, true, received);
+    this->controller.observeFetched(received);
+    return queued;
 }
 
 bool Telegram::parseGetUpdatesResponse(const std::string &buffer)
@@ -54,27 +74,77 @@ bool Telegram::parseGetUpdatesResponse(const std::string &buffer)
     return this->parseUpdatesUnlocked(buffer);
 }
 
+bool Telegram::parseWebhookUpdate(const std::string &body)
+{
+    // a delivery is one Update; several connections may deliver out of
+    // order, so nothing is dropped by update id here
+    std::lock_guard<std::mutex> guard(this->mutex);
+    std::size_t queued = this->messages.size();
+    std::size_t received = 0;
+    this->queueUpdatesUnlocked(body, false, received);
+    return this->messages.size() > queued;
+}
+
+bool Telegram::parseWebhookUpdate(const std::string &body, NodeMessage &message)
+{
+    long long updateId = 0;
+    JSONReader::Status status = JSONReader::Status::UNKNOWN_KIND;
+    bool prefilter = false;
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        prefilter = !this->filter.empty();
+    }
+    JSONReader::Status result = this->decoder.decodeUpdates(
+        body,
+        [&](const UpdateFilter::Scan &scan) -> NodeMessage *
+        {
+            updateId = scan.updateId;
+            if (prefilter)
+            {
+                std::lock_guard<std::mutex> guard(this->mutex);
+                if (!this->filter.accept(scan))
+                {
+                    filteredUpdates().add();
+                    return nullptr;
+                }
+            }
+            return &message;
+        },
+        [&](NodeMessage &, JSONReader::Status decoded)
+        {
+            status = decoded;
+        },
+        prefilter);
+    if (updateId > 0)
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        if (this->lastUpdateId < updateId)
+            this->lastUpdateId = updateId;
+    }
+    if (result != JSONReader::Status::OK)
+        status = result;
+    if (status == JSONReader::Status::OK)
+        return true;
+    if (status != JSONReader::Status::UNKNOWN_KIND)
+        TG_LOG(Log::WARNING, "skip: %s!\n", JSONReader::statusToString(status));
+    return false;
+}
+
 bool Telegram::apiGetMe()
 {
-    Request req(TELEGRAM_BASE_URL, this->token, Request::Type::CONFIG);
+    Request req(this->endpoint, Request::Type::CONFIG);
     if (req.isSuccess())
     {
-        try
+        User me;
+        JSONReader::Status status = this->decoder.decodeResult(req.getResponse(), me);
+        if (status == JSONReader::Status::OK)
         {
-            nlohmann::json json = nlohmann::json::parse(req.getResponse());
-            JSONValidator jval(__FILE__, __LINE__, __func__);
-
-            nlohmann::json jsonResult = jval.getObject(json, "result");
-
-            this->id = jval.get<long long>(jsonResult, "id", "result");
-            this->name = jval.get<std::string>(jsonResult, "first_name", "result");
-            this->username = jval.get<std::string>(jsonResult, "username", "result");
+            this->id = me.id;
+            this->name = me.firstName;
+            this->username = me.username;
             return true;
         }
-        catch (const std::exception &e)
-        {
-            Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "parse failed: %s!\n", e.what());
-        }
+        TG_LOG(Log::ERROR, "parse failed: %s!\n", JSONReader::statusToString(status));
     }
     return false;
 }
@@ -82,10 +152,27 @@ bool Telegram::apiGetMe()
 bool Telegram::apiGetUpdates()
 {
     std::lock_guard<std::mutex> guard(this->mutex);
-    if (this->lastUpdateId > 0)
+    long long offset = this->nextOffset();
+    int limit = this->controller.getLimit();
+    if (offset > 0 || this->longPollTimeout > 0 || limit > 0 || this->hasAllowedUpdates)
     {
-        std::string data = "{\"offset\":" + std::to_string(this->lastUpdateId + 1) + "}";
-        Request req(TELEGRAM_BASE_URL, this->token, Request::Type::UPDATES, data);
+        JSONWriter &json = JSONWriter::local();
+        json.beginObject();
+        if (offset > 0)
+            json.field("offset", offset);
+        if (this->longPollTimeout > 0)
+            json.field("timeout", this->longPollTimeout);
+        if (limit > 0)
+            json.field("limit", limit);
+        if (this->hasAllowedUpdates)
+        {
+            json.key("allowed_updates").beginArray();
+            for (const std::string &update : this->allowedUpdates)
+                json.value(update);
+            json.endArray();
+        }
+        json.endObject();
+        Request req(this->endpoint, Request::Type::UPDATES, json.str());
         if (req.isSuccess())
         {
             return this->parseUpdatesUnlocked(req.getResponse());
@@ -93,7 +180,7 @@ bool Telegram::apiGetUpdates()
     }
     else
     {
-        Request req(TELEGRAM_BASE_URL, this->token, Request::Type::UPDATES);
+        Request req(this->endpoint, Request::Type::UPDATES);
         if (req.isSuccess())
         {
             return this->parseUpdatesUnlocked(req.getResponse());
@@ -102,30 +189,57 @@ bool Telegram::apiGetUpdates()
     return false;
 }
 
-bool Telegram::apiSendMessage(long long targetId, const std::string &message)
+void Telegram::parseSentMessage(const std::string &buffer, Message &result) const
+{
+    // the request already succeeded; an unreadable result only leaves `result` empty
+    JSONReader::Status status = this->decoder.decodeResult(buffer, result);
+    if (status != JSONReader::Status::OK)
+    {
+        TG_LOG(Log::ERROR, "parse failed: %s!\n", JSONReader::statusToString(status));
+        result.reset();
+    }
+}
+
+bool Telegram::sendMessageImpl(long long targetId, const std::string &message, Message *result)
 {
-    nlohmann::json json;
-    json["chat_id"] = targetId;
-    json["text"] = message;
-    Request req(TELEGRAM_BASE_URL, this->token, Request::Type::SEND_MESSAGE, json.dump());
+    JSONWriter &json = JSONWriter::local();
+    json.beginObject()
+        .field("chat_id", targetId)
+        .field("text", message)
+        .endObject();
+    Request req(this->endpoint, Request::Type::SEND_MESSAGE, json.str());
     if (req.isSuccess())
     {
-        Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "success\n");
+        TG_LOG(Log::INFO, "success\n");
+        if (result != nullptr)
+            this->parseSentMessage(req.getResponse(), *result);
         return true;
     }
     return false;
 }
 
+bool Telegram::apiSendMessage(long long targetId, const std::string &message)
+{
+    return this->sendMessageImpl(targetId, message, nullptr);
+}
+
+bool Telegram::apiSendMessage(long long targetId, const std::string &message, Message &result)
+{
+    return this->sendMessageImpl(targetId, message, &result);
+}
+
 bool Telegram::apiEditMessageText(long long targetId, long long messageId, const std::string &message)
 {
-    nlohmann::json json;
-    json["chat_id"] = targetId;
-    json["message_id"] = messageId;
-    json["text"] = message;
-    Request req(TELEGRAM_BASE_URL, this->token, Request::Type::EDIT_MESSAGE_TEXT, json.dump());
+    JSONWriter &json = JSONWriter::local();
+    json.beginObject()
+        .field("chat_id", targetId)
+        .field("message_id", messageId)
+        .field("text", message)
+        .endObject();
+    Request req(this->endpoint, Request::Type::EDIT_MESSAGE_TEXT, json.str());
     if (req.isSuccess())
     {
-        Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "success\n");
+        TG_LOG(Log::INFO, "success\n");
         return true;
     }
     return false;
@@ -133,12 +247,16 @@ bool Telegram::apiEditMessageText(long long targetId, long long messageId, const
 
 bool Telegram::apiSendChatAction(long long targetId, Chat::Action action)
 {
-    std::string data = "{\"chat_id\":" + std::to_string(targetId) + ",\"action\":\"" + Chat::actionToString(action) + "\"}";
-    Request req(TELEGRAM_BASE_URL, this->token, Request::Type::SEND_CHAT_ACTION, data);
+    JSONWriter &json = JSONWriter::local();
+    json.beginObject()
+        .field("chat_id", targetId)
+        .field("action", Chat::actionToString(action))
+        .endObject();
+    Request req(this->endpoint, Request::Type::SEND_CHAT_ACTION, json.str());
     if (req.isSuccess())
     {
 
-        Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "success\n");
+        TG_LOG(Log::INFO, "success\n");
         return true;
     }
     return false;
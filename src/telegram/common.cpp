@@ -1,29 +1,31 @@
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <cstring>
 #include "telegram.hpp"
 #include "polling-controller.hpp"
 #include "request.hpp"
+#include "metrics.hpp"
+#include "json-writer.hpp"
+#include "log.hpp"
 #include "utils/include/debug.hpp"
 
-Telegram::Telegram() : controller(3000, 10000), messages(), mutex()
+Telegram::Telegram() : Telegram("")
 {
-    this->id = 0;
-    this->lastUpdateId = 0;
-    this->name = "";
-    this->username = "";
-    this->token = "";
-    this->webhookCallback = nullptr;
 }
 
-Telegram::Telegram(const std::string &token) : controller(3000, 10000), messages(), mutex()
+Telegram::Telegram(const std::string &token) : Telegram(token, TELEGRAM_BASE_URL)
+{
+}
+
+Telegram::Telegram(const std::string &token, const std::string &baseUrl) : committedUpdateId(0), handledUpdateId(0), endpoint(baseUrl, token), offsetStore(), commitHold(), messages(), hasAllowedUpdates(false), controller(3000, 10000), running(false), stopRequested(false), pipelining(false), longPollTimeout(0), batchReady(false), mutex()
 {
     this->id = 0;
     this->lastUpdateId = 0;
     this->name = "";
     this->username = "";
-    this->token = token;
     this->webhookCallback = nullptr;
+    this->webhookReplyCallback = nullptr;
 }
 
 Telegram::~Telegram()
@@ -32,7 +34,18 @@ Telegram::~Telegram()
 
 void Telegram::setToken(const std::string &token)
 {
-    this->token = token;
+    this->endpoint.configure(this->endpoint.getBaseUrl(), token);
+}
+
+void Telegram::setBaseUrl(const std::string &baseUrl)
+{
+    // e.g. a local Bot API server or MockBotApi; not safe while requests are in flight
+    this->endpoint.configure(baseUrl, this->endpoint.getToken());
+}
+
+const std::string &Telegram::getBaseUrl() const
+{
+    return this->endpoint.getBaseUrl();
 }
 
 long long Telegram::getId() const
@@ -60,20 +73,23 @@ void Telegram::info() const
 void Telegram::clearUpdates()
 {
     std::lock_guard<std::mutex> guard(this->mutex);
-    if (this->lastUpdateId > 0)
+    if (this->nextOffset() > 0)
     {
-        std::string data = "{\"offset\":" + std::to_string(this->lastUpdateId + 1) + "}";
-        Request req(TELEGRAM_BASE_URL, this->token, Request::Type::UPDATES, data);
+        JSONWriter &json = JSONWriter::local();
+        json.beginObject().field("offset", this->nextOffset()).endObject();
+        Request req(this->endpoint, Request::Type::UPDATES, json.str());
         if (req.isSuccess())
             this->parseUpdatesUnlocked(req.getResponse());
     }
     else
     {
-        Request req(TELEGRAM_BASE_URL, this->token, Request::Type::UPDATES);
+        Request req(this->endpoint, Request::Type::UPDATES);
         if (req.isSuccess())
             this->parseUpdatesUnlocked(req.getResponse());
     }
+    this->trackQueueDepth(-static_cast<long long>(this->messages.size()));
     this->messages.clear();
+    this->commitOffset(this->lastUpdateId);
 }
 
 bool Telegram::getUpdates(std::function<void(Telegram &, const NodeMessage &)> handler)
@@ -81,21 +97,234 @@ bool Telegram::getUpdates(std::function<void(Telegram &, const NodeMessage &)> h
     if (this->apiGetUpdates())
     {
         std::lock_guard<std::mutex> guard(this->mutex);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
         for (const NodeMessage &message : this->messages)
         {
-            handler(*this, message);
+            this->runHandler(handler, message, false);
         }
+        this->controller.observeHandled(this->messages.size(), std::chrono::steady_clock::now() - start);
+        this->trackQueueDepth(-static_cast<long long>(this->messages.size()));
         this->messages.clear();
+        this->commitOffset(this->lastUpdateId);
         return true;
     }
     return false;
 }
 
+bool Telegram::pollOnce(const std::function<void(Telegram &, const NodeMessage &)> &handler)
+{
+    std::size_t handled = 0;
+    bool success = this->getUpdates(
+        [&](Telegram &telegram, const NodeMessage &message)
+        {
+            handled++;
+            handler(telegram, message);
+        });
+    this->controller.observe(handled);
+    return success;
+}
+
 void Telegram::getUpdatesPoll(std::function<void(Telegram &, const NodeMessage &)> handler)
 {
     controller.run(
         [&]()
         {
-            return this->getUpdates(handler);
+            return this->pollOnce(handler);
         });
+}
+
+void Telegram::run(std::function<void(Telegram &, const NodeMessage &)> handler)
+{
+    if (!this->beginRun())
+        return;
+    try
+    {
+        if (this->pipelining)
+            this->runPipelined(handler, nullptr);
+        while (this->running)
+        {
+            controller.run(
+                [&]()
+                {
+                    return this->pollOnce(handler);
+                });
+        }
+    }
+    catch (...)
+    {
+        // a throwing handler ends the run like stop() would
+        this->endRun();
+        throw;
+    }
+    this->endRun();
+}
+
+void Telegram::runFor(int durationMs, std::function<void(Telegram &, const NodeMessage &)> handler)
+{
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(durationMs);
+    if (!this->beginRun())
+        return;
+    try
+    {
+        if (this->pipelining)
+            this->runPipelined(handler, &deadline);
+        while (this->running && std::chrono::steady_clock::now() < deadline)
+        {
+            controller.runUntil(deadline,
+                                [&]()
+                                {
+                                    return this->pollOnce(handler);
+                                });
+        }
+    }
+    catch (...)
+    {
+        this->endRun();
+        throw;
+    }
+    this->endRun();
+}
+
+bool Telegram::beginRun()
+{
+    // running is raised before the pending stop is checked: a stop() racing
+    // with this either leaves its flag for the check or lowers running after it
+    this->controller.resume();
+    this->running = true;
+    if (this->stopRequested.exchange(false))
+    {
+        this->running = false;
+        this->controller.resume();
+        return false;
+    }
+    return true;
+}
+
+void Telegram::endRun()
+{
+    // the stop that ended this run must not also end the next one, nor
+    // cancel a later poll
+    this->running = false;
+    this->stopRequested = false;
+    this->controller.resume();
+    if (this->offsetStore)
+        this->offsetStore->flush();
+}
+
+void Telegram::stop()
+{
+    this->stopRequested = true;
+    this->running = false;
+    this->controller.cancel();
+    {
+        std::lock_guard<std::mutex> guard(this->pipelineMutex);
+    }
+    this->pipelineSignal.notify_all();
+}
+
+bool Telegram::isRunning() const
+{
+    return this->running;
+}
+
+void Telegram::setPipelining(bool enabled)
+{
+    this->pipelining = enabled;
+}
+
+void Telegram::setLongPollTimeout(int seconds)
+{
+    // must stay below the transport timeout used by Request
+    this->longPollTimeout = std::max(0, std::min(seconds, 10));
+}
+
+void Telegram::setMinPollInterval(int milliseconds)
+{
+    // floor for the interval while updates keep arriving
+    this->controller.setMinInterval(milliseconds);
+}
+
+void Telegram::setOffsetStore(std::shared_ptr<OffsetStore> store)
+{
+    // not synchronised with the dispatcher: attach the store before polling starts
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->offsetStore = store;
+    if (!this->offsetStore)
+        return;
+
+    long long stored = this->offsetStore->load();
+    if (stored > this->committedUpdateId)
+        this->committedUpdateId = stored;
+    if (stored > this->lastUpdateId)
+        this->lastUpdateId = stored;
+    TG_LOG(Log::INFO, "resuming after update %lli\n", stored);
+}
+
+void Telegram::setUpdateFilter(const UpdateFilter &filter)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->filter = filter;
+}
+
+void Telegram::setAllowedUpdates(const std::vector<std::string> &updates)
+{
+    // sent with every getUpdates; an empty list restores the server default
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->allowedUpdates = updates;
+    this->hasAllowedUpdates = true;
+}
+
+void Telegram::setPollLimit(int minLimit, int maxLimit)
+{
+    this->controller.setLimitRange(minLimit, maxLimit);
+}
+
+long long Telegram::getCommittedUpdateId() const
+{
+    return this->committedUpdateId;
+}
+
+void Telegram::setCommitHold(std::function<long long()> hold)
+{
+    // not synchronised with the dispatcher: set the hold before polling starts
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->commitHold = std::move(hold);
+}
+
+void Telegram::commitOffset(long long updateId)
+{
+    // updates a later stage still holds (e.g. album parts) must survive a crash
+    long long held = this->commitHold ? this->commitHold() : 0;
+    if (held > 0 && updateId >= held)
+        updateId = held - 1;
+    if (updateId <= this->committedUpdateId)
+        return;
+    this->committedUpdateId = updateId;
+    if (this->offsetStore)
+        this->offsetStore->commit(updateId);
+}
+
+long long Telegram::nextOffset() const
+{
+    // acknowledge only what the handlers have finished with; anything fetched
+    // but not committed is delivered again after a restart
+    long long committed = this->committedUpdateId;
+    return committed > 0 ? committed + 1 : 0;
+}
+
+void Telegram::trackQueueDepth(long long delta) const
+{
+    static Metrics::Gauge &depth = Metrics::global().gauge("tessergram_queue_depth", "", "Parsed updates waiting for their handler");
+    depth.add(delta);
+}
+
+void Telegram::runHandler(const std::function<void(Telegram &, const NodeMessage &)> &handler, const NodeMessage &message, bool fromWebhook)
+{
+    static Metrics::Histogram &polling = Metrics::global().histogram("tessergram_handler_duration_seconds", "source=\"polling\"", "Update handler execution time");
+    static Metrics::Histogram &webhook = Metrics::global().histogram("tessergram_handler_duration_seconds", "source=\"webhook\"", "Update handler execution time");
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    handler(*this, message);
+    (fromWebhook ? webhook : polling)
+        .observeMicros(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()));
 }
\ No newline at end of file
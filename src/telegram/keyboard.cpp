@@ -3,7 +3,8 @@
 #include <cstring>
 #include "telegram.hpp"
 #include "request.hpp"
-#include "utils/include/debug.hpp"
+#include "json-writer.hpp"
+#include "log.hpp"
 #include "utils/include/error.hpp"
 #include "json-validator.hpp"
 #include "nlohmann/json.hpp"
@@ -145,101 +146,107 @@ const std::vector<std::vector<TKeyboard::TKeyButton>> &TKeyboard::getInlineButto
     return this->inlineButtons;
 }
 
-bool Telegram::apiSendKeyboard(long long targetId, const TKeyboard &keyboard)
+static void writeInlineKeyboard(JSONWriter &json, const std::vector<std::vector<TKeyboard::TKeyButton>> &buttons)
+{
+    json.key("inline_keyboard").beginArray();
+    for (const std::vector<TKeyboard::TKeyButton> &row : buttons)
+    {
+        json.beginArray();
+        for (const TKeyboard::TKeyButton &button : row)
+        {
+            json.beginObject()
+                .field("text", button.getText())
+                .field((button.getType() == TKeyboard::TKeyButton::Type::URL ? "url" : "callback_data"), button.getValue())
+                .endObject();
+        }
+        json.endArray();
+    }
+    json.endArray();
+}
+
+bool Telegram::sendKeyboardImpl(long long targetId, const TKeyboard &keyboard, Message *result)
 {
-    std::vector<std::vector<std::string>> commonButtons = keyboard.getCommonButton();
-    std::vector<std::vector<TKeyboard::TKeyButton>> inlineButtons = keyboard.getInlineButton();
+    const std::vector<std::vector<std::string>> &commonButtons = keyboard.getCommonButton();
+    const std::vector<std::vector<TKeyboard::TKeyButton>> &inlineButtons = keyboard.getInlineButton();
 
-    nlohmann::json jsonButton = nlohmann::json::array();
-    nlohmann::json jsonKeyboard;
+    if (commonButtons.empty() && inlineButtons.empty())
+    {
+        TG_LOG(Log::ERROR, "invalid keyboard!\n");
+        return false;
+    }
+
+    JSONWriter &json = JSONWriter::local();
+    json.beginObject()
+        .field("chat_id", targetId)
+        .field("text", keyboard.getCaption())
+        .key("reply_markup")
+        .beginObject();
 
     if (commonButtons.empty() == false)
     {
+        json.key("keyboard").beginArray();
         for (const std::vector<std::string> &row : commonButtons)
         {
-            nlohmann::json arr = nlohmann::json::array();
+            json.beginArray();
             for (const std::string &button : row)
             {
-                arr.push_back(button);
-            }
-            jsonButton.push_back(arr);
-        }
-        jsonKeyboard["keyboard"] = jsonButton;
-    }
-    else if (inlineButtons.empty() == false)
-    {
-        for (const std::vector<TKeyboard::TKeyButton> &row : inlineButtons)
-        {
-            nlohmann::json arr = nlohmann::json::array();
-            for (const TKeyboard::TKeyButton &button : row)
-            {
-                nlohmann::json j = {
-                    {"text", button.getText()},
-                    {(button.getType() == TKeyboard::TKeyButton::Type::URL ? "url" : "callback_data"), button.getValue()}};
-                arr.push_back(j);
+                json.value(button);
             }
-            jsonButton.push_back(arr);
+            json.endArray();
         }
-        jsonKeyboard["inline_keyboard"] = jsonButton;
+        json.endArray();
     }
     else
     {
-        Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "invalid keyboard!\n");
-        return false;
+        writeInlineKeyboard(json, inlineButtons);
     }
+    json.endObject().endObject();
 
-    nlohmann::json json = {
-        {"chat_id", targetId},
-        {"text", keyboard.getCaption()},
-        {"reply_markup", jsonKeyboard}};
-
-    Request req(TELEGRAM_BASE_URL, this->token, Request::Type::SEND_MESSAGE, json.dump());
+    Request req(this->endpoint, Request::Type::SEND_MESSAGE, json.str());
     if (req.isSuccess())
     {
-        Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "success\n");
+        TG_LOG(Log::INFO, "success\n");
+        if (result != nullptr)
+            this->parseSentMessage(req.getResponse(), *result);
         return true;
     }
     return false;
 }
 
+bool Telegram::apiSendKeyboard(long long targetId, const TKeyboard &keyboard)
+{
+    return this->sendKeyboardImpl(targetId, keyboard, nullptr);
+}
+
+bool Telegram::apiSendKeyboard(long long targetId, const TKeyboard &keyboard, Message &result)
+{
+    return this->sendKeyboardImpl(targetId, keyboard, &result);
+}
+
 bool Telegram::apiEditInlineKeyboard(long long targetId, long long messageId, const TKeyboard &keyboard)
 {
-    std::vector<std::vector<TKeyboard::TKeyButton>> buttons = keyboard.getInlineButton();
+    const std::vector<std::vector<TKeyboard::TKeyButton>> &buttons = keyboard.getInlineButton();
 
     if (buttons.empty())
     {
-        Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "invalid keyboard!\n");
+        TG_LOG(Log::ERROR, "invalid keyboard!\n");
         return false;
     }
 
-    nlohmann::json jsonButton = nlohmann::json::array();
-
-    for (const std::vector<TKeyboard::TKeyButton> &row : buttons)
-    {
-        nlohmann::json arr = nlohmann::json::array();
-        for (const TKeyboard::TKeyButton &button : row)
-        {
-            nlohmann::json j = {
-                {"text", button.getText()},
-                {(button.getType() == TKeyboard::TKeyButton::Type::URL ? "url" : "callback_data"), button.getValue()}};
-            arr.push_back(j);
-        }
-        jsonButton.push_back(arr);
-    }
-
-    nlohmann::json jsonKeyboard = {
-        {"inline_keyboard", jsonButton}};
-
-    nlohmann::json json = {
-        {"chat_id", targetId},
-        {"message_id", messageId},
-        {"text", keyboard.getCaption()},
-        {"reply_markup", jsonKeyboard}};
-
-    Request req(TELEGRAM_BASE_URL, this->token, Request::Type::EDIT_MESSAGE_TEXT, json.dump());
+    JSONWriter &json = JSONWriter::local();
+    json.beginObject()
+        .field("chat_id", targetId)
+        .field("message_id", messageId)
+        .field("text", keyboard.getCaption())
+        .key("reply_markup")
+        .beginObject();
+    writeInlineKeyboard(json, buttons);
+    json.endObject().endObject();
+
+    Request req(this->endpoint, Request::Type::EDIT_MESSAGE_TEXT, json.str());
     if (req.isSuccess())
     {
-        Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "success\n");
+        TG_LOG(Log::INFO, "success\n");
         return true;
     }
     return false;
@@ -6,9 +6,8 @@
 #include <cctype>
 #include "telegram.hpp"
 #include "request.hpp"
-#include "utils/include/debug.hpp"
-#include "json-validator.hpp"
-#include "nlohmann/json.hpp"
+#include "json-writer.hpp"
+#include "log.hpp"
 
 static std::string getFileExtension(const std::string &filename)
 {
@@ -84,75 +83,165 @@ namespace
         {Media::Type::VIDEO,     Request::Type::SEND_VIDEO}};
 }
 
-bool Telegram::sendMediaImpl(long long targetId, Media::Type type, const std::string &label, const std::string &filePath)
+bool Telegram::sendMediaImpl(long long targetId, Media::Type type, const std::string &label, const std::string &filePath, Message *result)
 {
     auto it = mediaRequestMap.find(type);
     if (it == mediaRequestMap.end())
     {
-        Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "unsupported media type\n");
+        TG_LOG(Log::ERROR, "unsupported media type\n");
         return false;
     }
     const Request::Type raction = it->second;
 
-    nlohmann::json mimeArray = {
-        {{"name", "chat_id"}, {"is_file", false}, {"data", std::to_string(targetId)}},
-        {{"name", "caption"}, {"is_file", false}, {"data", label}},
-        {{"name", Media::typeToString(type)}, {"is_file", true}, {"data", filePath}, {"type", getMimeType(filePath)}}};
-    Request req(TELEGRAM_BASE_URL, this->token, raction, mimeArray);
+    JSONWriter &mimeArray = JSONWriter::local();
+    mimeArray.beginArray()
+        .beginObject().field("name", "chat_id").field("is_file", false).field("data", std::to_string(targetId)).endObject()
+        .beginObject().field("name", "caption").field("is_file", false).field("data", label).endObject()
+        .beginObject().field("name", Media::typeToString(type)).field("is_file", true).field("data", filePath).field("type", getMimeType(filePath)).endObject()
+        .endArray();
+    Request req(this->endpoint, raction, mimeArray);
     if (req.isSuccess())
     {
-        Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "success\n");
+        TG_LOG(Log::INFO, "success\n");
+        if (result != nullptr)
+            this->parseSentMessage(req.getResponse(), *result);
         return true;
     }
     return false;
 }
 
+// a file_id or URL goes out as plain JSON; Telegram fetches or reuses the file itself
+bool Telegram::sendMediaRefImpl(long long targetId, Media::Type type, const std::string &label, const std::string &ref, Message *result)
+{
+    auto it = mediaRequestMap.find(type);
+    if (it == mediaRequestMap.end())
+    {
+        TG_LOG(Log::ERROR, "unsupported media type\n");
+        return false;
+    }
+
+    JSONWriter &json = JSONWriter::local();
+    json.beginObject()
+        .field("chat_id", targetId)
+        .key(Media::typeToString(type))
+        .value(ref);
+    if (!label.empty())
+        json.field("caption", label);
+    json.endObject();
+    Request req(this->endpoint, it->second, json.str());
+    if (req.isSuccess())
+    {
+        TG_LOG(Log::INFO, "success\n");
+        if (result != nullptr)
+            this->parseSentMessage(req.getResponse(), *result);
+        return true;
+    }
+    return false;
+}
+
+bool Telegram::apiSendMediaById(long long targetId, Media::Type type, const std::string &label, const std::string &fileId)
+{
+    return this->sendMediaRefImpl(targetId, type, label, fileId, nullptr);
+}
+
+bool Telegram::apiSendMediaById(long long targetId, Media::Type type, const std::string &label, const std::string &fileId, Message &result)
+{
+    return this->sendMediaRefImpl(targetId, type, label, fileId, &result);
+}
+
+bool Telegram::apiSendMediaByUrl(long long targetId, Media::Type type, const std::string &label, const std::string &url)
+{
+    return this->sendMediaRefImpl(targetId, type, label, url, nullptr);
+}
+
+bool Telegram::apiSendMediaByUrl(long long targetId, Media::Type type, const std::string &label, const std::string &url, Message &result)
+{
+    return this->sendMediaRefImpl(targetId, type, label, url, &result);
+}
+
+bool Telegram::apiSendMedia(long long targetId, const Media &media, const std::string &label)
+{
+    return this->sendMediaRefImpl(targetId, media.type, label, media.fileId, nullptr);
+}
+
+bool Telegram::apiSendMedia(long long targetId, const Media &media, const std::string &label, Message &result)
+{
+    return this->sendMediaRefImpl(targetId, media.type, label, media.fileId, &result);
+}
+
 bool Telegram::apiSendDocument(long long targetId, const std::string &label, const std::string &filePath)
 {
-    return this->sendMediaImpl(targetId, Media::Type::DOCUMENT, label, filePath);
+    return this->sendMediaImpl(targetId, Media::Type::DOCUMENT, label, filePath, nullptr);
+}
+
+bool Telegram::apiSendDocument(long long targetId, const std::string &label, const std::string &filePath, Message &result)
+{
+    return this->sendMediaImpl(targetId, Media::Type::DOCUMENT, label, filePath, &result);
 }
 
 bool Telegram::apiSendPhoto(long long targetId, const std::string &label, const std::string &filePath)
 {
-    return this->sendMediaImpl(targetId, Media::Type::PHOTO, label, filePath);
+    return this->sendMediaImpl(targetId, Media::Type::PHOTO, label, filePath, nullptr);
+}
+
+bool Telegram::apiSendPhoto(long long targetId, const std::string &label, const std::string &filePath, Message &result)
+{
+    return this->sendMediaImpl(targetId, Media::Type::PHOTO, label, filePath, &result);
 }
+
 bool Telegram::apiSendAudio(long long targetId, const std::string &label, const std::string &filePath)
 {
-    return this->sendMediaImpl(targetId, Media::Type::AUDIO, label, filePath);
+    return this->sendMediaImpl(targetId, Media::Type::AUDIO, label, filePath, nullptr);
+}
+
+bool Telegram::apiSendAudio(long long targetId, const std::string &label, const std::string &filePath, Message &result)
+{
+    return this->sendMediaImpl(targetId, Media::Type::AUDIO, label, filePath, &result);
 }
+
 bool Telegram::apiSendVoice(long long targetId, const std::string &label, const std::string &filePath)
 {
-    return this->sendMediaImpl(targetId, Media::Type::VOICE, label, filePath);
+    return this->sendMediaImpl(targetId, Media::Type::VOICE, label, filePath, nullptr);
 }
+
+bool Telegram::apiSendVoice(long long targetId, const std::string &label, const std::string &filePath, Message &result)
+{
+    return this->sendMediaImpl(targetId, Media::Type::VOICE, label, filePath, &result);
+}
+
 bool Telegram::apiSendAnimation(long long targetId, const std::string &label, const std::string &filePath)
 {
-    return this->sendMediaImpl(targetId, Media::Type::ANIMATION, label, filePath);
+    return this->sendMediaImpl(targetId, Media::Type::ANIMATION, label, filePath, nullptr);
 }
+
+bool Telegram::apiSendAnimation(long long targetId, const std::string &label, const std::string &filePath, Message &result)
+{
+    return this->sendMediaImpl(targetId, Media::Type::ANIMATION, label, filePath, &result);
+}
+
 bool Telegram::apiSendVideo(long long targetId, const std::string &label, const std::string &filePath)
 {
-    return this->sendMediaImpl(targetId, Media::Type::VIDEO, label, filePath);
+    return this->sendMediaImpl(targetId, Media::Type::VIDEO, label, filePath, nullptr);
+}
+
+bool Telegram::apiSendVideo(long long targetId, const std::string &label, const std::string &filePath, Message &result)
+{
+    return this->sendMediaImpl(targetId, Media::Type::VIDEO, label, filePath, &result);
 }
 
 std::string Telegram::apiGetMediaPath(const std::string &fileId)
 {
-    nlohmann::json data;
-    data["file_id"] = fileId;
-    Request req(TELEGRAM_BASE_URL, this->token, Request::Type::GET_MEDIA_PATH, data.dump());
+    JSONWriter &data = JSONWriter::local();
+    data.beginObject().field("file_id", fileId).endObject();
+    Request req(this->endpoint, Request::Type::GET_MEDIA_PATH, data.str());
     if (req.isSuccess())
     {
-        Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "success\n");
-        try
-        {
-            nlohmann::json json = nlohmann::json::parse(req.getResponse());
-            JSONValidator jvalidator(__FILE__, __LINE__, __func__);
-
-            const nlohmann::json &jsonResult = jvalidator.getObject(json, "result");
-            return jvalidator.get<std::string>(jsonResult, "file_path");
-        }
-        catch (const std::exception &e)
-        {
-            Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "parse failed: %s!\n", e.what());
-        }
+        TG_LOG(Log::INFO, "success\n");
+        std::string mediaPath;
+        JSONReader::Status status = this->decoder.decodeResult(req.getResponse(), "file_path", mediaPath);
+        if (status == JSONReader::Status::OK)
+            return mediaPath;
+        TG_LOG(Log::INFO, "parse failed: %s!\n", JSONReader::statusToString(status));
     }
     return "";
 }
@@ -160,10 +249,10 @@ std::string Telegram::apiGetMediaPath(const std::string &fileId)
 std::vector<unsigned char> Telegram::apiDownloadMediaById(const std::string &fileId)
 {
     std::vector<unsigned char> result;
-    Request req(TELEGRAM_BASE_URL, this->token, Request::Type::DOWNLOAD_MEDIA_BY_FILE_ID, fileId, result);
+    Request req(this->endpoint, Request::Type::DOWNLOAD_MEDIA_BY_FILE_ID, fileId, result);
     if (req.isSuccess())
     {
-        Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "success\n");
+        TG_LOG(Log::INFO, "success\n");
     }
     return result;
 }
@@ -171,10 +260,10 @@ std::vector<unsigned char> Telegram::apiDownloadMediaById(const std::string &fil
 std::vector<unsigned char> Telegram::apiDownloadMediaByPath(const std::string &mediaPath)
 {
     std::vector<unsigned char> result;
-    Request req(TELEGRAM_BASE_URL, this->token, Request::Type::DOWNLOAD_MEDIA_BY_PATH, mediaPath, result);
+    Request req(this->endpoint, Request::Type::DOWNLOAD_MEDIA_BY_PATH, mediaPath, result);
     if (req.isSuccess())
     {
-        Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "success\n");
+        TG_LOG(Log::INFO, "success\n");
     }
     return result;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
+#include <stdexcept>
 #include "utils/include/debug.hpp"
-#include "json-validator.hpp"
+#include "utils/include/error.hpp"
 #include "nlohmann/json.hpp"
 #include "node-message.hpp"
 
@@ -16,34 +17,35 @@ NodeMessage::~NodeMessage()
 
 void NodeMessage::parse(const nlohmann::json &message)
 {
-    JSONValidator jval(__FILE__, __LINE__, __func__);
-
-    this->updateId = jval.get<long long>(message, "update_id");
-
-    jval.object(message, "callback_query")
-        .onValid(
-            [this](const nlohmann::json &jsonCallbackQuery)
-            {
-                this->callbackQuery.parse(jsonCallbackQuery);
-            })
-        .onNotFound(
-            [this](const nlohmann::json &jalt, const std::string &err)
-            {
-                JSONValidator mval(__FILE__, __LINE__, __func__);
-                mval.object(jalt, "message")
-                    .onValid(
-                        [this](const nlohmann::json &jsonMessage)
-                        {
-                            this->message.parse(jsonMessage);
-                        });
-            });
-
-    if (this->message.empty() && this->callbackQuery.empty())
+    JSONReader::Status status = this->tryParse(message);
+    if (status != JSONReader::Status::OK)
     {
-        throw std::runtime_error("Unknown type: " + message.dump() + "!");
+        throw std::runtime_error(Error::common(__FILE__, __LINE__, __func__, JSONReader::statusToString(status)));
     }
 }
 
+JSONReader::Status NodeMessage::tryParse(const nlohmann::json &message)
+{
+    this->updateId = 0;
+    this->callbackQuery.reset();
+    this->message.reset();
+
+    JSONReader::Status status = JSONReader::get(message, "update_id", this->updateId);
+    if (status != JSONReader::Status::OK)
+        return status;
+
+    const nlohmann::json *jsonCallbackQuery = JSONReader::object(message, "callback_query");
+    if (jsonCallbackQuery != nullptr)
+        return this->callbackQuery.tryParse(*jsonCallbackQuery);
+
+    const nlohmann::json *jsonMessage = JSONReader::object(message, "message");
+    if (jsonMessage != nullptr)
+        return this->message.tryParse(*jsonMessage);
+
+    // edited_message, my_chat_member, poll, ...: routine, not an error
+    return JSONReader::Status::UNKNOWN_KIND;
+}
+
 static void displayCallbackQuery(const CallbackQuery &cq, long long updateId, const char *dtimestr)
 {
     long long roomId = 0;
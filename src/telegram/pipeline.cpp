@@ -0,0 +1,175 @@
+#include <thread>
+#include "telegram.hpp"
+#include "log.hpp"
+
+/*
+ * Pipelined polling: a fetcher thread issues getUpdates (with the
+ * already-committed offset) as soon as the dispatcher has taken the previous
+ * batch, so the network wait of batch N+1 overlaps the handlers of batch N.
+ * Updates of batch N that come back again are dropped by the parser, and the
+ * offset of batch N is committed once its handlers have finished. At most
+ * one parsed batch is buffered ahead.
+ *
+ * The controller only paces the fetcher after a failed poll (backoff) or
+ * a poll that brought nothing new; after a hand-off the next request goes out
+ * immediately. A poll that only brought back the batch
+ * still being handled waits for its commit instead.
+ */
+void Telegram::runPipelined(const std::function<void(Telegram &, const NodeMessage &)> &handler, const std::chrono::steady_clock::time_point *deadline)
+{
+    {
+        std::lock_guard<std::mutex> guard(this->pipelineMutex);
+        this->batchReady = false;
+    }
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        this->handledUpdateId = this->lastUpdateId;
+    }
+
+    std::thread fetcher(
+        [this, deadline]()
+        {
+            bool succeeded = false;
+            bool handedOver = false;
+            long long inFlight = 0;
+            std::function<bool()> poll =
+                [this, &succeeded, &handedOver, &inFlight]()
+            {
+                long long before = 0;
+                {
+                    std::lock_guard<std::mutex> guard(this->mutex);
+                    before = this->lastUpdateId;
+                }
+                bool success = this->apiGetUpdates();
+                std::size_t fetched = 0;
+                bool acknowledged = false;
+                {
+                    std::lock_guard<std::mutex> guard(this->mutex);
+                    fetched = this->messages.size();
+                    acknowledged = this->lastUpdateId > before;
+                    inFlight = this->lastUpdateId > this->handledUpdateId ? this->lastUpdateId : 0;
+                }
+                this->controller.observe(fetched);
+                // a batch that was filtered or skipped entirely is still handed
+                // over (empty) so the dispatcher commits its offset in order
+                handedOver = fetched > 0 || acknowledged;
+                if (handedOver)
+                {
+                    {
+                        std::lock_guard<std::mutex> guard(this->pipelineMutex);
+                        this->batchReady = true;
+                    }
+                    this->pipelineSignal.notify_all();
+                }
+                succeeded = success;
+                return success;
+            };
+
+            bool immediate = false;
+            while (this->running)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(this->pipelineMutex);
+                    this->pipelineSignal.wait(lock,
+                                              [this]()
+                                              { return !this->batchReady || !this->running; });
+                }
+                if (!this->running)
+                    break;
+                if (deadline != nullptr && std::chrono::steady_clock::now() >= *deadline)
+                    break;
+
+                succeeded = false;
+                handedOver = false;
+                if (immediate)
+                    this->controller.runNow(poll);
+                else if (deadline != nullptr)
+                    this->controller.runUntil(*deadline, poll);
+                else
+                    this->controller.run(poll);
+                if (succeeded && !handedOver && inFlight > 0)
+                {
+                    // asking again before the commit returns the same updates
+                    std::unique_lock<std::mutex> lock(this->pipelineMutex);
+                    auto handled = [this, inFlight]()
+                    { return this->handledUpdateId >= inFlight || !this->running; };
+                    if (deadline != nullptr)
+                        this->pipelineSignal.wait_until(lock, *deadline, handled);
+                    else
+                        this->pipelineSignal.wait(lock, handled);
+                    immediate = true;
+                    continue;
+                }
+                // a poll that brought nothing new (an empty one fails, one
+                // that only repeats updates held below the commit succeeds)
+                // would spin, so then the controller decides when to poll
+                immediate = succeeded && handedOver;
+            }
+            TG_LOG(Log::INFO, "fetcher stopped\n");
+        });
+
+    // however the dispatcher leaves (deadline, stop or a throwing handler),
+    // the fetcher is joined and a batch fetched but not handled is dropped:
+    // it was never acknowledged, so the next poll fetches it again
+    auto finish = [this, &fetcher]()
+    {
+        this->stop();
+        fetcher.join();
+        std::lock_guard<std::mutex> guard(this->mutex);
+        this->trackQueueDepth(-static_cast<long long>(this->messages.size()));
+        this->messages.clear();
+        this->lastUpdateId = this->committedUpdateId;
+    };
+
+    try
+    {
+        while (this->running)
+        {
+            std::deque<NodeMessage> batch;
+            long long batchEnd = 0;
+            {
+                std::unique_lock<std::mutex> lock(this->pipelineMutex);
+                auto ready = [this]()
+                { return this->batchReady || !this->running; };
+                if (deadline != nullptr)
+                {
+                    if (!this->pipelineSignal.wait_until(lock, *deadline, ready))
+                        break;
+                }
+                else
+                {
+                    this->pipelineSignal.wait(lock, ready);
+                }
+                if (!this->batchReady)
+                    break;
+                this->batchReady = false;
+            }
+            {
+                std::lock_guard<std::mutex> guard(this->mutex);
+                batch.swap(this->messages);
+                batchEnd = this->lastUpdateId;
+            }
+            this->pipelineSignal.notify_all();
+
+            this->trackQueueDepth(-static_cast<long long>(batch.size()));
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (const NodeMessage &message : batch)
+            {
+                this->runHandler(handler, message, false);
+            }
+            this->controller.observeHandled(batch.size(), std::chrono::steady_clock::now() - start);
+            this->commitOffset(batchEnd);
+            {
+                std::lock_guard<std::mutex> guard(this->pipelineMutex);
+                this->handledUpdateId = batchEnd;
+            }
+            this->pipelineSignal.notify_all();
+        }
+    }
+    catch (...)
+    {
+        finish();
+        throw;
+    }
+    finish();
+}
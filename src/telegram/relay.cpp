@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <atomic>
+#include "telegram.hpp"
+#include "request.hpp"
+#include "json-writer.hpp"
+#include "log.hpp"
+#include "worker-pool.hpp"
+
+namespace
+{
+    // copyMessages, forwardMessages and deleteMessages take 1-100 ids per call
+    static const std::size_t MAX_BATCH_MESSAGES = 100;
+}
+
+bool Telegram::relayMessageImpl(Request::Type type, long long targetId, long long fromChatId, long long messageId, long long *resultId, Message *result)
+{
+    JSONWriter &json = JSONWriter::local();
+    json.beginObject()
+        .field("chat_id", targetId)
+        .field("from_chat_id", fromChatId)
+        .field("message_id", messageId)
+        .endObject();
+    Request req(this->endpoint, type, json.str());
+    if (!req.isSuccess())
+        return false;
+
+    TG_LOG(Log::INFO, "success\n");
+    if (result != nullptr)
+        this->parseSentMessage(req.getResponse(), *result);
+    if (resultId != nullptr)
+    {
+        JSONReader::Status status = this->decoder.decodeResult(req.getResponse(), "message_id", *resultId);
+        if (status != JSONReader::Status::OK)
+        {
+            TG_LOG(Log::ERROR, "parse failed: %s!\n", JSONReader::statusToString(status));
+            *resultId = 0;
+        }
+    }
+    return true;
+}
+
+bool Telegram::messageBatchImpl(Request::Type type, long long chatId, const long long *fromChatId, const std::vector<long long> &messageIds, std::vector<long long> *resultIds)
+{
+    // the API wants strictly increasing ids, which also keeps albums together
+    std::vector<long long> ids(messageIds);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    if (resultIds != nullptr)
+        resultIds->clear();
+
+    std::vector<long long> chunkIds;
+    bool parsed = true;
+    for (std::size_t first = 0; first < ids.size(); first += MAX_BATCH_MESSAGES)
+    {
+        std::size_t last = std::min(ids.size(), first + MAX_BATCH_MESSAGES);
+        JSONWriter &json = JSONWriter::local();
+        json.beginObject().field("chat_id", chatId);
+        if (fromChatId != nullptr)
+            json.field("from_chat_id", *fromChatId);
+        json.key("message_ids").beginArray();
+        for (std::size_t i = first; i < last; i++)
+            json.value(ids[i]);
+        json.endArray().endObject();
+
+        Request req(this->endpoint, type, json.str());
+        if (!req.isSuccess())
+            return false;
+        if (resultIds == nullptr || !parsed)
+            continue;
+        // the chunk went out either way; unreadable ids only leave resultIds empty
+        JSONReader::Status status = this->decoder.decodeResult(req.getResponse(), "message_id", chunkIds);
+        if (status != JSONReader::Status::OK)
+        {
+            TG_LOG(Log::ERROR, "parse failed: %s!\n", JSONReader::statusToString(status));
+            resultIds->clear();
+            parsed = false;
+            continue;
+        }
+        resultIds->insert(resultIds->end(), chunkIds.begin(), chunkIds.end());
+    }
+    TG_LOG(Log::INFO, "success\n");
+    return true;
+}
+
+bool Telegram::apiCopyMessage(long long targetId, long long fromChatId, long long messageId)
+{
+    return this->relayMessageImpl(Request::Type::COPY_MESSAGE, targetId, fromChatId, messageId, nullptr, nullptr);
+}
+
+bool Telegram::apiCopyMessage(long long targetId, long long fromChatId, long long messageId, long long &resultId)
+{
+    return this->relayMessageImpl(Request::Type::COPY_MESSAGE, targetId, fromChatId, messageId, &resultId, nullptr);
+}
+
+bool Telegram::apiForwardMessage(long long targetId, long long fromChatId, long long messageId)
+{
+    return this->relayMessageImpl(Request::Type::FORWARD_MESSAGE, targetId, fromChatId, messageId, nullptr, nullptr);
+}
+
+bool Telegram::apiForwardMessage(long long targetId, long long fromChatId, long long messageId, Message &result)
+{
+    return this->relayMessageImpl(Request::Type::FORWARD_MESSAGE, targetId, fromChatId, messageId, nullptr, &result);
+}
+
+bool Telegram::apiCopyMessages(long long targetId, long long fromChatId, const std::vector<long long> &messageIds)
+{
+    return this->messageBatchImpl(Request::Type::COPY_MESSAGES, targetId, &fromChatId, messageIds, nullptr);
+}
+
+bool Telegram::apiCopyMessages(long long targetId, long long fromChatId, const std::vector<long long> &messageIds, std::vector<long long> &resultIds)
+{
+    return this->messageBatchImpl(Request::Type::COPY_MESSAGES, targetId, &fromChatId, messageIds, &resultIds);
+}
+
+bool Telegram::apiForwardMessages(long long targetId, long long fromChatId, const std::vector<long long> &messageIds)
+{
+    return this->messageBatchImpl(Request::Type::FORWARD_MESSAGES, targetId, &fromChatId, messageIds, nullptr);
+}
+
+bool Telegram::apiForwardMessages(long long targetId, long long fromChatId, const std::vector<long long> &messageIds, std::vector<long long> &resultIds)
+{
+    return this->messageBatchImpl(Request::Type::FORWARD_MESSAGES, targetId, &fromChatId, messageIds, &resultIds);
+}
+
+bool Telegram::apiDeleteMessage(long long chatId, long long messageId)
+{
+    JSONWriter &json = JSONWriter::local();
+    json.beginObject()
+        .field("chat_id", chatId)
+        .field("message_id", messageId)
+        .endObject();
+    Request req(this->endpoint, Request::Type::DELETE_MESSAGE, json.str());
+    if (req.isSuccess())
+    {
+        TG_LOG(Log::INFO, "success\n");
+        return true;
+    }
+    return false;
+}
+
+bool Telegram::apiDeleteMessages(long long chatId, const std::vector<long long> &messageIds)
+{
+    return this->messageBatchImpl(Request::Type::DELETE_MESSAGES, chatId, nullptr, messageIds, nullptr);
+}
+
+bool Telegram::apiDeleteMessages(const std::map<long long, std::vector<long long>> &messagesByChat, std::size_t parallelism)
+{
+    // chunks of one chat stay sequential; chats run side by side
+    std::atomic<std::size_t> failed(0);
+    if (parallelism <= 1 || messagesByChat.size() <= 1)
+    {
+        for (const auto &chat : messagesByChat)
+        {
+            if (!this->apiDeleteMessages(chat.first, chat.second))
+                failed++;
+        }
+    }
+    else
+    {
+        WorkerPool pool(std::min(parallelism, messagesByChat.size()));
+        for (const auto &chat : messagesByChat)
+        {
+            long long chatId = chat.first;
+            const std::vector<long long> *ids = &chat.second;
+            pool.submit([this, chatId, ids, &failed]()
+                        {
+                            if (!this->apiDeleteMessages(chatId, *ids))
+                                failed++;
+                        });
+        }
+        pool.shutdown();
+    }
+    if (failed > 0)
+        TG_LOG(Log::ERROR, "%zu of %zu chats not fully cleaned up!\n", failed.load(), messagesByChat.size());
+    return failed == 0;
+}
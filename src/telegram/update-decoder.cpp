@@ -0,0 +1,965 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+#include "update-decoder.hpp"
+#include "nlohmann/json.hpp"
+#include "log.hpp"
+
+#ifdef TESSERGRAM_USE_SIMDJSON
+#include "simdjson.h"
+#endif
+
+#ifdef TESSERGRAM_USE_SIMDJSON
+const UpdateDecoder::Backend UpdateDecoder::DEFAULT = UpdateDecoder::Backend::SIMDJSON;
+#else
+const UpdateDecoder::Backend UpdateDecoder::DEFAULT = UpdateDecoder::Backend::NLOHMANN;
+#endif
+
+namespace
+{
+    Chat::Type chatTypeOf(const char *name, std::size_t length)
+    {
+        if (length == 5 && std::memcmp(name, "group", 5) == 0)
+            return Chat::Type::GROUP;
+        if (length == 10 && std::memcmp(name, "supergroup", 10) == 0)
+            return Chat::Type::SUPERGROUP;
+        if (length == 7 && std::memcmp(name, "channel", 7) == 0)
+            return Chat::Type::CHANNEL;
+        return Chat::Type::PRIVATE;
+    }
+
+    // -----------------------------------------------------------------------
+    // nlohmann::json backend: DOM parse, then the types' own tryParse()
+    // -----------------------------------------------------------------------
+
+    void scanDom(const nlohmann::json &update, UpdateFilter::Scan &scan)
+    {
+        const nlohmann::json *text = nullptr;
+        const nlohmann::json *chat = nullptr;
+        const nlohmann::json *body = JSONReader::object(update, "callback_query");
+        if (body != nullptr)
+        {
+            scan.kind = UpdateFilter::Kind::CALLBACK_QUERY;
+            text = JSONReader::find(*body, "data");
+            const nlohmann::json *message = JSONReader::object(*body, "message");
+            chat = message != nullptr ? JSONReader::object(*message, "chat") : nullptr;
+        }
+        else if ((body = JSONReader::object(update, "message")) != nullptr)
+        {
+            scan.kind = UpdateFilter::Kind::MESSAGE;
+            text = JSONReader::find(*body, "text");
+            chat = JSONReader::object(*body, "chat");
+        }
+
+        if (chat != nullptr && JSONReader::get(*chat, "id", scan.chatId) == JSONReader::Status::OK)
+        {
+            scan.hasChat = true;
+            const nlohmann::json *type = JSONReader::find(*chat, "type");
+            if (type != nullptr && type->is_string())
+            {
+                const std::string &name = type->get_ref<const std::string &>();
+                scan.chatType = chatTypeOf(name.data(), name.size());
+            }
+        }
+        if (text != nullptr && text->is_string())
+        {
+            const std::string &value = text->get_ref<const std::string &>();
+            scan.text = value.data();
+            scan.textLength = value.size();
+        }
+    }
+
+    void decodeUpdateDom(const nlohmann::json &update, const UpdateDecoder::Slot &slot, const UpdateDecoder::Done &done, bool summarize)
+    {
+        UpdateFilter::Scan scan;
+        if (JSONReader::get(update, "update_id", scan.updateId) != JSONReader::Status::OK)
+        {
+            TG_LOG(Log::WARNING, "skip: no update_id!\n");
+            return;
+        }
+        if (summarize)
+            scanDom(update, scan);
+        NodeMessage *message = slot(scan);
+        if (message != nullptr)
+            done(*message, message->tryParse(update));
+    }
+
+    JSONReader::Status decodeUpdatesDom(const std::string &buffer, const UpdateDecoder::Slot &slot, const UpdateDecoder::Done &done, bool summarize)
+    {
+        nlohmann::json json;
+        if (!JSONReader::parse(buffer, json))
+            return JSONReader::Status::MALFORMED;
+        if (!json.is_object())
+            return JSONReader::Status::WRONG_TYPE;
+
+        const nlohmann::json *result = JSONReader::find(json, "result");
+        if (result == nullptr)
+        {
+            decodeUpdateDom(json, slot, done, summarize);
+            return JSONReader::Status::OK;
+        }
+        if (!result->is_array())
+            return JSONReader::Status::WRONG_TYPE;
+        for (const nlohmann::json &update : *result)
+            decodeUpdateDom(update, slot, done, summarize);
+        return JSONReader::Status::OK;
+    }
+
+    JSONReader::Status decodeSingleDom(const std::string &body, NodeMessage &message)
+    {
+        nlohmann::json json;
+        if (!JSONReader::parse(body, json))
+            return JSONReader::Status::MALFORMED;
+        return message.tryParse(json);
+    }
+
+    // parses the response and hands its "result" object to fn
+    template <typename Fn>
+    JSONReader::Status decodeResultDom(const std::string &buffer, Fn fn)
+    {
+        nlohmann::json json;
+        if (!JSONReader::parse(buffer, json))
+            return JSONReader::Status::MALFORMED;
+        const nlohmann::json *result = JSONReader::object(json, "result");
+        if (result == nullptr)
+            return JSONReader::Status::MISSING;
+        return fn(*result);
+    }
+
+#ifdef TESSERGRAM_USE_SIMDJSON
+    // -----------------------------------------------------------------------
+    // simdjson on-demand backend: one forward pass per object, fields are
+    // decoded in document order and unknown ones are skipped unparsed
+    // -----------------------------------------------------------------------
+
+    typedef simdjson::ondemand::value Value;
+    typedef simdjson::ondemand::object Object;
+    typedef simdjson::ondemand::field Field;
+
+    simdjson::ondemand::parser &localParser()
+    {
+        static thread_local simdjson::ondemand::parser parser;
+        return parser;
+    }
+
+    // simdjson reads SIMDJSON_PADDING bytes past the input; copy only when
+    // the caller's buffer has no spare capacity for that
+    simdjson::error_code iterate(const std::string &buffer, simdjson::ondemand::document &document)
+    {
+        if (buffer.capacity() - buffer.size() >= simdjson::SIMDJSON_PADDING)
+            return localParser().iterate(simdjson::padded_string_view(buffer.data(), buffer.size(), buffer.capacity())).get(document);
+
+        static thread_local std::string scratch;
+        scratch.reserve(buffer.size() + simdjson::SIMDJSON_PADDING);
+        scratch.assign(buffer);
+        return localParser().iterate(simdjson::padded_string_view(scratch.data(), scratch.size(), scratch.capacity())).get(document);
+    }
+
+    bool readInt(Value &value, long long &out)
+    {
+        simdjson::ondemand::json_type type;
+        if (value.type().get(type) != simdjson::SUCCESS)
+            return false;
+        if (type == simdjson::ondemand::json_type::number)
+        {
+            int64_t number;
+            if (value.get_int64().get(number) != simdjson::SUCCESS)
+                return false;
+            out = number;
+            return true;
+        }
+        // some fields (callback query ids, file sizes) may arrive as numeric strings
+        std::string_view text;
+        if (type != simdjson::ondemand::json_type::string || value.get_string().get(text) != simdjson::SUCCESS || text.empty())
+            return false;
+        std::string digits(text.data(), text.size());
+        char *end = nullptr;
+        errno = 0;
+        long long parsed = std::strtoll(digits.c_str(), &end, 10);
+        if (*end != '\0' || errno != 0)
+            return false;
+        out = parsed;
+        return true;
+    }
+
+    bool readString(Value &value, std::string &out)
+    {
+        std::string_view text;
+        if (value.get_string().get(text) != simdjson::SUCCESS)
+            return false;
+        out.assign(text.data(), text.size());
+        return true;
+    }
+
+    bool readBool(Value &value, bool &out)
+    {
+        return value.get_bool().get(out) == simdjson::SUCCESS;
+    }
+
+    bool isObject(Value &value)
+    {
+        simdjson::ondemand::json_type type;
+        return value.type().get(type) == simdjson::SUCCESS && type == simdjson::ondemand::json_type::object;
+    }
+
+    // a mandatory field stays MISSING until seen, like JSONReader::get()
+    JSONReader::Status seen(bool ok)
+    {
+        return ok ? JSONReader::Status::OK : JSONReader::Status::WRONG_TYPE;
+    }
+
+    // the first failing mandatory field, in the order the DOM path checks them
+    JSONReader::Status firstFailure(std::initializer_list<JSONReader::Status> statuses)
+    {
+        for (JSONReader::Status status : statuses)
+        {
+            if (status != JSONReader::Status::OK)
+                return status;
+        }
+        return JSONReader::Status::OK;
+    }
+
+    bool isKey(const std::string_view &key, const char *name)
+    {
+        std::size_t length = std::strlen(name);
+        return key.size() == length && std::memcmp(key.data(), name, length) == 0;
+    }
+
+    bool mediaType(const std::string_view &key, Media::Type &type)
+    {
+        static const std::vector<std::pair<std::string, Media::Type>> names = []()
+        {
+            std::vector<std::pair<std::string, Media::Type>> all;
+            Media::typeIteration(
+                [&](const Media::Type &mediaType, const std::string &name)
+                {
+                    all.emplace_back(name, mediaType);
+                });
+            return all;
+        }();
+        for (const std::pair<std::string, Media::Type> &name : names)
+        {
+            if (isKey(key, name.first.c_str()))
+            {
+                type = name.second;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // runs fn(key, value) for every field; false when the input is broken
+    template <typename Fn>
+    bool eachField(Object &object, Fn fn)
+    {
+        for (simdjson::simdjson_result<Field> item : object)
+        {
+            Field field;
+            if (std::move(item).get(field) != simdjson::SUCCESS)
+                return false;
+            // Bot API keys are plain ASCII, so the raw key compares as is
+            if (!fn(field.escaped_key(), field.value()))
+                return false;
+        }
+        return true;
+    }
+
+    JSONReader::Status decodeUser(Value &value, User &user)
+    {
+        user.reset();
+        Object object;
+        if (value.get_object().get(object) != simdjson::SUCCESS)
+            return JSONReader::Status::WRONG_TYPE;
+
+        JSONReader::Status bot = JSONReader::Status::MISSING, id = JSONReader::Status::MISSING;
+        JSONReader::Status firstName = JSONReader::Status::MISSING, username = JSONReader::Status::MISSING;
+        bool ok = eachField(object,
+                            [&](const std::string_view &key, Value &field)
+                            {
+                                if (isKey(key, "id"))
+                                    id = seen(readInt(field, user.id));
+                                else if (isKey(key, "is_bot"))
+                                    bot = seen(readBool(field, user.isBot));
+                                else if (isKey(key, "first_name"))
+                                    firstName = seen(readString(field, user.firstName));
+                                else if (isKey(key, "last_name"))
+                                    readString(field, user.lastName);
+                                else if (isKey(key, "username"))
+                                    username = seen(readString(field, user.username));
+                                else if (isKey(key, "language_code"))
+                                    readString(field, user.languageCode);
+                                return true;
+                            });
+        JSONReader::Status status = ok ? firstFailure({bot, id, firstName, username}) : JSONReader::Status::MALFORMED;
+        if (status != JSONReader::Status::OK)
+            user.reset();
+        return status;
+    }
+
+    JSONReader::Status decodeChat(Value &value, Chat &chat)
+    {
+        chat.reset();
+        Object object;
+        if (value.get_object().get(object) != simdjson::SUCCESS)
+            return JSONReader::Status::WRONG_TYPE;
+
+        JSONReader::Status id = JSONReader::Status::MISSING;
+        JSONReader::Status firstName = JSONReader::Status::MISSING, title = JSONReader::Status::MISSING;
+        std::string type;
+        bool ok = eachField(object,
+                            [&](const std::string_view &key, Value &field)
+                            {
+                                if (isKey(key, "id"))
+                                    id = seen(readInt(field, chat.id));
+                                else if (isKey(key, "type"))
+                                    readString(field, type);
+                                else if (isKey(key, "title"))
+                                    title = seen(readString(field, chat.title));
+                                else if (isKey(key, "first_name"))
+                                    firstName = seen(readString(field, chat.firstName));
+                                else if (isKey(key, "last_name"))
+                                    readString(field, chat.lastName);
+                                else if (isKey(key, "username"))
+                                    readString(field, chat.username);
+                                return true;
+                            });
+        if (!ok)
+        {
+            chat.reset();
+            return JSONReader::Status::MALFORMED;
+        }
+
+        if (type == "group")
+            chat.type = Chat::Type::GROUP;
+        else if (type == "supergroup")
+            chat.type = Chat::Type::SUPERGROUP;
+        else if (type == "channel")
+            chat.type = Chat::Type::CHANNEL;
+
+        JSONReader::Status status = firstFailure({id, chat.type == Chat::Type::PRIVATE ? firstName : title});
+        if (status != JSONReader::Status::OK)
+        {
+            chat.reset();
+            return status;
+        }
+        if (chat.type == Chat::Type::PRIVATE)
+        {
+            chat.title = chat.firstName;
+            if (!chat.lastName.empty())
+                chat.title += " " + chat.lastName;
+        }
+        else
+        {
+            // groups carry no personal name, as in Chat::tryParse()
+            chat.firstName.clear();
+            chat.lastName.clear();
+        }
+        return status;
+    }
+
+    // fields Media and Media::Size share; file_name only exists on the former
+    template <typename File>
+    JSONReader::Status decodeFile(Value &value, File &file, std::string *fileName)
+    {
+        Object object;
+        if (value.get_object().get(object) != simdjson::SUCCESS)
+            return JSONReader::Status::WRONG_TYPE;
+
+        JSONReader::Status fileId = JSONReader::Status::MISSING, uniqueId = JSONReader::Status::MISSING;
+        long long dimension = 0;
+        bool ok = eachField(object,
+                            [&](const std::string_view &key, Value &field)
+                            {
+                                if (isKey(key, "file_id"))
+                                    fileId = seen(readString(field, file.fileId));
+                                else if (isKey(key, "file_unique_id"))
+                                    uniqueId = seen(readString(field, file.fileUniqueId));
+                                else if (isKey(key, "file_size") && !readInt(field, file.fileSize))
+                                    file.fileSize = 0;
+                                else if (isKey(key, "width"))
+                                    file.width = readInt(field, dimension) ? static_cast<int>(dimension) : 0;
+                                else if (isKey(key, "height"))
+                                    file.height = readInt(field, dimension) ? static_cast<int>(dimension) : 0;
+                                else if (fileName != nullptr && isKey(key, "file_name"))
+                                    readString(field, *fileName);
+                                return true;
+                            });
+        return ok ? firstFailure({fileId, uniqueId}) : JSONReader::Status::MALFORMED;
+    }
+
+    JSONReader::Status decodeMedia(Value &value, Media::Type type, Media &media)
+    {
+        media.reset();
+        media.type = type;
+        JSONReader::Status status = decodeFile(value, media, &media.fileName);
+        if (status != JSONReader::Status::OK)
+            media.reset();
+        return status;
+    }
+
+    JSONReader::Status decodeMessage(Value &value, Message &message);
+
+    // one media key: a single object, or a photo's array of sizes
+    bool decodeMediaField(Value &value, Media::Type type, Message &message)
+    {
+        simdjson::ondemand::array items;
+        if (value.get_array().get(items) != simdjson::SUCCESS)
+        {
+            Media media;
+            JSONReader::Status status = decodeMedia(value, type, media);
+            if (status == JSONReader::Status::OK)
+                message.media.push_back(std::move(media));
+            return status != JSONReader::Status::MALFORMED;
+        }
+        message.media.emplace_back();
+        Media &media = message.media.back();
+        media.type = type;
+        for (simdjson::simdjson_result<Value> item : items)
+        {
+            Value element;
+            if (std::move(item).get(element) != simdjson::SUCCESS)
+                return false;
+            Media::Size size;
+            JSONReader::Status status = decodeFile(element, size, nullptr);
+            if (status == JSONReader::Status::MALFORMED)
+                return false;
+            if (status == JSONReader::Status::OK)
+                media.sizes.push_back(std::move(size));
+        }
+        if (media.useLargestSize() != JSONReader::Status::OK)
+            message.media.pop_back();
+        return true;
+    }
+
+    // optional nested message (reply_to_message, callback_query.message)
+    bool decodeNested(Value &value, std::unique_ptr<Message> &nested)
+    {
+        if (!isObject(value))
+            return true;
+        nested.reset(new Message());
+        JSONReader::Status status = decodeMessage(value, *nested);
+        if (status != JSONReader::Status::OK)
+            nested.reset();
+        return status != JSONReader::Status::MALFORMED;
+    }
+
+    JSONReader::Status decodeMessage(Value &value, Message &message)
+    {
+        message.reset();
+        Object object;
+        if (value.get_object().get(object) != simdjson::SUCCESS)
+            return JSONReader::Status::WRONG_TYPE;
+
+        JSONReader::Status id = JSONReader::Status::MISSING;
+        bool hasFrom = false, hasChat = false;
+        bool ok = eachField(object,
+                            [&](const std::string_view &key, Value &field)
+                            {
+                                long long number = 0;
+                                Media::Type type;
+                                if (isKey(key, "message_id"))
+                                    id = seen(readInt(field, message.id));
+                                else if (isKey(key, "date"))
+                                    message.dtime = readInt(field, number) ? static_cast<time_t>(number) : 0;
+                                else if (isKey(key, "message_thread_id") && !readInt(field, message.threadId))
+                                    message.threadId = 0;
+                                else if (isKey(key, "text"))
+                                    readString(field, message.text);
+                                else if (isKey(key, "caption"))
+                                    readString(field, message.caption);
+                                else if (isKey(key, "media_group_id"))
+                                    readString(field, message.mediaGroupId);
+                                else if (isKey(key, "from") || isKey(key, "chat"))
+                                {
+                                    // sender and chat must be present; an incomplete one is left empty
+                                    if (!isObject(field))
+                                        return true;
+                                    bool from = isKey(key, "from");
+                                    (from ? hasFrom : hasChat) = true;
+                                    JSONReader::Status status = from ? decodeUser(field, message.from) : decodeChat(field, message.chat);
+                                    return status != JSONReader::Status::MALFORMED;
+                                }
+                                else if (isKey(key, "reply_to_message"))
+                                    return decodeNested(field, message.replyToMessage);
+                                else if (mediaType(key, type))
+                                    return decodeMediaField(field, type, message);
+                                return true;
+                            });
+        JSONReader::Status status = JSONReader::Status::MALFORMED;
+        if (ok)
+            status = firstFailure({id, hasFrom && hasChat ? JSONReader::Status::OK : JSONReader::Status::MISSING});
+        if (status != JSONReader::Status::OK)
+            message.reset();
+        return status;
+    }
+
+    JSONReader::Status decodeCallbackQuery(Value &value, CallbackQuery &query)
+    {
+        query.reset();
+        Object object;
+        if (value.get_object().get(object) != simdjson::SUCCESS)
+            return JSONReader::Status::WRONG_TYPE;
+
+        JSONReader::Status id = JSONReader::Status::MISSING, data = JSONReader::Status::MISSING;
+        bool hasFrom = false;
+        bool ok = eachField(object,
+                            [&](const std::string_view &key, Value &field)
+                            {
+                                if (isKey(key, "id"))
+                                    id = seen(readInt(field, query.id));
+                                else if (isKey(key, "data"))
+                                    data = seen(readString(field, query.data));
+                                else if (isKey(key, "chat_instance"))
+                                    readString(field, query.chatInstance);
+                                else if (isKey(key, "from"))
+                                {
+                                    if (!isObject(field))
+                                        return true;
+                                    hasFrom = true;
+                                    return decodeUser(field, query.from) != JSONReader::Status::MALFORMED;
+                                }
+                                else if (isKey(key, "message"))
+                                    return decodeNested(field, query.message);
+                                return true;
+                            });
+        JSONReader::Status status = JSONReader::Status::MALFORMED;
+        if (ok)
+            status = firstFailure({id, data, hasFrom ? JSONReader::Status::OK : JSONReader::Status::MISSING});
+        if (status != JSONReader::Status::OK)
+            query.reset();
+        return status;
+    }
+
+    JSONReader::Status readUpdateId(Object &update, long long &updateId)
+    {
+        // update_id leads every Update, so this normally looks at one field
+        Value value;
+        simdjson::error_code error = update.find_field_unordered("update_id").get(value);
+        JSONReader::Status status = JSONReader::Status::MISSING;
+        if (error == simdjson::SUCCESS)
+            status = seen(readInt(value, updateId));
+        else if (error != simdjson::NO_SUCH_FIELD)
+            return JSONReader::Status::MALFORMED;
+        return update.reset().error() == simdjson::SUCCESS ? status : JSONReader::Status::MALFORMED;
+    }
+
+    // the "result" member of a method response, MISSING unless it is an object
+    JSONReader::Status findResult(const std::string &buffer, simdjson::ondemand::document &document, Value &result)
+    {
+        Object top;
+        if (iterate(buffer, document) != simdjson::SUCCESS || document.get_object().get(top) != simdjson::SUCCESS)
+            return JSONReader::Status::MALFORMED;
+        simdjson::error_code error = top.find_field_unordered("result").get(result);
+        if (error == simdjson::NO_SUCH_FIELD || (error == simdjson::SUCCESS && !isObject(result)))
+            return JSONReader::Status::MISSING;
+        return error == simdjson::SUCCESS ? JSONReader::Status::OK : JSONReader::Status::MALFORMED;
+    }
+
+    // one member of the "result" object
+    JSONReader::Status findResultField(const std::string &buffer, simdjson::ondemand::document &document, const char *key, Value &value)
+    {
+        Value result;
+        Object object;
+        JSONReader::Status status = findResult(buffer, document, result);
+        if (status != JSONReader::Status::OK)
+            return status;
+        if (result.get_object().get(object) != simdjson::SUCCESS)
+            return JSONReader::Status::MISSING;
+        simdjson::error_code error = object.find_field_unordered(key).get(value);
+        if (error == simdjson::NO_SUCH_FIELD)
+            return JSONReader::Status::MISSING;
+        return error == simdjson::SUCCESS ? JSONReader::Status::OK : JSONReader::Status::MALFORMED;
+    }
+
+    JSONReader::Status readResultIds(const std::string &buffer, const char *key, std::vector<long long> &out)
+    {
+        simdjson::ondemand::document document;
+        Object top;
+        Value result;
+        simdjson::ondemand::array items;
+        if (iterate(buffer, document) != simdjson::SUCCESS || document.get_object().get(top) != simdjson::SUCCESS)
+            return JSONReader::Status::MALFORMED;
+        simdjson::error_code error = top.find_field_unordered("result").get(result);
+        if (error == simdjson::NO_SUCH_FIELD)
+            return JSONReader::Status::MISSING;
+        if (error != simdjson::SUCCESS)
+            return JSONReader::Status::MALFORMED;
+        if (result.get_array().get(items) != simdjson::SUCCESS)
+            return JSONReader::Status::MISSING;
+        for (simdjson::simdjson_result<Value> item : items)
+        {
+            Value element;
+            Object object;
+            Value value;
+            long long id = 0;
+            if (std::move(item).get(element) != simdjson::SUCCESS)
+                return JSONReader::Status::MALFORMED;
+            if (element.get_object().get(object) != simdjson::SUCCESS)
+                return JSONReader::Status::MISSING;
+            error = object.find_field_unordered(key).get(value);
+            if (error == simdjson::NO_SUCH_FIELD)
+                return JSONReader::Status::MISSING;
+            if (error != simdjson::SUCCESS)
+                return JSONReader::Status::MALFORMED;
+            if (!readInt(value, id))
+                return JSONReader::Status::WRONG_TYPE;
+            out.push_back(id);
+        }
+        return JSONReader::Status::OK;
+    }
+
+    // callback_query wins over message, whatever order they come in
+    JSONReader::Status decodeKind(Object &update, Message &message, CallbackQuery &query)
+    {
+        bool hasQuery = false, hasMessage = false;
+        JSONReader::Status queryStatus = JSONReader::Status::OK, messageStatus = JSONReader::Status::OK;
+        bool ok = eachField(update,
+                            [&](const std::string_view &key, Value &field)
+                            {
+                                if (isKey(key, "callback_query") && isObject(field))
+                                {
+                                    hasQuery = true;
+                                    queryStatus = decodeCallbackQuery(field, query);
+                                    return queryStatus != JSONReader::Status::MALFORMED;
+                                }
+                                if (isKey(key, "message") && !hasQuery && isObject(field))
+                                {
+                                    hasMessage = true;
+                                    messageStatus = decodeMessage(field, message);
+                                    return messageStatus != JSONReader::Status::MALFORMED;
+                                }
+                                return true;
+                            });
+        if (!ok)
+            return JSONReader::Status::MALFORMED;
+        if (hasQuery)
+        {
+            message.reset();
+            return queryStatus;
+        }
+        return hasMessage ? messageStatus : JSONReader::Status::UNKNOWN_KIND;
+    }
+
+    // a string without unescaping it into the parser's buffer, which only has
+    // room for every string once; escaped text is unescaped into scratch
+    bool scanString(Value &value, std::string_view &out, std::string &scratch)
+    {
+        simdjson::ondemand::raw_json_string raw;
+        if (value.get_raw_json_string().get(raw) != simdjson::SUCCESS)
+            return false;
+        const char *begin = raw.raw();
+        const char *end = begin;
+        bool escaped = false;
+        // stage 1 has validated the string, so the closing quote exists
+        while (*end != '"')
+        {
+            if (*end == '\\')
+            {
+                escaped = true;
+                end++;
+            }
+            end++;
+        }
+        if (!escaped)
+        {
+            out = std::string_view(begin, static_cast<std::size_t>(end - begin));
+            return true;
+        }
+        scratch.resize(static_cast<std::size_t>(end - begin) + simdjson::SIMDJSON_PADDING);
+        uint8_t *dst = reinterpret_cast<uint8_t *>(&scratch[0]);
+        return localParser().unescape(raw, dst).get(out) == simdjson::SUCCESS;
+    }
+
+    bool scanChat(Value &value, UpdateFilter::Scan &scan)
+    {
+        static thread_local std::string scratch;
+        Object chat;
+        if (value.get_object().get(chat) != simdjson::SUCCESS)
+            return true;
+        return eachField(chat,
+                         [&](const std::string_view &key, Value &field)
+                         {
+                             std::string_view type;
+                             if (isKey(key, "id"))
+                                 scan.hasChat = readInt(field, scan.chatId);
+                             else if (isKey(key, "type") && scanString(field, type, scratch))
+                                 scan.chatType = chatTypeOf(type.data(), type.size());
+                             return true;
+                         });
+    }
+
+    // kind, chat and text only; the update is rewound for the full decode
+    bool scanSimd(Object &update, UpdateFilter::Scan &scan)
+    {
+        static thread_local std::string scratch;
+        std::string_view text;
+        bool hasText = false;
+        bool ok = eachField(update,
+                            [&](const std::string_view &key, Value &field)
+                            {
+                                Object body;
+                                bool query = isKey(key, "callback_query");
+                                if (!(query || (isKey(key, "message") && scan.kind != UpdateFilter::Kind::CALLBACK_QUERY)) ||
+                                    field.get_object().get(body) != simdjson::SUCCESS)
+                                    return true;
+                                scan.kind = query ? UpdateFilter::Kind::CALLBACK_QUERY : UpdateFilter::Kind::MESSAGE;
+                                scan.hasChat = false;
+                                hasText = false;
+                                return eachField(body,
+                                                 [&](const std::string_view &name, Value &value)
+                                                 {
+                                                     if (isKey(name, query ? "data" : "text"))
+                                                         hasText = scanString(value, text, scratch);
+                                                     else if (!query && isKey(name, "chat"))
+                                                         return scanChat(value, scan);
+                                                     else if (query && isKey(name, "message"))
+                                                     {
+                                                         Object message;
+                                                         if (value.get_object().get(message) != simdjson::SUCCESS)
+                                                             return true;
+                                                         return eachField(message,
+                                                                          [&](const std::string_view &inner, Value &chat)
+                                                                          {
+                                                                              return !isKey(inner, "chat") || scanChat(chat, scan);
+                                                                          });
+                                                     }
+                                                     return true;
+                                                 });
+                            });
+        if (hasText)
+        {
+            scan.text = text.data();
+            scan.textLength = text.size();
+        }
+        return ok && update.reset().error() == simdjson::SUCCESS;
+    }
+
+    // decodes one Update object into the slot the caller hands out
+    JSONReader::Status decodeOne(Object &update, const UpdateDecoder::Slot &slot, const UpdateDecoder::Done &done, bool summarize,
+                                 void (*bind)(NodeMessage &, long long *&, Message *&, CallbackQuery *&))
+    {
+        UpdateFilter::Scan scan;
+        JSONReader::Status status = readUpdateId(update, scan.updateId);
+        if (status == JSONReader::Status::MALFORMED)
+            return status;
+        if (status != JSONReader::Status::OK)
+        {
+            TG_LOG(Log::WARNING, "skip: no update_id!\n");
+            return JSONReader::Status::OK;
+        }
+        if (summarize && !scanSimd(update, scan))
+            return JSONReader::Status::MALFORMED;
+        NodeMessage *node = slot(scan);
+        if (node == nullptr)
+            return JSONReader::Status::OK;
+
+        long long *id;
+        Message *message;
+        CallbackQuery *query;
+        bind(*node, id, message, query);
+        *id = scan.updateId;
+        message->reset();
+        query->reset();
+        status = decodeKind(update, *message, *query);
+        done(*node, status);
+        return status == JSONReader::Status::MALFORMED ? status : JSONReader::Status::OK;
+    }
+#endif
+}
+
+UpdateDecoder::UpdateDecoder(Backend backend) : backend(available(backend) ? backend : Backend::NLOHMANN) {}
+
+UpdateDecoder::~UpdateDecoder()
+{
+}
+
+UpdateDecoder::Backend UpdateDecoder::getBackend() const
+{
+    return this->backend;
+}
+
+bool UpdateDecoder::available(Backend backend)
+{
+#ifdef TESSERGRAM_USE_SIMDJSON
+    return backend == Backend::NLOHMANN || backend == Backend::SIMDJSON;
+#else
+    return backend == Backend::NLOHMANN;
+#endif
+}
+
+const char *UpdateDecoder::backendToString(Backend backend)
+{
+    return backend == Backend::SIMDJSON ? "simdjson" : "nlohmann";
+}
+
+void UpdateDecoder::bind(NodeMessage &node, long long *&updateId, Message *&message, CallbackQuery *&callbackQuery)
+{
+    updateId = &node.updateId;
+    message = &node.message;
+    callbackQuery = &node.callbackQuery;
+}
+
+JSONReader::Status UpdateDecoder::decodeUpdates(const std::string &buffer, const Slot &slot, const Done &done, bool summarize) const
+{
+#ifdef TESSERGRAM_USE_SIMDJSON
+    if (this->backend == Backend::SIMDJSON)
+    {
+        simdjson::ondemand::document document;
+        Object top;
+        if (iterate(buffer, document) != simdjson::SUCCESS || document.get_object().get(top) != simdjson::SUCCESS)
+            return JSONReader::Status::MALFORMED;
+
+        Value result;
+        simdjson::error_code error = top.find_field_unordered("result").get(result);
+        if (error == simdjson::NO_SUCH_FIELD)
+        {
+            // a webhook body is the Update itself
+            if (top.reset().error() != simdjson::SUCCESS)
+                return JSONReader::Status::MALFORMED;
+            return decodeOne(top, slot, done, summarize, &UpdateDecoder::bind);
+        }
+        simdjson::ondemand::array updates;
+        if (error != simdjson::SUCCESS)
+            return JSONReader::Status::MALFORMED;
+        if (result.get_array().get(updates) != simdjson::SUCCESS)
+            return JSONReader::Status::WRONG_TYPE;
+        for (simdjson::simdjson_result<Value> item : updates)
+        {
+            Object update;
+            if (std::move(item).get_object().get(update) != simdjson::SUCCESS)
+                return JSONReader::Status::MALFORMED;
+            if (decodeOne(update, slot, done, summarize, &UpdateDecoder::bind) != JSONReader::Status::OK)
+                return JSONReader::Status::MALFORMED;
+        }
+        return JSONReader::Status::OK;
+    }
+#endif
+    return decodeUpdatesDom(buffer, slot, done, summarize);
+}
+
+JSONReader::Status UpdateDecoder::decodeUpdate(const std::string &body, NodeMessage &message) const
+{
+#ifdef TESSERGRAM_USE_SIMDJSON
+    if (this->backend == Backend::SIMDJSON)
+    {
+        long long *id;
+        Message *inner;
+        CallbackQuery *query;
+        UpdateDecoder::bind(message, id, inner, query);
+        *id = 0;
+        inner->reset();
+        query->reset();
+
+        simdjson::ondemand::document document;
+        Object update;
+        if (iterate(body, document) != simdjson::SUCCESS || document.get_object().get(update) != simdjson::SUCCESS)
+            return JSONReader::Status::MALFORMED;
+        JSONReader::Status status = readUpdateId(update, *id);
+        if (status != JSONReader::Status::OK)
+            return status;
+        return decodeKind(update, *inner, *query);
+    }
+#endif
+    return decodeSingleDom(body, message);
+}
+
+JSONReader::Status UpdateDecoder::decodeResult(const std::string &buffer, Message &message) const
+{
+    message.reset();
+#ifdef TESSERGRAM_USE_SIMDJSON
+    if (this->backend == Backend::SIMDJSON)
+    {
+        simdjson::ondemand::document document;
+        Value result;
+        JSONReader::Status status = findResult(buffer, document, result);
+        return status == JSONReader::Status::OK ? decodeMessage(result, message) : status;
+    }
+#endif
+    return decodeResultDom(buffer,
+                           [&](const nlohmann::json &result)
+                           {
+                               return message.tryParse(result);
+                           });
+}
+
+JSONReader::Status UpdateDecoder::decodeResult(const std::string &buffer, User &user) const
+{
+    user.reset();
+#ifdef TESSERGRAM_USE_SIMDJSON
+    if (this->backend == Backend::SIMDJSON)
+    {
+        simdjson::ondemand::document document;
+        Value result;
+        JSONReader::Status status = findResult(buffer, document, result);
+        return status == JSONReader::Status::OK ? decodeUser(result, user) : status;
+    }
+#endif
+    return decodeResultDom(buffer,
+                           [&](const nlohmann::json &result)
+                           {
+                               return user.tryParse(result);
+                           });
+}
+
+JSONReader::Status UpdateDecoder::decodeResult(const std::string &buffer, const char *key, std::string &out) const
+{
+#ifdef TESSERGRAM_USE_SIMDJSON
+    if (this->backend == Backend::SIMDJSON)
+    {
+        simdjson::ondemand::document document;
+        Value value;
+        JSONReader::Status status = findResultField(buffer, document, key, value);
+        return status == JSONReader::Status::OK ? seen(readString(value, out)) : status;
+    }
+#endif
+    return decodeResultDom(buffer,
+                           [&](const nlohmann::json &result)
+                           {
+                               return JSONReader::get(result, key, out);
+                           });
+}
+
+JSONReader::Status UpdateDecoder::decodeResult(const std::string &buffer, const char *key, long long &out) const
+{
+#ifdef TESSERGRAM_USE_SIMDJSON
+    if (this->backend == Backend::SIMDJSON)
+    {
+        simdjson::ondemand::document document;
+        Value value;
+        JSONReader::Status status = findResultField(buffer, document, key, value);
+        return status == JSONReader::Status::OK ? seen(readInt(value, out)) : status;
+    }
+#endif
+    return decodeResultDom(buffer,
+                           [&](const nlohmann::json &result)
+                           {
+                               return JSONReader::get(result, key, out);
+                           });
+}
+
+JSONReader::Status UpdateDecoder::decodeResult(const std::string &buffer, const char *key, std::vector<long long> &out) const
+{
+    out.clear();
+#ifdef TESSERGRAM_USE_SIMDJSON
+    if (this->backend == Backend::SIMDJSON)
+        return readResultIds(buffer, key, out);
+#endif
+    nlohmann::json json;
+    if (!JSONReader::parse(buffer, json))
+        return JSONReader::Status::MALFORMED;
+    const nlohmann::json *result = JSONReader::array(json, "result");
+    if (result == nullptr)
+        return JSONReader::Status::MISSING;
+    out.reserve(result->size());
+    for (const nlohmann::json &item : *result)
+    {
+        long long id = 0;
+        JSONReader::Status status = JSONReader::get(item, key, id);
+        if (status != JSONReader::Status::OK)
+            return status;
+        out.push_back(id);
+    }
+    return JSONReader::Status::OK;
+}
@@ -0,0 +1,69 @@
+#include "webhook-reply.hpp"
+#include "json-writer.hpp"
+
+WebhookReply::WebhookReply() : type(Request::Type::CONFIG), params() {}
+
+WebhookReply::WebhookReply(Request::Type type, const std::string &params) : type(type), params(params) {}
+
+WebhookReply::~WebhookReply()
+{
+}
+
+WebhookReply WebhookReply::sendMessage(long long chatId, const std::string &text)
+{
+    JSONWriter json;
+    json.beginObject()
+        .field("chat_id", chatId)
+        .field("text", text)
+        .endObject();
+    return WebhookReply(Request::Type::SEND_MESSAGE, json.str());
+}
+
+WebhookReply WebhookReply::sendChatAction(long long chatId, Chat::Action action)
+{
+    JSONWriter json;
+    json.beginObject()
+        .field("chat_id", chatId)
+        .field("action", Chat::actionToString(action))
+        .endObject();
+    return WebhookReply(Request::Type::SEND_CHAT_ACTION, json.str());
+}
+
+WebhookReply WebhookReply::editMessageText(long long chatId, long long messageId, const std::string &text)
+{
+    JSONWriter json;
+    json.beginObject()
+        .field("chat_id", chatId)
+        .field("message_id", messageId)
+        .field("text", text)
+        .endObject();
+    return WebhookReply(Request::Type::EDIT_MESSAGE_TEXT, json.str());
+}
+
+bool WebhookReply::empty() const
+{
+    return this->params.empty();
+}
+
+Request::Type WebhookReply::getType() const
+{
+    return this->type;
+}
+
+const std::string &WebhookReply::getParams() const
+{
+    return this->params;
+}
+
+std::string WebhookReply::toResponseBody() const
+{
+    if (this->empty())
+        return "";
+    // splice "method" in front of the parameters: {"method":"...",<params>}
+    std::string body = std::string("{\"method\":\"") + Request::typeToString(this->type) + "\"";
+    if (this->params.length() > 2)
+        body += "," + this->params.substr(1);
+    else
+        body += "}";
+    return body;
+}
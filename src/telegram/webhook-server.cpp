@@ -1,53 +1,346 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <sys/socket.h>
 #include "webhook-server.hpp"
 #include "telegram.hpp"
+#include "worker-pool.hpp"
+#include "metrics.hpp"
+#include "log.hpp"
 
 extern "C"
 {
 #include "mongoose.h"
 }
 
-static void webhookHandler(struct mg_connection *c, int ev, void *ev_data)
+namespace
 {
-    if (ev != MG_EV_HTTP_MSG)
-        return;
+    // a single-update delivery whose handler may answer in the HTTP response
+    class Delivery
+    {
+    public:
+        enum State
+        {
+            PENDING = 0,
+            ANSWERED, // reply is set and the loop writes it
+            EXPIRED,  // deadline passed: the worker sends the reply itself
+            DROPPED   // peer went away: Telegram redelivers, the reply is discarded
+        };
 
-    Telegram *hook = static_cast<Telegram *>(c->fn_data);
-    struct mg_http_message *hm = static_cast<struct mg_http_message *>(ev_data);
-    std::string body(hm->body.buf, hm->body.len);
+        unsigned long connection;
+        uint64_t deadline;
+        std::atomic<int> state;
+        WebhookReply reply;
 
-    hook->parseGetUpdatesResponse(body);
+        Delivery(unsigned long connection, uint64_t deadline) : connection(connection), deadline(deadline), state(PENDING), reply() {}
+    };
 
-    mg_http_reply(c, 200,
-                  "Content-Type: application/json\r\n",
-                  "{%m:%m,%m:{%m:%m}}",
-                  MG_ESC("status"), MG_ESC("success"),
-                  MG_ESC("data"), MG_ESC("message"), MG_ESC("message received"));
+    class Context
+    {
+    public:
+        WebhookServer *server;
+        Telegram *tg;
+        WorkerPool *dispatcher;
+        struct mg_mgr *mgr;
+        std::unordered_map<unsigned long, std::shared_ptr<Delivery>> deliveries; // loop thread only
+    };
 
-    hook->execWebhookCallback();
+    Metrics::Counter &rejected(const char *reason)
+    {
+        return Metrics::global().counter("tessergram_webhook_rejected_total", Metrics::label("reason", reason), "Webhook connections or deliveries refused by limits");
+    }
+
+    // last activity of an accepted connection, kept in its user data area
+    void touch(struct mg_connection *c)
+    {
+        uint64_t now = mg_millis();
+        memcpy(c->data, &now, sizeof(now));
+    }
+
+    uint64_t lastActivity(const struct mg_connection *c)
+    {
+        uint64_t at;
+        memcpy(&at, c->data, sizeof(at));
+        return at;
+    }
+
+    Metrics::Counter &replies(const char *path)
+    {
+        return Metrics::global().counter("tessergram_webhook_replies_total", Metrics::label("path", path), "Handler replies sent in the webhook response or as a separate request");
+    }
+
+    void replyPlain(struct mg_connection *c)
+    {
+        mg_http_reply(c, 200,
+                      "Content-Type: application/json\r\n",
+                      "{%m:%m,%m:{%m:%m}}",
+                      MG_ESC("status"), MG_ESC("success"),
+                      MG_ESC("data"), MG_ESC("message"), MG_ESC("message received"));
+    }
+
+    // finishes the inline delivery waiting on `c`, if any
+    void settle(Context *ctx, struct mg_connection *c, int ev, void *ev_data)
+    {
+        std::unordered_map<unsigned long, std::shared_ptr<Delivery>>::iterator it = ctx->deliveries.find(c->id);
+        if (it == ctx->deliveries.end())
+            return;
+        Delivery &delivery = *it->second;
+        int expected = Delivery::PENDING;
+        switch (ev)
+        {
+        case MG_EV_WAKEUP:
+            if (delivery.state != Delivery::ANSWERED)
+                return;
+            if (delivery.reply.empty())
+                replyPlain(c);
+            else
+            {
+                std::string body = delivery.reply.toResponseBody();
+                mg_http_reply(c, 200, "Content-Type: application/json\r\n", "%.*s", static_cast<int>(body.length()), body.c_str());
+                replies("inline").add();
+            }
+            break;
+        case MG_EV_POLL:
+            // an answered delivery is already on its way through the wakeup pipe
+            if (*static_cast<uint64_t *>(ev_data) < delivery.deadline ||
+                !delivery.state.compare_exchange_strong(expected, Delivery::EXPIRED))
+                return;
+            replyPlain(c);
+            break;
+        case MG_EV_CLOSE:
+            delivery.state.compare_exchange_strong(expected, Delivery::DROPPED);
+            break;
+        default:
+            return;
+        }
+        ctx->deliveries.erase(it);
+    }
+
+    void applyBacklog(struct mg_connection *listener, int backlog)
+    {
+        // mongoose fixes the backlog at compile time; listen() on an already
+        // listening socket only updates the queue length
+        if (listener != NULL && backlog > 0)
+            listen(static_cast<int>(reinterpret_cast<size_t>(listener->fd)), backlog);
+    }
+}
+
+WebhookServer::Config::Config()
+    : listenAddress("http://0.0.0.0:8443"),
+      maxConnections(40),
+      maxBodySize(1024 * 1024),
+      readTimeoutMs(30000),
+      backlog(0),
+      replyDeadlineMs(2000),
+      metricsToken()
+{
 }
 
-WebhookServer::WebhookServer() : running(false) {}
+WebhookServer::WebhookServer() : config(), running(false), connections(0), port(0) {}
 
 WebhookServer::~WebhookServer()
 {
     stop();
 }
 
-void WebhookServer::run(const std::string &listenAddr, Telegram *tg)
+void WebhookServer::configure(const Config &config)
+{
+    this->config = config;
+}
+
+const WebhookServer::Config &WebhookServer::getConfig() const
+{
+    return this->config;
+}
+
+bool WebhookServer::admit(struct mg_connection *c, int ev, void *ev_data, const Config &config, std::atomic<std::size_t> &connections)
+{
+    switch (ev)
+    {
+    case MG_EV_ACCEPT:
+        touch(c);
+        if (connections.fetch_add(1) >= config.maxConnections)
+        {
+            rejected("connections").add();
+            c->is_closing = 1;
+        }
+        return false;
+    case MG_EV_CLOSE:
+        if (c->is_accepted)
+            connections.fetch_sub(1);
+        return false;
+    case MG_EV_READ:
+        touch(c);
+        // bodies without Content-Length are bounded by what is buffered
+        if (c->recv.len > config.maxBodySize + 8192)
+        {
+            rejected("body").add();
+            c->is_closing = 1;
+        }
+        return false;
+    case MG_EV_POLL:
+        if (c->is_accepted && config.readTimeoutMs > 0 &&
+            *static_cast<uint64_t *>(ev_data) - lastActivity(c) > static_cast<uint64_t>(config.readTimeoutMs))
+        {
+            rejected("timeout").add();
+            c->is_closing = 1;
+        }
+        return false;
+    case MG_EV_HTTP_HDRS:
+    {
+        struct mg_str *length = mg_http_get_header(static_cast<struct mg_http_message *>(ev_data), "Content-Length");
+        if (length != NULL && std::strtoull(std::string(length->buf, length->len).c_str(), nullptr, 10) > config.maxBodySize)
+        {
+            rejected("body").add();
+            mg_http_reply(c, 413, "Connection: close\r\n", "");
+            c->is_draining = 1;
+        }
+        return false;
+    }
+    case MG_EV_HTTP_MSG:
+        return !c->is_draining && !c->is_closing;
+    default:
+        return false;
+    }
+}
+
+bool WebhookServer::serveMetrics(struct mg_connection *c, struct mg_http_message *hm, const Config &config)
 {
+    // the listener faces the internet, so the endpoint exists only with a token
+    if (config.metricsToken.empty() || !mg_match(hm->uri, mg_str("/metrics"), NULL) || mg_strcmp(hm->method, mg_str("GET")) != 0)
+        return false;
+
+    struct mg_str *authorization = mg_http_get_header(hm, "Authorization");
+    std::string expected = "Bearer " + config.metricsToken;
+    if (authorization == NULL || mg_strcmp(*authorization, mg_str_n(expected.c_str(), expected.length())) != 0)
+    {
+        rejected("metrics").add();
+        mg_http_reply(c, 401, "WWW-Authenticate: Bearer\r\n", "");
+        return true;
+    }
+    std::string text = Metrics::global().exportPrometheus();
+    mg_http_reply(c, 200, "Content-Type: text/plain; version=0.0.4\r\n", "%.*s", static_cast<int>(text.length()), text.c_str());
+    return true;
+}
+
+void WebhookServer::onHttp(struct mg_connection *c, int ev, void *ev_data)
+{
+    static Metrics::Counter &requests = Metrics::global().counter("tessergram_webhook_requests_total", "", "Webhook deliveries received");
+
+    Context *ctx = static_cast<Context *>(c->fn_data);
+    if (!ctx->deliveries.empty())
+        settle(ctx, c, ev, ev_data);
+    if (!WebhookServer::admit(c, ev, ev_data, ctx->server->config, ctx->server->connections))
+        return;
+
+    struct mg_http_message *hm = static_cast<struct mg_http_message *>(ev_data);
+    if (WebhookServer::serveMetrics(c, hm, ctx->server->config))
+        return;
+
+    requests.add();
+    if (ctx->tg->hasWebhookReplyCallback())
+    {
+        WebhookServer::dispatchInline(ctx, c, hm);
+        return;
+    }
+    bool queued = ctx->tg->parseWebhookUpdate(std::string(hm->body.buf, hm->body.len));
+
+    replyPlain(c);
+
+    if (queued)
+    {
+        Telegram *tg = ctx->tg;
+        ctx->dispatcher->submit(
+            [tg]()
+            {
+                tg->execWebhookCallback();
+            });
+    }
+}
+
+void WebhookServer::dispatchInline(void *context, struct mg_connection *c, struct mg_http_message *hm)
+{
+    Context *ctx = static_cast<Context *>(context);
+    std::shared_ptr<NodeMessage> message(new NodeMessage());
+    // Telegram sends one delivery per connection at a time, so a connection
+    // has at most one delivery waiting for its response
+    if (ctx->deliveries.count(c->id) > 0 || !ctx->tg->parseWebhookUpdate(std::string(hm->body.buf, hm->body.len), *message))
+    {
+        replyPlain(c);
+        return;
+    }
+
+    std::shared_ptr<Delivery> delivery(new Delivery(c->id, mg_millis() + static_cast<uint64_t>(std::max(0, ctx->server->config.replyDeadlineMs))));
+    ctx->deliveries[c->id] = delivery;
+    Telegram *tg = ctx->tg;
+    struct mg_mgr *mgr = ctx->mgr;
+    ctx->dispatcher->submit(
+        [tg, mgr, delivery, message]()
+        {
+            WebhookReply reply = tg->execWebhookReply(*message);
+            // written before the state changes, read by whoever sees the change
+            delivery->reply = reply;
+            int expected = Delivery::PENDING;
+            if (delivery->state.compare_exchange_strong(expected, Delivery::ANSWERED))
+                mg_wakeup(mgr, delivery->connection, "", 0);
+            else if (expected == Delivery::EXPIRED && !reply.empty() && tg->apiSendReply(reply))
+                replies("outbound").add();
+        });
+}
+
+void WebhookServer::run(Telegram *tg)
+{
+    WorkerPool dispatcher(1);
+    Context ctx;
+    ctx.server = this;
+    ctx.tg = tg;
+    ctx.dispatcher = &dispatcher;
+
     struct mg_mgr mgr;
     mg_mgr_init(&mgr);
-    mg_http_listen(&mgr, listenAddr.c_str(), webhookHandler, tg);
+    ctx.mgr = &mgr;
+    bool inlineReplies = tg->hasWebhookReplyCallback();
+    if (inlineReplies && !mg_wakeup_init(&mgr))
+        TG_LOG(Log::ERROR, "wakeup pipe failed!\n");
+    struct mg_connection *listener = mg_http_listen(&mgr, this->config.listenAddress.c_str(), WebhookServer::onHttp, &ctx);
+    if (listener == NULL)
+        TG_LOG(Log::ERROR, "listen on %s failed!\n", this->config.listenAddress.c_str());
+    else
+        this->port = mg_ntohs(listener->loc.port);
+    applyBacklog(listener, this->config.backlog);
+
     running = true;
     while (running)
     {
-        mg_mgr_poll(&mgr, 100);
+        // reply deadlines are checked on every poll
+        mg_mgr_poll(&mgr, inlineReplies ? 10 : 100);
     }
+    // workers may still call mg_wakeup(), so they finish before the manager goes
+    dispatcher.shutdown();
     mg_mgr_free(&mgr);
+    this->port = 0;
+}
+
+void WebhookServer::run(const std::string &listenAddr, Telegram *tg)
+{
+    this->config.listenAddress = listenAddr;
+    this->run(tg);
 }
 
 void WebhookServer::stop()
 {
     running = false;
 }
+
+std::size_t WebhookServer::getConnectionCount() const
+{
+    return this->connections;
+}
+
+int WebhookServer::getPort() const
+{
+    return this->port;
+}
@@ -1,24 +1,29 @@
 #include "telegram.hpp"
 #include "request.hpp"
-#include "utils/include/debug.hpp"
-#include "json-validator.hpp"
-#include "nlohmann/json.hpp"
+#include "json-writer.hpp"
+#include "log.hpp"
 
 bool Telegram::apiSetWebhook(const std::string &url, const std::string &secretToken, const std::vector<std::string> &allowedUpdates, unsigned short maxConnection)
 {
-    nlohmann::json json;
-    json["url"] = url;
+    JSONWriter &json = JSONWriter::local();
+    json.beginObject().field("url", url);
     if (secretToken.length())
-        json["secret_token"] = secretToken;
+        json.field("secret_token", secretToken);
     if (!allowedUpdates.empty())
-        json["allowed_updates"] = allowedUpdates;
+    {
+        json.key("allowed_updates").beginArray();
+        for (const std::string &update : allowedUpdates)
+            json.value(update);
+        json.endArray();
+    }
     if (maxConnection > 0)
-        json["max_connections"] = maxConnection;
-    Request req(TELEGRAM_BASE_URL, this->token, Request::Type::SET_WEBHOOK, json.dump());
+        json.field("max_connections", static_cast<int>(maxConnection));
+    json.endObject();
+    Request req(this->endpoint, Request::Type::SET_WEBHOOK, json.str());
     if (req.isSuccess())
     {
 
-        Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "success\n");
+        TG_LOG(Log::INFO, "success\n");
         return true;
     }
     return false;
@@ -26,7 +31,7 @@ bool Telegram::apiSetWebhook(const std::string &url, const std::string &secretTo
 
 bool Telegram::apiSetWebhook(const std::string &url, const std::string &secretToken, const std::vector<std::string> &allowedUpdates)
 {
-    return this->apiSetWebhook(url, secretToken, allowedUpdates, 40);
+    return this->apiSetWebhook(url, secretToken, allowedUpdates, static_cast<unsigned short>(this->server.getConfig().maxConnections));
 }
 
 bool Telegram::apiSetWebhook(const std::string &url, unsigned short maxConnection)
@@ -36,15 +41,15 @@ bool Telegram::apiSetWebhook(const std::string &url, unsigned short maxConnectio
 
 bool Telegram::apiSetWebhook(const std::string &url)
 {
-    return this->apiSetWebhook(url, "", {}, 40);
+    return this->apiSetWebhook(url, "", {}, static_cast<unsigned short>(this->server.getConfig().maxConnections));
 }
 
 bool Telegram::apiUnsetWebhook()
 {
-    Request req(TELEGRAM_BASE_URL, this->token, Request::Type::UNSET_WEBHOOK, std::string("{\"drop_pending_updates\":true}"));
+    Request req(this->endpoint, Request::Type::UNSET_WEBHOOK, std::string("{\"drop_pending_updates\":true}"));
     if (req.isSuccess())
     {
-        Debug::log(Debug::INFO, __FILE__, __LINE__, __func__, "success\n");
+        TG_LOG(Log::INFO, "success\n");
         return true;
     }
     return false;
@@ -55,9 +60,25 @@ void Telegram::setWebhookCallback(std::function<void(Telegram &, const NodeMessa
     this->webhookCallback = handler;
 }
 
+void Telegram::setWebhookReplyCallback(std::function<WebhookReply(Telegram &, const NodeMessage &)> handler)
+{
+    // takes over single-update deliveries from the plain webhook callback
+    this->webhookReplyCallback = handler;
+}
+
+bool Telegram::hasWebhookReplyCallback() const
+{
+    return static_cast<bool>(this->webhookReplyCallback);
+}
+
+void Telegram::setWebhookConfig(const WebhookServer::Config &config)
+{
+    this->server.configure(config);
+}
+
 void Telegram::servWebhook()
 {
-    this->server.run("http://0.0.0.0:8443", this);
+    this->server.run(this);
 }
 
 void Telegram::stopWebhook()
@@ -74,8 +95,36 @@ void Telegram::execWebhookCallback()
         std::lock_guard<std::mutex> guard(this->mutex);
         snapshot.swap(this->messages);
     }
+    this->trackQueueDepth(-static_cast<long long>(snapshot.size()));
     for (const NodeMessage &message : snapshot)
     {
-        this->webhookCallback(*this, message);
+        this->runHandler(this->webhookCallback, message, true);
     }
-}
\ No newline at end of file
+}
+
+WebhookReply Telegram::execWebhookReply(const NodeMessage &message)
+{
+    WebhookReply reply;
+    if (!this->webhookReplyCallback)
+        return reply;
+    this->runHandler(
+        [&](Telegram &telegram, const NodeMessage &update)
+        {
+            reply = this->webhookReplyCallback(telegram, update);
+        },
+        message, true);
+    return reply;
+}
+
+bool Telegram::apiSendReply(const WebhookReply &reply)
+{
+    if (reply.empty())
+        return false;
+    Request req(this->endpoint, reply.getType(), reply.getParams());
+    if (req.isSuccess())
+    {
+        TG_LOG(Log::INFO, "success\n");
+        return true;
+    }
+    return false;
+}
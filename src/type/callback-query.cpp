@@ -1,7 +1,6 @@
 #include "type.hpp"
 #include "nlohmann/json.hpp"
-#include "json-validator.hpp"
-#include "utils/include/debug.hpp"
+#include "log.hpp"
 
 CallbackQuery::CallbackQuery()
 {
@@ -20,54 +19,40 @@ bool CallbackQuery::empty() const
 
 bool CallbackQuery::parse(const nlohmann::json &json)
 {
-    try
-    {
-        JSONValidator jval(__FILE__, __LINE__, __func__);
-
-        jval.validate<long long>(json, "id")
-            .onValid(
-                [&](const nlohmann::json &jid)
-                {
-                    this->id = jid.get<long long>();
-                })
-            .onInvalid(
-                [&](const nlohmann::json &jid, const std::string &err)
-                {
-                    this->id = std::stoll(jid.get<std::string>());
-                });
-
-        jval.validate<std::string>(json, "chat_instance")
-            .onValid(
-                [&](const nlohmann::json &jci)
-                {
-                    this->chatInstance = jci.get<std::string>();
-                });
-
-        this->data = jval.get<std::string>(json, "data");
+    JSONReader::Status status = this->tryParse(json);
+    if (status != JSONReader::Status::OK)
+        TG_LOG(Log::ERROR, "parse failed: %s\n", JSONReader::statusToString(status));
+    return status == JSONReader::Status::OK;
+}
 
-        const nlohmann::json &jsonFrom = jval.getObject(json, "from");
+JSONReader::Status CallbackQuery::tryParse(const nlohmann::json &json)
+{
+    this->reset();
 
-        this->from.parse(jsonFrom);
+    // the Bot API sends the id as a string of digits
+    JSONReader::Status status = JSONReader::get(json, "id", this->id);
+    const nlohmann::json *jsonFrom = JSONReader::object(json, "from");
+    if (status == JSONReader::Status::OK)
+        status = JSONReader::get(json, "data", this->data);
+    if (status == JSONReader::Status::OK && jsonFrom == nullptr)
+        status = JSONReader::Status::MISSING;
+    if (status != JSONReader::Status::OK)
+    {
+        this->reset();
+        return status;
+    }
+    this->from.tryParse(*jsonFrom);
 
-        jval.object(json, "message")
-            .onValid(
-                [this](const nlohmann::json &jmsg)
-                {
-                    this->message.reset(new Message);
-                    if (this->message->parse(jmsg) == false)
-                    {
-                        this->message.reset();
-                    }
-                });
+    JSONReader::get(json, "chat_instance", this->chatInstance);
 
-        return true;
-    }
-    catch (const std::exception &e)
+    const nlohmann::json *jsonMessage = JSONReader::object(json, "message");
+    if (jsonMessage != nullptr)
     {
-        Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "parse failed: %s\n", e.what());
+        this->message.reset(new Message);
+        if (this->message->tryParse(*jsonMessage) != JSONReader::Status::OK)
+            this->message.reset();
     }
-    this->reset();
-    return false;
+    return status;
 }
 
 void CallbackQuery::reset()
@@ -1,8 +1,7 @@
 #include <unordered_map>
 #include "type.hpp"
 #include "nlohmann/json.hpp"
-#include "json-validator.hpp"
-#include "utils/include/debug.hpp"
+#include "log.hpp"
 
 namespace
 {
@@ -48,57 +47,52 @@ bool Chat::empty() const
     return (this->id == 0);
 }
 
-bool Chat::parsePrivateFields(const nlohmann::json &json)
+JSONReader::Status Chat::parsePrivateFields(const nlohmann::json &json)
 {
-    JSONValidator jval(__FILE__, __LINE__, __func__);
-    this->firstName = jval.get<std::string>(json, "first_name");
-    jval.validate<std::string>(json, "last_name")
-        .onValid([this](const nlohmann::json &jln) { this->lastName = jln.get<std::string>(); });
-    jval.validate<std::string>(json, "username")
-        .onValid([this](const nlohmann::json &jun) { this->username = jun.get<std::string>(); });
+    JSONReader::Status status = JSONReader::get(json, "first_name", this->firstName);
+    if (status != JSONReader::Status::OK)
+        return status;
+    JSONReader::get(json, "last_name", this->lastName);
+    JSONReader::get(json, "username", this->username);
     this->title = this->firstName;
     if (!this->lastName.empty())
         this->title += " " + this->lastName;
-    return true;
+    return status;
 }
 
-bool Chat::parseGroupFields(const nlohmann::json &json)
+JSONReader::Status Chat::parseGroupFields(const nlohmann::json &json)
 {
-    JSONValidator jval(__FILE__, __LINE__, __func__);
-    this->title = jval.get<std::string>(json, "title");
-    jval.validate<std::string>(json, "username")
-        .onValid([this](const nlohmann::json &jun) { this->username = jun.get<std::string>(); });
-    return true;
+    JSONReader::Status status = JSONReader::get(json, "title", this->title);
+    if (status != JSONReader::Status::OK)
+        return status;
+    JSONReader::get(json, "username", this->username);
+    return status;
 }
 
 bool Chat::parse(const nlohmann::json &json)
 {
-    try
-    {
-        JSONValidator jval(__FILE__, __LINE__, __func__);
-
-        jval.validate<std::string>(json, "type")
-            .onValid(
-                [this](const nlohmann::json &jsonType)
-                {
-                    std::string chatType = jsonType.get<std::string>();
-                    auto it = chatTypeMap.find(chatType);
-                    this->type = (it != chatTypeMap.end()) ? it->second : Chat::Type::PRIVATE;
-                });
-
-        this->id = jval.get<long long>(json, "id");
-
-        if (this->type == Chat::Type::PRIVATE)
-            return this->parsePrivateFields(json);
-        else
-            return this->parseGroupFields(json);
-    }
-    catch (const std::exception &e)
+    JSONReader::Status status = this->tryParse(json);
+    if (status != JSONReader::Status::OK)
+        TG_LOG(Log::ERROR, "parse failed: %s\n", JSONReader::statusToString(status));
+    return status == JSONReader::Status::OK;
+}
+
+JSONReader::Status Chat::tryParse(const nlohmann::json &json)
+{
+    this->reset();
+    std::string chatType;
+    if (JSONReader::get(json, "type", chatType) == JSONReader::Status::OK)
     {
-        Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "parse failed: %s\n", e.what());
+        std::unordered_map<std::string, Chat::Type>::const_iterator it = chatTypeMap.find(chatType);
+        this->type = (it != chatTypeMap.end()) ? it->second : Chat::Type::PRIVATE;
     }
-    this->reset();
-    return false;
+
+    JSONReader::Status status = JSONReader::get(json, "id", this->id);
+    if (status == JSONReader::Status::OK)
+        status = (this->type == Chat::Type::PRIVATE) ? this->parsePrivateFields(json) : this->parseGroupFields(json);
+    if (status != JSONReader::Status::OK)
+        this->reset();
+    return status;
 }
 
 void Chat::reset()
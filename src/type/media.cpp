@@ -1,8 +1,7 @@
 #include <array>
 #include "type.hpp"
 #include "nlohmann/json.hpp"
-#include "json-validator.hpp"
-#include "utils/include/debug.hpp"
+#include "log.hpp"
 
 namespace
 {
@@ -19,12 +18,42 @@ namespace
         "contact"};
 
     static const std::string unknownName = "unknown";
+
+    int dimension(const nlohmann::json &json, const char *key)
+    {
+        long long value = 0;
+        if (JSONReader::get(json, key, value) != JSONReader::Status::OK)
+            return 0;
+        return static_cast<int>(value);
+    }
+
+    long long area(const Media::Size &size)
+    {
+        return static_cast<long long>(size.width) * size.height;
+    }
+}
+
+Media::Size::Size() : fileSize(0), width(0), height(0), fileId(), fileUniqueId() {}
+
+JSONReader::Status Media::Size::tryParse(const nlohmann::json &json)
+{
+    if (JSONReader::get(json, "file_size", this->fileSize) != JSONReader::Status::OK)
+        this->fileSize = 0;
+    this->width = dimension(json, "width");
+    this->height = dimension(json, "height");
+
+    JSONReader::Status status = JSONReader::get(json, "file_id", this->fileId);
+    if (status == JSONReader::Status::OK)
+        status = JSONReader::get(json, "file_unique_id", this->fileUniqueId);
+    return status;
 }
 
 Media::Media()
 {
     this->type = Media::Type::DOCUMENT;
     this->fileSize = 0;
+    this->width = 0;
+    this->height = 0;
 }
 
 Media::~Media()
@@ -38,59 +67,107 @@ bool Media::empty() const
 
 bool Media::parse(Media::Type type, const nlohmann::json &json)
 {
-    try
+    JSONReader::Status status = this->tryParse(type, json);
+    if (status != JSONReader::Status::OK)
+        TG_LOG(Log::ERROR, "parse failed: %s\n", JSONReader::statusToString(status));
+    return status == JSONReader::Status::OK;
+}
+
+JSONReader::Status Media::tryParse(Media::Type type, const nlohmann::json &json)
+{
+    this->reset();
+    this->type = type;
+
+    // numeric strings are accepted too: some API variants send file_size that way
+    if (JSONReader::get(json, "file_size", this->fileSize) != JSONReader::Status::OK)
+        this->fileSize = 0;
+
+    JSONReader::Status status = JSONReader::get(json, "file_id", this->fileId);
+    if (status == JSONReader::Status::OK)
+        status = JSONReader::get(json, "file_unique_id", this->fileUniqueId);
+    if (status != JSONReader::Status::OK)
     {
-        JSONValidator jval(__FILE__, __LINE__, __func__);
-
-        this->type = type;
-
-        jval.validate<long long>(json, "file_size")
-            .onValid(
-                [this](const nlohmann::json &jsonFZ)
-                {
-                    this->fileSize = jsonFZ.get<long long>();
-                })
-            .onInvalid(
-                [this](const nlohmann::json &jsonFZ, const std::string &)
-                {
-                    // fallback: some API variants send file_size as a numeric string
-                    try
-                    {
-                        this->fileSize = std::stoll(jsonFZ.get<std::string>());
-                    }
-                    catch (const std::exception &)
-                    {
-                        this->fileSize = 0;
-                    }
-                });
-
-        this->fileId = jval.get<std::string>(json, "file_id");
-        this->fileUniqueId = jval.get<std::string>(json, "file_unique_id");
-
-        jval.validate<std::string>(json, "file_name")
-            .onValid(
-                [this](const nlohmann::json &jsonFName)
-                {
-                    this->fileName = jsonFName.get<std::string>();
-                });
-
-        return true;
+        this->reset();
+        return status;
     }
-    catch (const std::exception &e)
+    JSONReader::get(json, "file_name", this->fileName);
+    this->width = dimension(json, "width");
+    this->height = dimension(json, "height");
+    return status;
+}
+
+JSONReader::Status Media::tryParseSizes(Media::Type type, const nlohmann::json &json)
+{
+    this->reset();
+    this->type = type;
+    if (!json.is_array())
+        return JSONReader::Status::WRONG_TYPE;
+
+    this->sizes.reserve(json.size());
+    for (const nlohmann::json &el : json)
     {
-        Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "parse failed: %s\n", e.what());
+        Size size;
+        if (size.tryParse(el) == JSONReader::Status::OK)
+            this->sizes.push_back(std::move(size));
     }
-    this->reset();
-    return false;
+    return this->useLargestSize();
+}
+
+JSONReader::Status Media::useLargestSize()
+{
+    if (this->sizes.empty())
+        return JSONReader::Status::MISSING;
+
+    const Size *largest = &this->sizes.front();
+    for (const Size &size : this->sizes)
+    {
+        if (area(size) > area(*largest) || (area(size) == area(*largest) && size.fileSize > largest->fileSize))
+            largest = &size;
+    }
+    this->fileSize = largest->fileSize;
+    this->width = largest->width;
+    this->height = largest->height;
+    this->fileId = largest->fileId;
+    this->fileUniqueId = largest->fileUniqueId;
+    return JSONReader::Status::OK;
+}
+
+Media::Size Media::bestFor(long long maxBytes, int maxDimension) const
+{
+    Size self;
+    self.fileSize = this->fileSize;
+    self.width = this->width;
+    self.height = this->height;
+    self.fileId = this->fileId;
+    self.fileUniqueId = this->fileUniqueId;
+    if (this->sizes.empty())
+        return self;
+
+    const Size *best = nullptr;
+    const Size *smallest = &this->sizes.front();
+    for (const Size &size : this->sizes)
+    {
+        if (area(size) < area(*smallest))
+            smallest = &size;
+        // an unreported file size is taken to fit
+        bool fits = (maxBytes <= 0 || size.fileSize <= maxBytes) &&
+                    (maxDimension <= 0 || (size.width <= maxDimension && size.height <= maxDimension));
+        if (fits && (best == nullptr || area(size) > area(*best)))
+            best = &size;
+    }
+    return best != nullptr ? *best : *smallest;
 }
 
 void Media::reset()
 {
     this->type = Media::Type::DOCUMENT;
     this->fileSize = 0;
+    this->width = 0;
+    this->height = 0;
     this->fileId.clear();
     this->fileUniqueId.clear();
     this->fileName.clear();
+    this->sizes.clear();
 }
 
 const std::string Media::getType() const
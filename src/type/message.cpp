@@ -1,7 +1,6 @@
 #include "type.hpp"
 #include "nlohmann/json.hpp"
-#include "json-validator.hpp"
-#include "utils/include/debug.hpp"
+#include "log.hpp"
 
 Message::Message()
 {
@@ -22,116 +21,70 @@ bool Message::empty() const
 
 bool Message::parse(const nlohmann::json &json)
 {
-    try
-    {
-        JSONValidator jval(__FILE__, __LINE__, __func__);
-
-        jval.validate<long long>(json, "date")
-            .onValid(
-                [this](const nlohmann::json &jsonDate)
-                {
-                    this->dtime = static_cast<time_t>(jsonDate.get<long long>());
-                })
-            .onInvalid(
-                [this]()
-                {
-                    this->dtime = 0;
-                });
+    JSONReader::Status status = this->tryParse(json);
+    if (status != JSONReader::Status::OK)
+        TG_LOG(Log::ERROR, "parse failed: %s\n", JSONReader::statusToString(status));
+    return status == JSONReader::Status::OK;
+}
 
-        this->id = jval.get<long long>(json, "message_id");
+JSONReader::Status Message::tryParse(const nlohmann::json &json)
+{
+    this->reset();
 
-        jval.validate<long long>(json, "message_thread_id")
-            .onValid(
-                [this](const nlohmann::json &jsonMTId)
-                {
-                    this->threadId = jsonMTId.get<long long>();
-                })
-            .onInvalid(
-                [this]()
-                {
-                    this->threadId = 0;
-                });
+    long long date = 0;
+    if (JSONReader::get(json, "date", date) == JSONReader::Status::OK)
+        this->dtime = static_cast<time_t>(date);
 
-        jval.validate<std::string>(json, "text")
-            .onValid(
-                [this](const nlohmann::json &jsonText)
-                {
-                    this->text = jsonText.get<std::string>();
-                })
-            .onInvalid(
-                [this]()
-                {
-                    this->text.clear();
-                });
+    JSONReader::Status status = JSONReader::get(json, "message_id", this->id);
+    const nlohmann::json *jsonFrom = JSONReader::object(json, "from");
+    const nlohmann::json *jsonChat = JSONReader::object(json, "chat");
+    if (status == JSONReader::Status::OK && (jsonFrom == nullptr || jsonChat == nullptr))
+        status = JSONReader::Status::MISSING;
+    if (status != JSONReader::Status::OK)
+    {
+        this->reset();
+        return status;
+    }
+    // sender and chat must be present; an incomplete one is left empty
+    this->from.tryParse(*jsonFrom);
+    this->chat.tryParse(*jsonChat);
 
-        jval.validate<std::string>(json, "caption")
-            .onValid(
-                [this](const nlohmann::json &jsonCaption)
-                {
-                    this->caption = jsonCaption.get<std::string>();
-                })
-            .onInvalid(
-                [this]()
-                {
-                    this->caption.clear();
-                });
-        const nlohmann::json &jsonFrom = jval.getObject(json, "from");
-        const nlohmann::json &jsonChat = jval.getObject(json, "chat");
-        this->from.parse(jsonFrom);
-        this->chat.parse(jsonChat);
+    if (JSONReader::get(json, "message_thread_id", this->threadId) != JSONReader::Status::OK)
+        this->threadId = 0;
+    JSONReader::get(json, "text", this->text);
+    JSONReader::get(json, "caption", this->caption);
+    JSONReader::get(json, "media_group_id", this->mediaGroupId);
 
-        jval.validate<std::string>(json, "reply_to_message")
-            .onValid(
-                [this](const nlohmann::json &jsonReplyToMessage)
-                {
-                    this->replyToMessage.reset(new Message());
-                    if (this->replyToMessage->parse(jsonReplyToMessage) == false)
-                    {
-                        this->replyToMessage.reset();
-                    }
-                })
-            .onInvalid(
-                [this]()
-                {
-                    this->replyToMessage.reset();
-                });
+    const nlohmann::json *jsonReply = JSONReader::object(json, "reply_to_message");
+    if (jsonReply != nullptr)
+    {
+        this->replyToMessage.reset(new Message());
+        if (this->replyToMessage->tryParse(*jsonReply) != JSONReader::Status::OK)
+            this->replyToMessage.reset();
+    }
 
-        Media::typeIteration(
-            [&](const Media::Type &type, const std::string &name)
+    Media::typeIteration(
+        [&](const Media::Type &type, const std::string &name)
+        {
+            const nlohmann::json *j = JSONReader::find(json, name.c_str());
+            if (j == nullptr)
+                return;
+            if (j->is_array())
             {
-                if (json.contains(name))
-                {
-                    const nlohmann::json j = json[name];
-                    if (j.is_array())
-                    {
-                        for (const nlohmann::json &el : j)
-                        {
-                            Media md;
-                            if (md.parse(type, el))
-                            {
-                                this->media.push_back(md);
-                            }
-                        }
-                    }
-                    else if (j.is_object())
-                    {
-                        Media md;
-                        if (md.parse(type, j))
-                        {
-                            this->media.push_back(md);
-                        }
-                    }
-                }
-            });
+                // a photo: one item carrying its resolutions
+                this->media.emplace_back();
+                if (this->media.back().tryParseSizes(type, *j) != JSONReader::Status::OK)
+                    this->media.pop_back();
+            }
+            else if (j->is_object())
+            {
+                Media md;
+                if (md.tryParse(type, *j) == JSONReader::Status::OK)
+                    this->media.push_back(md);
+            }
+        });
 
-        return true;
-    }
-    catch (const std::exception &e)
-    {
-        Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "parse failed: %s\n", e.what());
-    }
-    this->reset();
-    return false;
+    return status;
 }
 
 void Message::reset()
@@ -141,6 +94,7 @@ void Message::reset()
     this->threadId = 0;
     this->text.clear();
     this->caption.clear();
+    this->mediaGroupId.clear();
     this->from.reset();
     this->chat.reset();
     this->media.clear();
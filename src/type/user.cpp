@@ -1,7 +1,6 @@
 #include "type.hpp"
 #include "nlohmann/json.hpp"
-#include "json-validator.hpp"
-#include "utils/include/debug.hpp"
+#include "log.hpp"
 
 User::User()
 {
@@ -20,37 +19,30 @@ bool User::empty() const
 
 bool User::parse(const nlohmann::json &json)
 {
-    try
-    {
-        JSONValidator jval(__FILE__, __LINE__, __func__);
-        this->isBot = jval.get<bool>(json, "is_bot");
-        this->id = jval.get<long long>(json, "id");
-        this->firstName = jval.get<std::string>(json, "first_name");
-
-        jval.validate<std::string>(json, "last_name")
-            .onValid(
-                [&](const nlohmann::json &jsonLastName)
-                {
-                    this->lastName = jsonLastName.get<std::string>();
-                });
-
-        this->username = jval.get<std::string>(json, "username");
-
-        jval.validate<std::string>(json, "language_code")
-            .onValid(
-                [&](const nlohmann::json &jsonLangCode)
-                {
-                    this->languageCode = jsonLangCode.get<std::string>();
-                });
+    JSONReader::Status status = this->tryParse(json);
+    if (status != JSONReader::Status::OK)
+        TG_LOG(Log::ERROR, "parse failed: %s\n", JSONReader::statusToString(status));
+    return status == JSONReader::Status::OK;
+}
 
-        return true;
-    }
-    catch (const std::exception &e)
+JSONReader::Status User::tryParse(const nlohmann::json &json)
+{
+    this->reset();
+    JSONReader::Status status = JSONReader::get(json, "is_bot", this->isBot);
+    if (status == JSONReader::Status::OK)
+        status = JSONReader::get(json, "id", this->id);
+    if (status == JSONReader::Status::OK)
+        status = JSONReader::get(json, "first_name", this->firstName);
+    if (status == JSONReader::Status::OK)
+        status = JSONReader::get(json, "username", this->username);
+    if (status != JSONReader::Status::OK)
     {
-        Debug::log(Debug::ERROR, __FILE__, __LINE__, __func__, "parse failed: %s\n", e.what());
+        this->reset();
+        return status;
     }
-    this->reset();
-    return false;
+    JSONReader::get(json, "last_name", this->lastName);
+    JSONReader::get(json, "language_code", this->languageCode);
+    return status;
 }
 
 void User::reset()
@@ -0,0 +1,60 @@
+#include <cstring>
+#include "update-filter.hpp"
+
+UpdateFilter::Scan::Scan() : updateId(0), kind(Kind::OTHER), hasChat(false), chatType(Chat::Type::PRIVATE), chatId(0), text(nullptr), textLength(0) {}
+
+UpdateFilter::UpdateFilter() : kinds(0), chatTypes(0), chats(), prefixes() {}
+
+UpdateFilter::~UpdateFilter()
+{
+}
+
+UpdateFilter &UpdateFilter::kind(Kind kind)
+{
+    this->kinds |= static_cast<uint8_t>(1u << static_cast<uint8_t>(kind));
+    return *this;
+}
+
+UpdateFilter &UpdateFilter::chatType(Chat::Type type)
+{
+    this->chatTypes |= static_cast<uint8_t>(1u << static_cast<uint8_t>(type));
+    return *this;
+}
+
+UpdateFilter &UpdateFilter::chat(long long chatId)
+{
+    this->chats.insert(chatId);
+    return *this;
+}
+
+UpdateFilter &UpdateFilter::textPrefix(const std::string &prefix)
+{
+    this->prefixes.push_back(prefix);
+    return *this;
+}
+
+bool UpdateFilter::empty() const
+{
+    return this->kinds == 0 && this->chatTypes == 0 && this->chats.empty() && this->prefixes.empty();
+}
+
+bool UpdateFilter::accept(const Scan &scan) const
+{
+    if (this->kinds != 0 && (this->kinds & (1u << static_cast<uint8_t>(scan.kind))) == 0)
+        return false;
+    // chat criteria reject updates without a chat (e.g. inline callbacks)
+    if (this->chatTypes != 0 && (!scan.hasChat || (this->chatTypes & (1u << static_cast<uint8_t>(scan.chatType))) == 0))
+        return false;
+    if (!this->chats.empty() && (!scan.hasChat || this->chats.count(scan.chatId) == 0))
+        return false;
+    if (this->prefixes.empty())
+        return true;
+    if (scan.text == nullptr)
+        return false;
+    for (const std::string &prefix : this->prefixes)
+    {
+        if (scan.textLength >= prefix.size() && std::memcmp(scan.text, prefix.data(), prefix.size()) == 0)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,79 @@
+#include <stdexcept>
+#include "worker-pool.hpp"
+#include "log.hpp"
+
+WorkerPool::WorkerPool(std::size_t threads) : workers(), jobs(), stopping(false), mutex(), available()
+{
+    if (threads == 0)
+        threads = 1;
+    this->workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; i++)
+        this->workers.emplace_back(&WorkerPool::work, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+    this->shutdown();
+}
+
+void WorkerPool::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        if (this->stopping)
+            return;
+        this->jobs.push_back(std::move(job));
+    }
+    this->available.notify_one();
+}
+
+void WorkerPool::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> guard(this->mutex);
+        this->stopping = true;
+    }
+    this->available.notify_all();
+    for (std::thread &worker : this->workers)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+}
+
+std::size_t WorkerPool::size() const
+{
+    return this->workers.size();
+}
+
+std::size_t WorkerPool::pending() const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    return this->jobs.size();
+}
+
+void WorkerPool::work()
+{
+    for (;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->available.wait(lock,
+                                 [this]()
+                                 { return this->stopping || !this->jobs.empty(); });
+            if (this->jobs.empty())
+                return;
+            job = std::move(this->jobs.front());
+            this->jobs.pop_front();
+        }
+        try
+        {
+            job();
+        }
+        catch (const std::exception &e)
+        {
+            TG_LOG(Log::ERROR, "job failed: %s!\n", e.what());
+        }
+    }
+}
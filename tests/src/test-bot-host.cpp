@@ -0,0 +1,66 @@
+#include <atomic>
+#include <stdexcept>
+#include "doctest.h"
+#include "bot-host.hpp"
+#include "worker-pool.hpp"
+
+static void ignore(Telegram &, const NodeMessage &)
+{
+}
+
+// ---------------------------------------------------------------------------
+// WorkerPool
+// ---------------------------------------------------------------------------
+
+TEST_CASE("WorkerPool runs every queued job before shutdown returns")
+{
+    std::atomic<int> done(0);
+    WorkerPool pool(3);
+    CHECK(pool.size() == 3);
+    for (int i = 0; i < 100; i++)
+    {
+        pool.submit(
+            [&]()
+            {
+                done++;
+            });
+    }
+    pool.submit(
+        []()
+        {
+            throw std::runtime_error("job error");
+        });
+    pool.shutdown();
+    CHECK(done == 100);
+    CHECK(pool.pending() == 0);
+}
+
+// ---------------------------------------------------------------------------
+// BotHost — webhook routing
+// ---------------------------------------------------------------------------
+
+TEST_CASE("BotHost routes by path, then by secret token")
+{
+    BotHost host(1);
+    Telegram &byPath = host.addWebhook("1:a", "/bot/one", "", ignore);
+    Telegram &bySecret = host.addWebhook("2:b", "", "s2", ignore);
+    Telegram &both = host.addWebhook("3:c", "/bot/three", "s3", ignore);
+    host.addPolling("4:d", ignore);
+    CHECK(host.size() == 4);
+
+    CHECK(host.route("/bot/one", "") == &byPath);
+    CHECK(host.route("/anything", "s2") == &bySecret);
+    CHECK(host.route("/bot/three", "s3") == &both);
+    CHECK(host.route("/bot/three", "") == nullptr);
+    CHECK(host.route("/bot/three", "s2") == nullptr);
+    CHECK(host.route("/unknown", "") == nullptr);
+}
+
+TEST_CASE("BotHost rejects duplicate routes")
+{
+    BotHost host(1);
+    host.addWebhook("1:a", "/hook", "secret", ignore);
+    CHECK_THROWS(host.addWebhook("2:b", "/hook", "", ignore));
+    CHECK_THROWS(host.addWebhook("3:c", "/other", "secret", ignore));
+    CHECK_THROWS(host.addWebhook("4:d", "", "", ignore));
+}
@@ -0,0 +1,39 @@
+#include "doctest.h"
+#include "request.hpp"
+#include "telegram.hpp"
+
+// ---------------------------------------------------------------------------
+// Endpoint — precomputed method URLs
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Endpoint builds method and file URLs regardless of trailing slash")
+{
+    Endpoint a("https://api.telegram.org", "123:ABC");
+    Endpoint b("https://api.telegram.org/", "123:ABC");
+
+    CHECK(a.getUrl(Request::Type::SEND_MESSAGE) == "https://api.telegram.org/bot123:ABC/sendMessage");
+    CHECK(b.getUrl(Request::Type::SEND_MESSAGE) == a.getUrl(Request::Type::SEND_MESSAGE));
+    CHECK(a.getFileUrl() == "https://api.telegram.org/file/bot123:ABC/");
+    CHECK(a.getToken() == "123:ABC");
+}
+
+TEST_CASE("Endpoint::configure replaces every URL when the token changes")
+{
+    Endpoint e("http://localhost:8081", "old");
+    e.configure("http://localhost:8081", "new");
+
+    CHECK(e.getUrl(Request::Type::UPDATES) == "http://localhost:8081/botnew/getUpdates");
+    CHECK(e.getUrl(Request::Type::UNSET_WEBHOOK) == "http://localhost:8081/botnew/deleteWebhook");
+}
+
+TEST_CASE("Telegram keeps its base URL across token changes")
+{
+    Telegram telegram("1:a", "http://127.0.0.1:18081");
+    CHECK(telegram.getBaseUrl() == "http://127.0.0.1:18081");
+
+    telegram.setToken("2:b");
+    CHECK(telegram.getBaseUrl() == "http://127.0.0.1:18081");
+
+    telegram.setBaseUrl(TELEGRAM_BASE_URL);
+    CHECK(telegram.getBaseUrl() == TELEGRAM_BASE_URL);
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "doctest.h"
+#include "nlohmann/json.hpp"
+#include "json-writer.hpp"
+
+// ---------------------------------------------------------------------------
+// JSONWriter — structure and separators
+// ---------------------------------------------------------------------------
+
+TEST_CASE("JSONWriter emits flat object with comma separated fields")
+{
+    JSONWriter w;
+    w.beginObject()
+        .field("chat_id", 123456789LL)
+        .field("text", "hi")
+        .field("silent", true)
+        .endObject();
+    CHECK(w.str() == "{\"chat_id\":123456789,\"text\":\"hi\",\"silent\":true}");
+}
+
+TEST_CASE("JSONWriter handles nested arrays and objects")
+{
+    JSONWriter w;
+    w.beginObject().key("rows").beginArray();
+    for (int r = 0; r < 2; r++)
+    {
+        w.beginArray();
+        for (int c = 0; c < 2; c++)
+            w.beginObject().field("n", r * 2 + c).endObject();
+        w.endArray();
+    }
+    w.endArray().field("after", false).endObject();
+
+    nlohmann::json j = nlohmann::json::parse(w.str());
+    CHECK(j["rows"].size() == 2);
+    CHECK(j["rows"][1][1]["n"].get<int>() == 3);
+    CHECK(j["after"].get<bool>() == false);
+}
+
+TEST_CASE("JSONWriter::local is cleared on every acquisition")
+{
+    JSONWriter &a = JSONWriter::local();
+    a.beginObject().field("x", 1).endObject();
+    JSONWriter &b = JSONWriter::local();
+    CHECK(&a == &b);
+    CHECK(b.empty());
+    b.beginArray().value(2).endArray();
+    CHECK(b.str() == "[2]");
+}
+
+// ---------------------------------------------------------------------------
+// JSONWriter — string escaping
+// ---------------------------------------------------------------------------
+
+TEST_CASE("JSONWriter escapes quotes, backslashes and control characters")
+{
+    std::string text = "say \"hi\"\\\n\t\x01 done";
+    JSONWriter w;
+    w.beginObject().field("text", text).endObject();
+
+    CHECK(w.str() == "{\"text\":\"say \\\"hi\\\"\\\\\\n\\t\\u0001 done\"}");
+    CHECK(nlohmann::json::parse(w.str())["text"].get<std::string>() == text);
+}
+
+TEST_CASE("JSONWriter passes UTF-8 through unchanged")
+{
+    std::string text = "Halo \xF0\x9F\x91\x8B dunia";
+    JSONWriter w;
+    w.beginObject().field("text", text).endObject();
+    CHECK(nlohmann::json::parse(w.str())["text"].get<std::string>() == text);
+}
@@ -0,0 +1,58 @@
+#include <string>
+#include "doctest.h"
+#include "log.hpp"
+
+// ---------------------------------------------------------------------------
+// Log — runtime gating
+// ---------------------------------------------------------------------------
+
+static int evaluated = 0;
+
+static int sideEffect()
+{
+    return ++evaluated;
+}
+
+TEST_CASE("TG_LOG skips argument evaluation below the runtime level")
+{
+    Log::Level previous = Log::getLevel();
+    Log::setLevel(Log::ERROR);
+    evaluated = 0;
+
+    TG_LOG(Log::INFO, "value %d\n", sideEffect());
+    CHECK(evaluated == 0);
+    CHECK_FALSE(Log::enabled(Log::WARNING));
+    CHECK(Log::enabled(Log::ERROR));
+
+    Log::setLevel(previous);
+}
+
+TEST_CASE("Log::compiled rejects NONE regardless of the build level")
+{
+    CHECK_FALSE(Log::compiled(Log::NONE));
+}
+
+// ---------------------------------------------------------------------------
+// Log — async sink
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Log async mode can be started and stopped repeatedly")
+{
+    // records still go through the ring, but the worker drops them at NONE,
+    // so nothing reaches the console
+    Log::Level previous = Log::getLevel();
+    Log::setLevel(Log::NONE);
+
+    Log::startAsync();
+    CHECK(Log::isAsync());
+    Log::write(Log::ERROR, __FILE__, __LINE__, __func__, "async %s\n", "record");
+    Log::payload(Log::ERROR, __FILE__, __LINE__, __func__, "payload", std::string(4096, 'x'));
+    Log::stopAsync();
+    CHECK_FALSE(Log::isAsync());
+
+    Log::startAsync();
+    Log::stopAsync();
+    CHECK_FALSE(Log::isAsync());
+
+    Log::setLevel(previous);
+}
@@ -0,0 +1,135 @@
+#include "doctest.h"
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "media-group.hpp"
+#include "mock-bot-api.hpp"
+#include "telegram.hpp"
+#include "nlohmann/json.hpp"
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static nlohmann::json albumPart(long long updateId, long long messageId, long long chatId, const char *groupId, const char *caption)
+{
+    nlohmann::json message = {
+        {"message_id", messageId},
+        {"date", 1700000000},
+        {"from", {{"id", 5}, {"is_bot", false}, {"first_name", "u"}}},
+        {"chat", {{"id", chatId}, {"type", "private"}, {"first_name", "u"}}},
+        {"photo", {{{"file_id", "f" + std::to_string(messageId)}, {"file_unique_id", "u" + std::to_string(messageId)}, {"file_size", 10}}}}};
+    if (groupId != nullptr)
+        message["media_group_id"] = groupId;
+    if (caption != nullptr)
+        message["caption"] = caption;
+    return {{"update_id", updateId}, {"message", message}};
+}
+
+// ---------------------------------------------------------------------------
+// MediaGroupAggregator
+// ---------------------------------------------------------------------------
+
+TEST_CASE("MediaGroupAggregator folds album parts into one event")
+{
+    Telegram telegram("1:test", "http://127.0.0.1:1");
+    std::vector<MediaGroup> groups;
+    int passed = 0;
+
+    MediaGroupAggregator aggregator(60000);
+    aggregator.onGroup([&](Telegram &, const MediaGroup &group)
+                       { groups.push_back(group); });
+    MediaGroupAggregator::Handler handler = aggregator.handler([&](Telegram &, const NodeMessage &)
+                                                               { passed++; });
+
+    // parts may arrive out of order; the same group id in another chat is another album
+    handler(telegram, NodeMessage(albumPart(1, 12, 7, "g1", nullptr)));
+    handler(telegram, NodeMessage(albumPart(2, 11, 7, "g1", "trip")));
+    handler(telegram, NodeMessage(albumPart(3, 13, 8, "g1", nullptr)));
+    handler(telegram, NodeMessage(albumPart(4, 14, 7, nullptr, nullptr)));
+    CHECK(passed == 1);
+    CHECK(groups.empty());
+    CHECK(aggregator.pending() == 2);
+
+    aggregator.flush();
+    CHECK(aggregator.pending() == 0);
+    REQUIRE(groups.size() == 2);
+    const MediaGroup &album = groups[0].chat.id == 7 ? groups[0] : groups[1];
+    CHECK(album.id == "g1");
+    CHECK(album.caption == "trip");
+    REQUIRE(album.messageIds.size() == 2);
+    CHECK(album.messageIds[0] == 11);
+    CHECK(album.messageIds[1] == 12);
+    REQUIRE(album.media.size() == 2);
+    CHECK(album.media[0].fileId == "f11");
+}
+
+TEST_CASE("MediaGroupAggregator delivers after the window or when the album is full")
+{
+    Telegram telegram("1:test", "http://127.0.0.1:1");
+    std::mutex mutex;
+    std::vector<std::size_t> sizes;
+
+    MediaGroupAggregator aggregator(30);
+    aggregator.onGroup([&](Telegram &, const MediaGroup &group)
+                       {
+                           std::lock_guard<std::mutex> guard(mutex);
+                           sizes.push_back(group.media.size());
+                       });
+    MediaGroupAggregator::Handler handler = aggregator.handler();
+
+    for (long long i = 0; i < 10; i++)
+        handler(telegram, NodeMessage(albumPart(i, 100 + i, 7, "full", nullptr)));
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        REQUIRE(sizes.size() == 1);
+        CHECK(sizes[0] == 10);
+    }
+
+    handler(telegram, NodeMessage(albumPart(20, 200, 7, "quiet", nullptr)));
+    handler(telegram, NodeMessage(albumPart(21, 201, 7, "quiet", nullptr)));
+    for (int i = 0; i < 200; i++)
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            if (sizes.size() == 2)
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::lock_guard<std::mutex> guard(mutex);
+    REQUIRE(sizes.size() == 2);
+    CHECK(sizes[1] == 2);
+}
+
+TEST_CASE("MediaGroupAggregator keeps the committed offset below a pending album")
+{
+    MockBotApi api;
+    REQUIRE(api.pushMessage(7, "before") == 1);
+    api.pushUpdate(albumPart(2, 12, 7, "g1", nullptr).dump());
+    api.pushUpdate(albumPart(3, 13, 7, "g1", nullptr).dump());
+    REQUIRE(api.pushMessage(7, "after") == 4);
+    REQUIRE(api.start());
+
+    int albums = 0;
+    MediaGroupAggregator aggregator(60000);
+    aggregator.onGroup([&](Telegram &, const MediaGroup &)
+                       { albums++; });
+    Telegram telegram("1:test", api.getBaseUrl());
+    telegram.setCommitHold([&aggregator]()
+                           { return aggregator.oldestPendingUpdateId(); });
+
+    CHECK(telegram.getUpdates(aggregator.handler()));
+    CHECK(aggregator.oldestPendingUpdateId() == 2);
+    CHECK(telegram.getCommittedUpdateId() == 1);
+
+    // once the album is out, the parts come back once more and the offset catches up
+    aggregator.flush();
+    CHECK(albums == 1);
+    CHECK(aggregator.oldestPendingUpdateId() == 0);
+    CHECK(telegram.getUpdates(aggregator.handler()));
+    CHECK(albums == 1);
+    CHECK(telegram.getCommittedUpdateId() == 4);
+}
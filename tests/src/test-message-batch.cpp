@@ -0,0 +1,102 @@
+#include "doctest.h"
+#include <map>
+#include <vector>
+#include "nlohmann/json.hpp"
+#include "telegram.hpp"
+#include "metrics.hpp"
+#include "mock-bot-api.hpp"
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static uint64_t failedDeletes()
+{
+    return Metrics::global()
+        .counter("tessergram_api_requests_total", Metrics::label("method", "deleteMessages") + ",result=\"error\"", "Bot API requests by method and result")
+        .value();
+}
+
+// message_ids of each recorded deleteMessages request, grouped by chat in request order
+static std::map<long long, std::vector<std::vector<long long>>> deletedChunks(const MockBotApi &api)
+{
+    std::map<long long, std::vector<std::vector<long long>>> chunks;
+    for (const std::string &body : api.getRequestBodies("deleteMessages"))
+    {
+        nlohmann::json json = nlohmann::json::parse(body);
+        chunks[json["chat_id"].get<long long>()].push_back(json["message_ids"].get<std::vector<long long>>());
+    }
+    return chunks;
+}
+
+static std::vector<long long> descending(long long count)
+{
+    std::vector<long long> ids;
+    for (long long i = count; i > 0; i--)
+        ids.push_back(i);
+    return ids;
+}
+
+// ---------------------------------------------------------------------------
+// Telegram — batched deletes
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Telegram deletes in chunks and stops a chat at its first failed chunk")
+{
+    Telegram telegram("1:test", "http://127.0.0.1:1");
+    std::vector<long long> ids = descending(250);
+
+    uint64_t before = failedDeletes();
+    CHECK(telegram.apiDeleteMessages(5, std::vector<long long>()));
+    CHECK(failedDeletes() == before);
+
+    CHECK_FALSE(telegram.apiDeleteMessages(5, ids));
+    CHECK(failedDeletes() - before == 1);
+
+    std::map<long long, std::vector<long long>> byChat = {{5, ids}, {6, ids}, {7, {1}}};
+    CHECK_FALSE(telegram.apiDeleteMessages(byChat, 3));
+    CHECK(failedDeletes() - before == 4);
+}
+
+TEST_CASE("Telegram deletes unsorted ids as sorted chunks of at most 100")
+{
+    MockBotApi api;
+    REQUIRE(api.start());
+    Telegram telegram("1:test", api.getBaseUrl());
+
+    std::vector<long long> ids = descending(250);
+    ids.push_back(7);
+    REQUIRE(telegram.apiDeleteMessages(5, ids));
+
+    std::map<long long, std::vector<std::vector<long long>>> chunks = deletedChunks(api);
+    REQUIRE(chunks[5].size() == 3);
+    CHECK(chunks[5][0].size() == 100);
+    CHECK(chunks[5][1].size() == 100);
+    CHECK(chunks[5][2].size() == 50);
+    long long expected = 1;
+    for (const std::vector<long long> &chunk : chunks[5])
+    {
+        for (long long id : chunk)
+            CHECK(id == expected++);
+    }
+}
+
+TEST_CASE("Telegram deletes per chat in parallel and succeeds when every chunk does")
+{
+    MockBotApi api;
+    REQUIRE(api.start());
+    Telegram telegram("1:test", api.getBaseUrl());
+
+    uint64_t before = failedDeletes();
+    std::map<long long, std::vector<long long>> byChat = {{5, descending(250)}, {6, descending(120)}, {7, {1}}};
+    CHECK(telegram.apiDeleteMessages(byChat, 3));
+    CHECK(failedDeletes() == before);
+
+    std::map<long long, std::vector<std::vector<long long>>> chunks = deletedChunks(api);
+    CHECK(chunks[5].size() == 3);
+    REQUIRE(chunks[6].size() == 2);
+    CHECK(chunks[6][0].front() == 1);
+    CHECK(chunks[6][1].front() == 101);
+    CHECK(chunks[7].size() == 1);
+    CHECK(api.getRequestCount("deleteMessages") == 6);
+}
@@ -2,6 +2,7 @@
 #include "doctest.h"
 #include "nlohmann/json.hpp"
 #include "type.hpp"
+#include "node-message.hpp"
 
 // ---------------------------------------------------------------------------
 // Helpers
@@ -117,6 +118,38 @@ TEST_CASE("Message::parse captures caption field when text is absent")
     CHECK(m.caption == "photo caption");
 }
 
+// ---------------------------------------------------------------------------
+// Message::parse — photo sizes
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Message::parse keeps a photo as one item and picks a size for limits")
+{
+    nlohmann::json sizes = nlohmann::json::array();
+    for (int i = 0; i < 4; i++)
+        sizes.push_back({{"file_id", "p" + std::to_string(i)}, {"file_unique_id", "u" + std::to_string(i)},
+                         {"file_size", 1000 << (i * 2)}, {"width", 90 << i}, {"height", 60 << i}});
+    nlohmann::json j = {
+        {"message_id", 12ULL},
+        {"date", 1700000005ULL},
+        {"from", makeUser()},
+        {"chat", makeChat()},
+        {"photo", sizes}};
+
+    Message m;
+    CHECK(m.parse(j));
+    REQUIRE(m.media.size() == 1);
+    const Media &photo = m.media[0];
+    CHECK(photo.type == Media::Type::PHOTO);
+    CHECK(photo.sizes.size() == 4);
+    CHECK(photo.fileId == "p3");
+    CHECK(photo.width == 720);
+
+    CHECK(photo.bestFor(0).fileId == "p3");
+    CHECK(photo.bestFor(20000).fileId == "p2");
+    CHECK(photo.bestFor(0, 200).fileId == "p1");
+    CHECK(photo.bestFor(1).fileId == "p0");
+}
+
 // ---------------------------------------------------------------------------
 // Message::parse — empty() contract
 // ---------------------------------------------------------------------------
@@ -150,3 +183,42 @@ TEST_CASE("Message::parse returns false and resets on missing mandatory field")
     CHECK_FALSE(m.parse(j));
     CHECK(m.empty());
 }
+
+// ---------------------------------------------------------------------------
+// NodeMessage::tryParse — status codes instead of exceptions
+// ---------------------------------------------------------------------------
+
+TEST_CASE("NodeMessage::tryParse reports unknown and broken updates by status")
+{
+    NodeMessage update;
+    nlohmann::json edited = {
+        {"update_id", 10},
+        {"edited_message", {{"message_id", 1}, {"date", 1700000000}, {"from", makeUser()}, {"chat", makeChat()}}}};
+    CHECK(update.tryParse(edited) == JSONReader::Status::UNKNOWN_KIND);
+    CHECK(update.getId() == 10);
+
+    CHECK(update.tryParse(nlohmann::json{{"message", {{"message_id", 1}}}}) == JSONReader::Status::MISSING);
+    CHECK(update.tryParse(nlohmann::json{{"update_id", "x"}}) == JSONReader::Status::WRONG_TYPE);
+
+    nlohmann::json message = {
+        {"update_id", 11},
+        {"message", {{"message_id", 2}, {"date", 1700000000}, {"from", makeUser()}, {"chat", makeChat("group")}, {"text", "hi"}}}};
+    CHECK(update.tryParse(message) == JSONReader::Status::OK);
+    CHECK_THROWS_AS(update.parse(edited), std::runtime_error);
+}
+
+TEST_CASE("CallbackQuery::tryParse accepts the id as a numeric string")
+{
+    nlohmann::json j = {
+        {"id", "4382901234567"},
+        {"from", makeUser()},
+        {"data", "vote:1"}};
+
+    CallbackQuery query;
+    CHECK(query.tryParse(j) == JSONReader::Status::OK);
+    CHECK(query.id == 4382901234567LL);
+
+    j["id"] = "43x";
+    CHECK(query.tryParse(j) == JSONReader::Status::WRONG_TYPE);
+    CHECK(query.empty());
+}
@@ -0,0 +1,60 @@
+#include <string>
+#include "doctest.h"
+#include "metrics.hpp"
+
+// ---------------------------------------------------------------------------
+// Metrics — registry and snapshot
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Metrics returns the same series for the same name and labels")
+{
+    Metrics metrics;
+    Metrics::Counter &a = metrics.counter("test_total", "k=\"v\"", "help");
+    Metrics::Counter &b = metrics.counter("test_total", "k=\"v\"", "help");
+    Metrics::Counter &c = metrics.counter("test_total", "k=\"w\"", "help");
+
+    a.add();
+    b.add(2);
+    CHECK(&a == &b);
+    CHECK(&a != &c);
+    CHECK(a.value() == 3);
+    CHECK(metrics.snapshot().size() == 2);
+}
+
+TEST_CASE("Metrics histogram places observations into cumulative buckets")
+{
+    Metrics metrics;
+    Metrics::Histogram &h = metrics.histogram("latency_seconds", "", "help");
+    h.observe(0.0005);
+    h.observe(0.2);
+    h.observe(60.0);
+
+    std::vector<Metrics::Sample> samples = metrics.snapshot();
+    REQUIRE(samples.size() == 1);
+    CHECK(samples[0].count == 3);
+    CHECK(samples[0].buckets.front() == 1);
+    CHECK(samples[0].buckets.back() == 1);
+
+    std::string text = metrics.exportPrometheus();
+    CHECK(text.find("# TYPE latency_seconds histogram\n") != std::string::npos);
+    CHECK(text.find("latency_seconds_bucket{le=\"+Inf\"} 3\n") != std::string::npos);
+    CHECK(text.find("latency_seconds_count 3\n") != std::string::npos);
+}
+
+TEST_CASE("Metrics export groups series of one family under a single header")
+{
+    Metrics metrics;
+    metrics.counter("a_total", Metrics::label("m", "x"), "A").add();
+    metrics.gauge("b", "", "B").set(-4);
+    metrics.counter("a_total", Metrics::label("m", "y\"z"), "A").add(5);
+
+    std::string text = metrics.exportPrometheus();
+    CHECK(text ==
+          "# HELP a_total A\n"
+          "# TYPE a_total counter\n"
+          "a_total{m=\"x\"} 1\n"
+          "a_total{m=\"y\\\"z\"} 5\n"
+          "# HELP b B\n"
+          "# TYPE b gauge\n"
+          "b -4\n");
+}
@@ -0,0 +1,27 @@
+#include "doctest.h"
+#include "mock-bot-api.hpp"
+
+// ---------------------------------------------------------------------------
+// MockBotApi — update queue
+// ---------------------------------------------------------------------------
+
+TEST_CASE("MockBotApi numbers generated updates after pushed ones")
+{
+    MockBotApi api;
+    CHECK(api.pushUpdate("{\"update_id\":40,\"message\":{}}") == 40);
+    CHECK(api.pushMessage(7, "hi") == 41);
+    CHECK(api.pushMessage(7, "again") == 42);
+    CHECK(api.pendingUpdates() == 3);
+    CHECK_THROWS(api.pushUpdate("{\"message\":{}}"));
+}
+
+TEST_CASE("MockBotApi starts and stops cleanly")
+{
+    MockBotApi api;
+    REQUIRE(api.start());
+    CHECK(api.start());
+    CHECK(api.getBaseUrl().find("127.0.0.1:0") == std::string::npos);
+    api.stop();
+    CHECK(api.getRequestCount() == 0);
+    CHECK(api.getRequestCount("getUpdates") == 0);
+}
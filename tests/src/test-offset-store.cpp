@@ -0,0 +1,148 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "doctest.h"
+#include "mock-bot-api.hpp"
+#include "offset-store.hpp"
+#include "telegram.hpp"
+
+static std::string tempOffsetPath()
+{
+    char path[] = "/tmp/tessergram-offset-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0)
+        close(fd);
+    return path;
+}
+
+// ---------------------------------------------------------------------------
+// FileOffsetStore — persistence
+// ---------------------------------------------------------------------------
+
+TEST_CASE("FileOffsetStore keeps the highest committed id across reopen")
+{
+    std::string path = tempOffsetPath();
+    {
+        FileOffsetStore store(path, 4, 1000);
+        CHECK(store.load() == 0);
+        store.commit(100);
+        store.commit(250);
+        store.commit(200);
+    }
+    {
+        FileOffsetStore store(path);
+        CHECK(store.load() == 250);
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("FileOffsetStore::defaultPath uses the bot id, not the secret")
+{
+    std::string path = FileOffsetStore::defaultPath("12345:secret-part");
+    CHECK(path.find("12345.offset") != std::string::npos);
+    CHECK(path.find("secret") == std::string::npos);
+}
+
+// ---------------------------------------------------------------------------
+// Telegram — resume and duplicate suppression
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Telegram resumes from the stored offset and drops redelivered updates")
+{
+    std::string path = tempOffsetPath();
+    {
+        FileOffsetStore store(path);
+        store.commit(10);
+    }
+
+    Telegram telegram;
+    telegram.setOffsetStore(std::make_shared<FileOffsetStore>(path));
+    CHECK(telegram.getCommittedUpdateId() == 10);
+
+    int handled = 0;
+    telegram.setWebhookCallback(
+        [&](Telegram &, const NodeMessage &)
+        {
+            handled++;
+        });
+
+    CHECK(telegram.parseGetUpdatesResponse(MockBotApi::updatesResponse(8, 12)));
+    telegram.execWebhookCallback();
+    CHECK(handled == 2);
+
+    // the same batch again (offset not committed yet) yields nothing new
+    CHECK(telegram.parseGetUpdatesResponse(MockBotApi::updatesResponse(11, 12)));
+    telegram.execWebhookCallback();
+    CHECK(handled == 2);
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Pipelined polling redelivers a batch whose handlers did not finish")
+{
+    MockBotApi api;
+    for (int i = 0; i < 10; i++)
+        api.pushMessage(7, "m" + std::to_string(i));
+    REQUIRE(api.start());
+    std::string path = tempOffsetPath();
+
+    // the first bot handles batch 1..5, then "crashes" inside the handler of
+    // update 7 while its fetcher keeps polling
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool crashed = false;
+    bool released = false;
+    Telegram first("1:test", api.getBaseUrl());
+    first.setOffsetStore(std::make_shared<FileOffsetStore>(path));
+    first.setPipelining(true);
+    first.setPollLimit(5, 5);
+    std::thread loop(
+        [&]()
+        {
+            first.runFor(5000,
+                         [&](Telegram &t, const NodeMessage &update)
+                         {
+                             if (update.getId() != 7)
+                                 return;
+                             std::unique_lock<std::mutex> lock(mutex);
+                             crashed = true;
+                             changed.notify_all();
+                             changed.wait(lock, [&]()
+                                          { return released; });
+                             t.stop();
+                         });
+        });
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(changed.wait_for(lock, std::chrono::seconds(3), [&]()
+                                 { return crashed; }));
+    }
+    for (int attempt = 0; api.getRequestCount("getUpdates") < 4 && attempt < 200; attempt++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    // a restarted bot resumes from the stored offset and gets batch 6..10 again
+    std::vector<long long> redelivered;
+    Telegram second("1:test", api.getBaseUrl());
+    second.setOffsetStore(std::make_shared<FileOffsetStore>(path));
+    CHECK(second.getCommittedUpdateId() == 5);
+    CHECK(second.getUpdates(
+        [&](Telegram &, const NodeMessage &update)
+        {
+            redelivered.push_back(update.getId());
+        }));
+    CHECK(redelivered == std::vector<long long>({6, 7, 8, 9, 10}));
+
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        released = true;
+    }
+    changed.notify_all();
+    loop.join();
+    std::remove(path.c_str());
+}
@@ -0,0 +1,134 @@
+#include <chrono>
+#include <thread>
+#include "doctest.h"
+#include "polling-controller.hpp"
+
+// ---------------------------------------------------------------------------
+// PollingController — scheduling
+// ---------------------------------------------------------------------------
+
+TEST_CASE("PollingController::run polls immediately and then blocks until due")
+{
+    PollingController pc(40, 200);
+    int calls = 0;
+    auto poll = [&]()
+    {
+        calls++;
+        return true;
+    };
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    pc.run(poll);
+    pc.run(poll);
+    long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    CHECK(calls == 2);
+    CHECK(elapsed >= 35);
+}
+
+TEST_CASE("PollingController::cancel interrupts a pending wait without polling")
+{
+    PollingController pc(5000, 10000);
+    int calls = 0;
+    pc.run([&]()
+           { calls++; return true; });
+
+    std::thread canceller([&]()
+                          {
+                              std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                              pc.cancel(); });
+    pc.run([&]()
+           { calls++; return true; });
+    canceller.join();
+
+    CHECK(calls == 1);
+}
+
+// ---------------------------------------------------------------------------
+// PollingController — adaptation
+// ---------------------------------------------------------------------------
+
+TEST_CASE("PollingController backs off exponentially with bounded jitter")
+{
+    PollingController pc(10, 80);
+    pc.setFailureThreshold(2);
+
+    // a retry never comes sooner than a normal poll
+    pc.run([]()
+           { return false; });
+    CHECK(pc.getState() == PollingController::State::NORMAL);
+    CHECK(pc.getCurrentInterval() >= 10);
+    CHECK(pc.getCurrentInterval() <= 20);
+
+    pc.run([]()
+           { return false; });
+    CHECK(pc.getState() == PollingController::State::SLOW);
+    CHECK(pc.getCurrentInterval() >= 20);
+    CHECK(pc.getCurrentInterval() <= 40);
+
+    for (int i = 0; i < 4; i++)
+        pc.run([]()
+               { return false; });
+    CHECK(pc.getCurrentInterval() >= 40);
+    CHECK(pc.getCurrentInterval() <= 80);
+
+    pc.run([]()
+           { return true; });
+    CHECK(pc.getState() == PollingController::State::NORMAL);
+    CHECK(pc.getCurrentInterval() == 10);
+}
+
+TEST_CASE("PollingController tightens the interval while updates keep arriving")
+{
+    PollingController pc(8, 16);
+    pc.setMinInterval(2);
+
+    pc.run([&]()
+           { pc.observe(5); return true; });
+    CHECK(pc.getState() == PollingController::State::BUSY);
+    CHECK(pc.getCurrentInterval() == 4);
+
+    pc.run([&]()
+           { pc.observe(5); return true; });
+    pc.run([&]()
+           { pc.observe(5); return true; });
+    CHECK(pc.getCurrentInterval() == 2);
+
+    pc.run([]()
+           { return true; });
+    CHECK(pc.getState() == PollingController::State::NORMAL);
+    CHECK(pc.getCurrentInterval() == 4);
+}
+
+TEST_CASE("PollingController grows the limit on full batches and caps it by handler rate")
+{
+    PollingController pc(8, 16);
+    CHECK(pc.getLimit() == 0);
+    pc.observeFetched(100);
+    CHECK(pc.getLimit() == 0);
+
+    pc.setLimitRange(10, 100);
+    CHECK(pc.getLimit() == 10);
+    pc.observeFetched(10);
+    CHECK(pc.getLimit() == 20);
+    pc.observeFetched(20);
+    pc.observeFetched(40);
+    CHECK(pc.getLimit() == 80);
+    pc.observeFetched(80);
+    CHECK(pc.getLimit() == 100);
+    pc.observeFetched(3);
+    CHECK(pc.getLimit() == 100);
+
+    // 30 updates per second against a 1 s target: batches of 30
+    pc.observeHandled(30, std::chrono::seconds(1));
+    CHECK(pc.getLimit() == 30);
+    pc.observeFetched(30);
+    CHECK(pc.getLimit() == 30);
+
+    // the rate is smoothed, and the limit never drops below the minimum
+    pc.observeHandled(1, std::chrono::seconds(10));
+    CHECK(pc.getLimit() == 21);
+    for (int i = 0; i < 5; i++)
+        pc.observeHandled(1, std::chrono::seconds(10));
+    CHECK(pc.getLimit() == 10);
+}
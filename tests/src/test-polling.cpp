@@ -0,0 +1,221 @@
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "doctest.h"
+#include "mock-bot-api.hpp"
+#include "telegram.hpp"
+
+// ---------------------------------------------------------------------------
+// Telegram — pipelined polling against MockBotApi
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Pipelined polling handles every update once and commits after the handlers")
+{
+    MockBotApi api;
+    for (int i = 0; i < 30; i++)
+        api.pushMessage(7, "m" + std::to_string(i));
+    REQUIRE(api.start());
+
+    Telegram telegram("1:test", api.getBaseUrl());
+    telegram.setPipelining(true);
+    telegram.setPollLimit(10, 10);
+
+    std::vector<long long> handled;
+    telegram.runFor(5000,
+                    [&](Telegram &t, const NodeMessage &update)
+                    {
+                        handled.push_back(update.getId());
+                        if (handled.size() == 30)
+                            t.stop();
+                    });
+
+    REQUIRE(handled.size() == 30);
+    for (std::size_t i = 0; i < handled.size(); i++)
+        CHECK(handled[i] == static_cast<long long>(i) + 1);
+    CHECK(telegram.getCommittedUpdateId() == 30);
+}
+
+TEST_CASE("Pipelined polling hands batches over in order without waiting the poll interval")
+{
+    MockBotApi api;
+    for (int i = 0; i < 10; i++)
+        api.pushMessage(7, "m" + std::to_string(i));
+    REQUIRE(api.start());
+
+    Telegram telegram("1:test", api.getBaseUrl());
+    telegram.setPipelining(true);
+    telegram.setPollLimit(5, 5);
+
+    // update id and the offset committed when its handler ran
+    std::vector<std::pair<long long, long long>> seen;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    telegram.runFor(5000,
+                    [&](Telegram &t, const NodeMessage &update)
+                    {
+                        seen.emplace_back(update.getId(), t.getCommittedUpdateId());
+                        if (seen.size() == 10)
+                            t.stop();
+                    });
+
+    // the controller's normal interval is 3 s; the second batch must not wait for it
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000));
+    REQUIRE(seen.size() == 10);
+    for (std::size_t i = 0; i < seen.size(); i++)
+    {
+        CHECK(seen[i].first == static_cast<long long>(i) + 1);
+        CHECK(seen[i].second == (i < 5 ? 0 : 5));
+    }
+    CHECK(telegram.getCommittedUpdateId() == 10);
+    CHECK(api.getRequestCount("getUpdates") >= 2);
+}
+
+TEST_CASE("Pipelined polling lets a handler exception propagate and redelivers its batch")
+{
+    MockBotApi api;
+    for (int i = 0; i < 10; i++)
+        api.pushMessage(7, "m" + std::to_string(i));
+    REQUIRE(api.start());
+
+    Telegram telegram("1:test", api.getBaseUrl());
+    telegram.setPipelining(true);
+    telegram.setPollLimit(5, 5);
+
+    CHECK_THROWS_AS(telegram.runFor(5000,
+                                    [](Telegram &, const NodeMessage &update)
+                                    {
+                                        if (update.getId() == 3)
+                                            throw std::runtime_error("handler failed");
+                                    }),
+                    std::runtime_error);
+    CHECK_FALSE(telegram.isRunning());
+    CHECK(telegram.getCommittedUpdateId() == 0);
+
+    // nothing of the failed batch was acknowledged, so the next run starts over
+    std::vector<long long> handled;
+    telegram.runFor(5000,
+                    [&](Telegram &t, const NodeMessage &update)
+                    {
+                        handled.push_back(update.getId());
+                        if (handled.size() == 10)
+                            t.stop();
+                    });
+    REQUIRE(handled.size() == 10);
+    CHECK(handled.front() == 1);
+    CHECK(handled.back() == 10);
+    CHECK(telegram.getCommittedUpdateId() == 10);
+}
+
+// ---------------------------------------------------------------------------
+// Telegram — run, runFor and stop
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Telegram::runFor returns by its deadline while no updates arrive")
+{
+    MockBotApi api;
+    REQUIRE(api.start());
+    Telegram telegram("1:test", api.getBaseUrl());
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    telegram.runFor(300, [](Telegram &, const NodeMessage &) {});
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+    CHECK(elapsed >= std::chrono::milliseconds(300));
+    CHECK(elapsed < std::chrono::milliseconds(1000));
+    CHECK_FALSE(telegram.isRunning());
+}
+
+TEST_CASE("Telegram::stop from a handler ends run after the current batch")
+{
+    MockBotApi api;
+    for (int i = 0; i < 3; i++)
+        api.pushMessage(7, "m" + std::to_string(i));
+    REQUIRE(api.start());
+    Telegram telegram("1:test", api.getBaseUrl());
+
+    int handled = 0;
+    telegram.run(
+        [&](Telegram &t, const NodeMessage &)
+        {
+            handled++;
+            t.stop();
+        });
+    CHECK(handled == 3);
+    CHECK(telegram.getCommittedUpdateId() == 3);
+    CHECK_FALSE(telegram.isRunning());
+}
+
+TEST_CASE("Telegram::stop from another thread ends run, even before it has started")
+{
+    MockBotApi api;
+    REQUIRE(api.start());
+    Telegram telegram("1:test", api.getBaseUrl());
+
+    std::thread stopper(
+        [&telegram]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            telegram.stop();
+        });
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    telegram.run([](Telegram &, const NodeMessage &) {});
+    stopper.join();
+    // the poll interval is 3 s, so stop() had to interrupt the wait
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000));
+
+    // a stop() that lands before run() is not lost, and is used up by it
+    telegram.stop();
+    start = std::chrono::steady_clock::now();
+    telegram.run([](Telegram &, const NodeMessage &) {});
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100));
+    CHECK(api.getRequestCount("getUpdates") == 1);
+
+    start = std::chrono::steady_clock::now();
+    telegram.runFor(100, [](Telegram &, const NodeMessage &) {});
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(100));
+}
+
+TEST_CASE("Telegram::stop does not cancel a poll after the run it ended")
+{
+    MockBotApi api;
+    api.pushMessage(7, "m");
+    REQUIRE(api.start());
+    Telegram telegram("1:test", api.getBaseUrl());
+
+    // a stop() consumed by run() before its first poll
+    telegram.stop();
+    telegram.run([](Telegram &, const NodeMessage &) {});
+    CHECK(api.getRequestCount("getUpdates") == 0);
+
+    int handled = 0;
+    telegram.getUpdatesPoll([&](Telegram &, const NodeMessage &)
+                            { handled++; });
+    CHECK(api.getRequestCount("getUpdates") == 1);
+    CHECK(handled == 1);
+}
+
+// ---------------------------------------------------------------------------
+// Telegram — getUpdates request
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Telegram sends allowed updates and the adaptive limit with getUpdates")
+{
+    MockBotApi api;
+    for (int i = 0; i < 4; i++)
+        api.pushMessage(1, "m" + std::to_string(i));
+    REQUIRE(api.start());
+    Telegram telegram("1:test", api.getBaseUrl());
+    telegram.setAllowedUpdates({"message", "callback_query"});
+    telegram.setPollLimit(2, 8);
+
+    // a full batch doubles the limit; the same batch redelivered is not new
+    // and must not double it again
+    CHECK(telegram.getUpdates([](Telegram &, const NodeMessage &) {}));
+    CHECK(telegram.parseGetUpdatesResponse(MockBotApi::updatesResponse(1, 2)));
+    CHECK(telegram.getUpdates([](Telegram &, const NodeMessage &) {}));
+
+    std::vector<std::string> bodies = api.getRequestBodies("getUpdates");
+    REQUIRE(bodies.size() == 2);
+    CHECK(bodies[0] == "{\"limit\":2,\"allowed_updates\":[\"message\",\"callback_query\"]}");
+    CHECK(bodies[1] == "{\"offset\":3,\"limit\":4,\"allowed_updates\":[\"message\",\"callback_query\"]}");
+}
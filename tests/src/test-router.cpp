@@ -0,0 +1,120 @@
+#include <stdexcept>
+#include <string>
+#include "doctest.h"
+#include "router.hpp"
+#include "nlohmann/json.hpp"
+
+static nlohmann::json textUpdate(const std::string &text)
+{
+    return nlohmann::json::parse(
+        "{\"update_id\":1,\"message\":{\"message_id\":1,\"date\":1700000000,"
+        "\"from\":{\"id\":7,\"is_bot\":false,\"first_name\":\"T\"},"
+        "\"chat\":{\"id\":7,\"type\":\"private\",\"first_name\":\"T\"},"
+        "\"text\":" + nlohmann::json(text).dump() + "}}");
+}
+
+static nlohmann::json callbackUpdate(const std::string &data)
+{
+    return nlohmann::json::parse(
+        "{\"update_id\":2,\"callback_query\":{\"id\":\"99\",\"chat_instance\":\"c\","
+        "\"from\":{\"id\":7,\"is_bot\":false,\"first_name\":\"T\"},"
+        "\"data\":" + nlohmann::json(data).dump() + "}}");
+}
+
+// ---------------------------------------------------------------------------
+// Router — commands
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Router dispatches commands with their arguments")
+{
+    Telegram telegram;
+    Router router;
+    std::string seen;
+    router.setUsername("@MyBot");
+    router.command("/start",
+                   [&](Telegram &, const Message &, const std::string &args)
+                   {
+                       seen = "start:" + args;
+                   })
+        .command("Help",
+                 [&](Telegram &, const Message &, const std::string &args)
+                 {
+                     seen = "help:" + args;
+                 });
+
+    CHECK(router.dispatch(telegram, NodeMessage(textUpdate("/start  deep-link"))));
+    CHECK(seen == "start:deep-link");
+    CHECK(router.dispatch(telegram, NodeMessage(textUpdate("/HELP@mybot"))));
+    CHECK(seen == "help:");
+
+    seen.clear();
+    CHECK_FALSE(router.dispatch(telegram, NodeMessage(textUpdate("/help@OtherBot"))));
+    CHECK_FALSE(router.dispatch(telegram, NodeMessage(textUpdate("/unknown"))));
+    CHECK(seen.empty());
+
+    CHECK_THROWS_AS(router.command("/", [](Telegram &, const Message &, const std::string &) {}), std::runtime_error);
+}
+
+TEST_CASE("Router tries patterns after commands and then the fallback")
+{
+    Telegram telegram;
+    Router router;
+    std::string seen;
+    router.command("/price",
+                   [&](Telegram &, const Message &, const std::string &)
+                   {
+                       seen = "command";
+                   })
+        .pattern("^/?price ([0-9]+)$",
+                 [&](Telegram &, const Message &, const std::smatch &match)
+                 {
+                     seen = "pattern:" + match[1].str();
+                 })
+        .fallback(
+            [&](Telegram &, const NodeMessage &)
+            {
+                seen = "fallback";
+            });
+
+    router.dispatch(telegram, NodeMessage(textUpdate("/price 10")));
+    CHECK(seen == "command");
+    router.dispatch(telegram, NodeMessage(textUpdate("price 42")));
+    CHECK(seen == "pattern:42");
+    router.dispatch(telegram, NodeMessage(textUpdate("hello")));
+    CHECK(seen == "fallback");
+
+    CHECK_THROWS_AS(router.pattern("([", [](Telegram &, const Message &, const std::smatch &) {}), std::runtime_error);
+}
+
+// ---------------------------------------------------------------------------
+// Router — callback prefixes
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Router picks the longest callback-data prefix")
+{
+    Telegram telegram;
+    Router router;
+    std::string seen;
+    for (int i = 0; i < 300; i++)
+    {
+        std::string prefix = "item:" + std::to_string(i) + ":";
+        router.callback(prefix,
+                        [&seen, prefix](Telegram &, const CallbackQuery &, const std::string &rest)
+                        {
+                            seen = prefix + "|" + rest;
+                        });
+    }
+    router.callback("item:",
+                    [&](Telegram &, const CallbackQuery &, const std::string &rest)
+                    {
+                        seen = "any|" + rest;
+                    });
+
+    CHECK(router.dispatch(telegram, NodeMessage(callbackUpdate("item:12:buy"))));
+    CHECK(seen == "item:12:|buy");
+    CHECK(router.dispatch(telegram, NodeMessage(callbackUpdate("item:299:"))));
+    CHECK(seen == "item:299:|");
+    CHECK(router.dispatch(telegram, NodeMessage(callbackUpdate("item:1000:x"))));
+    CHECK(seen == "any|1000:x");
+    CHECK_FALSE(router.dispatch(telegram, NodeMessage(callbackUpdate("other"))));
+}
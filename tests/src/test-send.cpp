@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "doctest.h"
+#include "mock-bot-api.hpp"
+#include "telegram.hpp"
+
+// ---------------------------------------------------------------------------
+// Telegram — sent message results against MockBotApi
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Telegram returns the sent message from sendMessage, keyboards and uploads")
+{
+    MockBotApi api;
+    REQUIRE(api.start());
+    Telegram telegram("1:test", api.getBaseUrl());
+
+    Message sent;
+    REQUIRE(telegram.apiSendMessage(42, "hello", sent));
+    CHECK(sent.id > 0);
+    CHECK(sent.chat.id == 42);
+    CHECK(sent.text == "hello");
+
+    Message next;
+    REQUIRE(telegram.apiSendMessage(43, "again", next));
+    CHECK(next.id == sent.id + 1);
+    CHECK(next.chat.id == 43);
+
+    TKeyboard keyboard(TKeyboard::Type::KEYBOARD, "pick");
+    keyboard.add("a").add("b");
+    Message menu;
+    REQUIRE(telegram.apiSendKeyboard(44, keyboard, menu));
+    CHECK(menu.chat.id == 44);
+    CHECK(menu.text == "pick");
+
+    char path[] = "/tmp/tessergram-upload-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    REQUIRE(write(fd, "data", 4) == 4);
+    close(fd);
+    Message photo;
+    CHECK(telegram.apiSendPhoto(45, "caption", path, photo));
+    CHECK(photo.id > menu.id);
+    CHECK(photo.chat.id == 45);
+    std::remove(path);
+}
+
+TEST_CASE("Telegram reports a send as done when only its result cannot be read")
+{
+    MockBotApi api;
+    api.setReply("sendMessage", "{\"ok\":true,\"result\":{\"date\":1}}");
+    REQUIRE(api.start());
+    Telegram telegram("1:test", api.getBaseUrl());
+
+    Message sent;
+    sent.id = 99;
+    CHECK(telegram.apiSendMessage(42, "hello", sent));
+    CHECK(sent.empty());
+    CHECK(api.getRequestCount("sendMessage") == 1);
+}
+
+// ---------------------------------------------------------------------------
+// Telegram — media by file_id or URL
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Telegram sends media by reference as a JSON request")
+{
+    MockBotApi api;
+    REQUIRE(api.start());
+    Telegram telegram("1:test", api.getBaseUrl());
+
+    Message sent;
+    REQUIRE(telegram.apiSendMediaById(42, Media::Type::PHOTO, "look", "AgAC-file", sent));
+    CHECK(sent.chat.id == 42);
+    CHECK(telegram.apiSendMediaByUrl(42, Media::Type::VIDEO, "", "https://example.com/v.mp4"));
+
+    Media media;
+    media.type = Media::Type::DOCUMENT;
+    media.fileId = "BQAC-doc";
+    CHECK(telegram.apiSendMedia(43, media, "again"));
+
+    std::vector<std::string> photos = api.getRequestBodies("sendPhoto");
+    REQUIRE(photos.size() == 1);
+    CHECK(photos[0] == "{\"chat_id\":42,\"photo\":\"AgAC-file\",\"caption\":\"look\"}");
+    std::vector<std::string> videos = api.getRequestBodies("sendVideo");
+    REQUIRE(videos.size() == 1);
+    CHECK(videos[0] == "{\"chat_id\":42,\"video\":\"https://example.com/v.mp4\"}");
+    std::vector<std::string> documents = api.getRequestBodies("sendDocument");
+    REQUIRE(documents.size() == 1);
+    CHECK(documents[0] == "{\"chat_id\":43,\"document\":\"BQAC-doc\",\"caption\":\"again\"}");
+
+    CHECK_FALSE(telegram.apiSendMediaById(42, Media::Type::STICKER, "", "CAAC-sticker"));
+    media.type = Media::Type::CONTACT;
+    CHECK_FALSE(telegram.apiSendMedia(42, media, ""));
+    CHECK(api.getRequestCount() == 3);
+}
+
+// ---------------------------------------------------------------------------
+// Telegram — copy and forward
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Telegram copies and forwards single messages and reports the new ones")
+{
+    MockBotApi api;
+    REQUIRE(api.start());
+    Telegram telegram("1:test", api.getBaseUrl());
+
+    long long copied = 0;
+    REQUIRE(telegram.apiCopyMessage(10, 20, 5, copied));
+    CHECK(copied > 0);
+    std::vector<std::string> copies = api.getRequestBodies("copyMessage");
+    REQUIRE(copies.size() == 1);
+    CHECK(copies[0] == "{\"chat_id\":10,\"from_chat_id\":20,\"message_id\":5}");
+
+    Message forwarded;
+    REQUIRE(telegram.apiForwardMessage(11, 20, 6, forwarded));
+    CHECK(forwarded.id == copied + 1);
+    CHECK(forwarded.chat.id == 11);
+    CHECK(telegram.apiForwardMessage(11, 20, 7));
+    std::vector<std::string> forwards = api.getRequestBodies("forwardMessage");
+    REQUIRE(forwards.size() == 2);
+    CHECK(forwards[0] == "{\"chat_id\":11,\"from_chat_id\":20,\"message_id\":6}");
+}
+
+TEST_CASE("Telegram sends batched copies and forwards sorted, deduplicated and chunked")
+{
+    MockBotApi api;
+    REQUIRE(api.start());
+    Telegram telegram("1:test", api.getBaseUrl());
+
+    std::vector<long long> resultIds;
+    REQUIRE(telegram.apiCopyMessages(10, 20, {5, 3, 5, 1, 3}, resultIds));
+    std::vector<std::string> copies = api.getRequestBodies("copyMessages");
+    REQUIRE(copies.size() == 1);
+    CHECK(copies[0] == "{\"chat_id\":10,\"from_chat_id\":20,\"message_ids\":[1,3,5]}");
+    REQUIRE(resultIds.size() == 3);
+    CHECK(resultIds[0] < resultIds[1]);
+    CHECK(resultIds[1] < resultIds[2]);
+
+    std::vector<long long> ids;
+    for (long long id = 150; id > 0; id--)
+        ids.push_back(id);
+    REQUIRE(telegram.apiForwardMessages(11, 20, ids, resultIds));
+    std::vector<std::string> forwards = api.getRequestBodies("forwardMessages");
+    REQUIRE(forwards.size() == 2);
+    CHECK(forwards[0].find("\"message_ids\":[1,2,3,") != std::string::npos);
+    CHECK(forwards[0].find(",100]") != std::string::npos);
+    CHECK(forwards[1].find("\"message_ids\":[101,") != std::string::npos);
+    CHECK(forwards[1].find(",150]") != std::string::npos);
+    CHECK(resultIds.size() == 150);
+
+    CHECK(telegram.apiCopyMessages(10, 20, std::vector<long long>()));
+    CHECK(api.getRequestBodies("copyMessages").size() == 1);
+}
@@ -0,0 +1,97 @@
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "doctest.h"
+#include "nlohmann/json.hpp"
+#include "session-store.hpp"
+
+// ---------------------------------------------------------------------------
+// SessionStore — keys and updates
+// ---------------------------------------------------------------------------
+
+TEST_CASE("SessionStore scope decides whether the sender is part of the key")
+{
+    SessionStore perChat(SessionStore::Scope::CHAT);
+    SessionStore perUser(SessionStore::Scope::CHAT_USER);
+    nlohmann::json state;
+
+    perChat.set(-100, 1, {{"step", 1}});
+    CHECK(perChat.get(-100, 2, state));
+    CHECK(state["step"] == 1);
+
+    perUser.set(-100, 1, {{"step", 1}});
+    CHECK_FALSE(perUser.get(-100, 2, state));
+    CHECK(perUser.get(-100, 1, state));
+    CHECK(perUser.erase(-100, 1));
+    CHECK(perUser.size() == 0);
+}
+
+TEST_CASE("SessionStore::update is atomic per session across threads")
+{
+    SessionStore store(SessionStore::Scope::CHAT, 0, 8);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++)
+    {
+        workers.emplace_back(
+            [&store]()
+            {
+                for (int i = 0; i < 1000; i++)
+                {
+                    store.update(i % 16, 0,
+                                 [](nlohmann::json &state)
+                                 {
+                                     state["count"] = state.value("count", 0) + 1;
+                                 });
+                }
+            });
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+
+    long long total = 0;
+    for (int chat = 0; chat < 16; chat++)
+    {
+        nlohmann::json state;
+        REQUIRE(store.get(chat, 0, state));
+        total += state["count"].get<long long>();
+    }
+    CHECK(total == 4000);
+    CHECK(store.size() == 16);
+}
+
+// ---------------------------------------------------------------------------
+// SessionStore — TTL and snapshots
+// ---------------------------------------------------------------------------
+
+TEST_CASE("SessionStore drops sessions after the TTL")
+{
+    SessionStore store(SessionStore::Scope::CHAT, 1);
+    store.set(1, 0, {{"a", 1}});
+    store.set(2, 0, {{"b", 2}});
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+    nlohmann::json state;
+    CHECK_FALSE(store.get(1, 0, state));
+    CHECK(store.expire() == 1);
+    CHECK(store.size() == 0);
+}
+
+TEST_CASE("SessionStore snapshot round-trips through a file")
+{
+    std::string path = "/tmp/tessergram-sessions-test.jsonl";
+    {
+        SessionStore store(SessionStore::Scope::CHAT_USER, 3600);
+        store.set(10, 20, {{"lang", "en"}});
+        store.set(11, 21, {{"lang", "id"}});
+        REQUIRE(store.snapshot(path));
+    }
+
+    SessionStore restored(SessionStore::Scope::CHAT_USER, 3600);
+    REQUIRE(restored.restore(path));
+    nlohmann::json state;
+    CHECK(restored.get(11, 21, state));
+    CHECK(state["lang"] == "id");
+    CHECK(restored.size() == 2);
+    std::remove(path.c_str());
+}
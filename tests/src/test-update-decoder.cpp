@@ -0,0 +1,182 @@
+#include "doctest.h"
+#include <deque>
+#include <vector>
+#include "update-decoder.hpp"
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static const char *updatesBody =
+    "{\"ok\":true,\"result\":["
+    "{\"update_id\":1,\"message\":{\"message_id\":10,\"date\":1700000000,"
+    "\"from\":{\"id\":7,\"is_bot\":false,\"first_name\":\"Ann\",\"username\":\"ann\"},"
+    "\"chat\":{\"id\":7,\"type\":\"private\",\"first_name\":\"Ann\",\"last_name\":\"Lee\"},\"text\":\"hi \\\"there\\\"\"}},"
+    "{\"update_id\":2,\"edited_message\":{\"message_id\":10}},"
+    "{\"update_id\":3,\"callback_query\":{\"id\":\"4382901234567\",\"data\":\"vote:1\",\"chat_instance\":\"c\","
+    "\"from\":{\"id\":7,\"is_bot\":false,\"first_name\":\"Ann\",\"username\":\"ann\"}}},"
+    "{\"update_id\":4,\"message\":{\"message_id\":11,\"caption\":\"pic\",\"media_group_id\":\"1357\","
+    "\"from\":{\"id\":7,\"is_bot\":false,\"first_name\":\"Ann\",\"username\":\"ann\"},"
+    "\"chat\":{\"id\":-100,\"type\":\"supergroup\",\"title\":\"Room\"},"
+    "\"photo\":[{\"file_id\":\"a\",\"file_unique_id\":\"ua\",\"file_size\":100,\"width\":90,\"height\":60},"
+    "{\"file_id\":\"b\",\"file_unique_id\":\"ub\",\"file_size\":\"2048\",\"width\":320,\"height\":240},{\"width\":1}]}},"
+    "{\"update_id\":5,\"message\":{\"date\":1}}"
+    "]}";
+
+struct Decoded
+{
+    std::deque<NodeMessage> messages;
+    std::vector<JSONReader::Status> statuses;
+};
+
+static JSONReader::Status decodeAll(const UpdateDecoder &decoder, const std::string &body, Decoded &out)
+{
+    return decoder.decodeUpdates(
+        body,
+        [&](const UpdateFilter::Scan &) -> NodeMessage *
+        {
+            out.messages.emplace_back();
+            return &out.messages.back();
+        },
+        [&](NodeMessage &, JSONReader::Status status)
+        {
+            out.statuses.push_back(status);
+        });
+}
+
+static std::vector<UpdateDecoder::Backend> availableBackends()
+{
+    std::vector<UpdateDecoder::Backend> backends;
+    for (UpdateDecoder::Backend backend : {UpdateDecoder::Backend::NLOHMANN, UpdateDecoder::Backend::SIMDJSON})
+    {
+        if (UpdateDecoder::available(backend))
+            backends.push_back(backend);
+    }
+    return backends;
+}
+
+// ---------------------------------------------------------------------------
+// UpdateDecoder — every backend decodes the same corpus the same way
+// ---------------------------------------------------------------------------
+
+TEST_CASE("UpdateDecoder falls back to nlohmann for a backend that is not built")
+{
+    CHECK(UpdateDecoder::available(UpdateDecoder::Backend::NLOHMANN));
+    UpdateDecoder decoder(UpdateDecoder::Backend::SIMDJSON);
+    CHECK(UpdateDecoder::available(decoder.getBackend()));
+    CHECK(UpdateDecoder::available(UpdateDecoder::DEFAULT));
+}
+
+TEST_CASE("UpdateDecoder backends agree on a mixed getUpdates response")
+{
+    for (UpdateDecoder::Backend backend : availableBackends())
+    {
+        CAPTURE(UpdateDecoder::backendToString(backend));
+        UpdateDecoder decoder(backend);
+        Decoded out;
+        REQUIRE(decodeAll(decoder, updatesBody, out) == JSONReader::Status::OK);
+        REQUIRE(out.statuses.size() == 5);
+        CHECK(out.statuses[0] == JSONReader::Status::OK);
+        CHECK(out.statuses[1] == JSONReader::Status::UNKNOWN_KIND);
+        CHECK(out.statuses[2] == JSONReader::Status::OK);
+        CHECK(out.statuses[3] == JSONReader::Status::OK);
+        CHECK(out.statuses[4] == JSONReader::Status::MISSING);
+
+        out.messages[0].processMessage(
+            [](const Message &message)
+            {
+                CHECK(message.id == 10);
+                CHECK(message.dtime == 1700000000);
+                CHECK(message.text == "hi \"there\"");
+                CHECK(message.from.username == "ann");
+                CHECK(message.chat.title == "Ann Lee");
+            });
+        out.messages[2].processCallbackQuery(
+            [](const CallbackQuery &query)
+            {
+                CHECK(query.id == 4382901234567LL);
+                CHECK(query.data == "vote:1");
+                CHECK(query.from.id == 7);
+            });
+        out.messages[3].processMessage(
+            [](const Message &message)
+            {
+                CHECK(message.chat.type == Chat::Type::SUPERGROUP);
+                CHECK(message.chat.title == "Room");
+                CHECK(message.mediaGroupId == "1357");
+                REQUIRE(message.media.size() == 1);
+                REQUIRE(message.media[0].sizes.size() == 2);
+                CHECK(message.media[0].sizes[0].width == 90);
+                CHECK(message.media[0].fileId == "b");
+                CHECK(message.media[0].fileSize == 2048);
+                CHECK(message.media[0].height == 240);
+            });
+        CHECK(out.messages[4].getId() == 5);
+    }
+}
+
+TEST_CASE("UpdateDecoder skips updates the slot declines and reports broken input")
+{
+    for (UpdateDecoder::Backend backend : availableBackends())
+    {
+        CAPTURE(UpdateDecoder::backendToString(backend));
+        UpdateDecoder decoder(backend);
+        int done = 0;
+        JSONReader::Status status = decoder.decodeUpdates(
+            updatesBody,
+            [](const UpdateFilter::Scan &) -> NodeMessage *
+            {
+                return nullptr;
+            },
+            [&](NodeMessage &, JSONReader::Status)
+            {
+                done++;
+            });
+        CHECK(status == JSONReader::Status::OK);
+        CHECK(done == 0);
+
+        Decoded out;
+        CHECK(decodeAll(decoder, "{\"result\":[{\"update_id\":1", out) == JSONReader::Status::MALFORMED);
+        CHECK(decodeAll(decoder, "{\"result\":5}", out) == JSONReader::Status::WRONG_TYPE);
+
+        NodeMessage single;
+        CHECK(decoder.decodeUpdate("{\"update_id\":9,\"poll\":{}}", single) == JSONReader::Status::UNKNOWN_KIND);
+        CHECK(single.getId() == 9);
+        CHECK(decoder.decodeUpdate("not json", single) == JSONReader::Status::MALFORMED);
+    }
+}
+
+TEST_CASE("UpdateDecoder reads method results")
+{
+    for (UpdateDecoder::Backend backend : availableBackends())
+    {
+        CAPTURE(UpdateDecoder::backendToString(backend));
+        UpdateDecoder decoder(backend);
+
+        User me;
+        CHECK(decoder.decodeResult("{\"ok\":true,\"result\":{\"id\":42,\"is_bot\":true,\"first_name\":\"Bot\",\"username\":\"the_bot\"}}", me) == JSONReader::Status::OK);
+        CHECK(me.id == 42);
+        CHECK(me.username == "the_bot");
+
+        std::string path;
+        CHECK(decoder.decodeResult("{\"ok\":true,\"result\":{\"file_id\":\"x\",\"file_path\":\"photos/1.jpg\"}}", "file_path", path) == JSONReader::Status::OK);
+        CHECK(path == "photos/1.jpg");
+        CHECK(decoder.decodeResult("{\"ok\":false}", "file_path", path) == JSONReader::Status::MISSING);
+
+        Message sent;
+        CHECK(decoder.decodeResult("{\"ok\":true,\"result\":{\"message_id\":5,\"from\":{},\"chat\":{\"id\":1,\"type\":\"group\",\"title\":\"g\"}}}", sent) == JSONReader::Status::OK);
+        CHECK(sent.id == 5);
+        CHECK(sent.chat.title == "g");
+        CHECK(sent.from.empty());
+
+        long long copied = 0;
+        CHECK(decoder.decodeResult("{\"ok\":true,\"result\":{\"message_id\":77}}", "message_id", copied) == JSONReader::Status::OK);
+        CHECK(copied == 77);
+
+        std::vector<long long> ids;
+        CHECK(decoder.decodeResult("{\"ok\":true,\"result\":[{\"message_id\":8},{\"message_id\":\"9\"}]}", "message_id", ids) == JSONReader::Status::OK);
+        CHECK(ids == std::vector<long long>{8, 9});
+        CHECK(decoder.decodeResult("{\"ok\":true,\"result\":[{\"message_id\":8},{}]}", "message_id", ids) == JSONReader::Status::MISSING);
+        CHECK(decoder.decodeResult("{\"ok\":true,\"result\":{}}", "message_id", ids) == JSONReader::Status::MISSING);
+    }
+}
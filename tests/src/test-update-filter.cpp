@@ -0,0 +1,134 @@
+#include "doctest.h"
+#include <string>
+#include <vector>
+#include "telegram.hpp"
+#include "update-decoder.hpp"
+#include "metrics.hpp"
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static std::string textUpdate(long long updateId, long long chatId, const char *type, const std::string &text)
+{
+    std::string chat = std::string("{\"id\":") + std::to_string(chatId) + ",\"type\":\"" + type + "\"," +
+                       (std::string(type) == "private" ? "\"first_name\":\"u\"}" : "\"title\":\"g\"}");
+    return "{\"update_id\":" + std::to_string(updateId) + ",\"message\":{\"message_id\":1,\"date\":1700000000," +
+           "\"from\":{\"id\":5,\"is_bot\":false,\"first_name\":\"u\",\"username\":\"u\"},\"chat\":" + chat +
+           ",\"text\":\"" + text + "\"}}";
+}
+
+static UpdateFilter::Scan scanOf(UpdateFilter::Kind kind, Chat::Type type, long long chatId, const char *text)
+{
+    UpdateFilter::Scan scan;
+    scan.kind = kind;
+    scan.hasChat = true;
+    scan.chatType = type;
+    scan.chatId = chatId;
+    scan.text = text;
+    scan.textLength = text != nullptr ? std::string(text).size() : 0;
+    return scan;
+}
+
+static uint64_t filteredCount()
+{
+    return Metrics::global().counter("tessergram_updates_filtered_total", "", "Updates acknowledged without parsing because the prefilter rejected them").value();
+}
+
+// ---------------------------------------------------------------------------
+// UpdateFilter — criteria
+// ---------------------------------------------------------------------------
+
+TEST_CASE("UpdateFilter requires every configured criterion")
+{
+    UpdateFilter filter;
+    CHECK(filter.empty());
+    CHECK(filter.accept(UpdateFilter::Scan()));
+
+    filter.kind(UpdateFilter::Kind::MESSAGE).chatType(Chat::Type::PRIVATE).textPrefix("/").textPrefix("!");
+    CHECK_FALSE(filter.empty());
+    CHECK(filter.accept(scanOf(UpdateFilter::Kind::MESSAGE, Chat::Type::PRIVATE, 1, "/start")));
+    CHECK(filter.accept(scanOf(UpdateFilter::Kind::MESSAGE, Chat::Type::PRIVATE, 1, "!ban")));
+    CHECK_FALSE(filter.accept(scanOf(UpdateFilter::Kind::MESSAGE, Chat::Type::PRIVATE, 1, "hello")));
+    CHECK_FALSE(filter.accept(scanOf(UpdateFilter::Kind::MESSAGE, Chat::Type::PRIVATE, 1, nullptr)));
+    CHECK_FALSE(filter.accept(scanOf(UpdateFilter::Kind::MESSAGE, Chat::Type::GROUP, 1, "/start")));
+    CHECK_FALSE(filter.accept(scanOf(UpdateFilter::Kind::CALLBACK_QUERY, Chat::Type::PRIVATE, 1, "/start")));
+
+    UpdateFilter chats;
+    chats.chat(-100).chat(7);
+    CHECK(chats.accept(scanOf(UpdateFilter::Kind::OTHER, Chat::Type::CHANNEL, -100, nullptr)));
+    CHECK_FALSE(chats.accept(scanOf(UpdateFilter::Kind::MESSAGE, Chat::Type::PRIVATE, 8, nullptr)));
+    CHECK_FALSE(chats.accept(UpdateFilter::Scan()));
+}
+
+// ---------------------------------------------------------------------------
+// UpdateDecoder — raw scan
+// ---------------------------------------------------------------------------
+
+TEST_CASE("UpdateDecoder scans kind, chat and text before parsing")
+{
+    std::string body = "{\"ok\":true,\"result\":[" + textUpdate(1, -100, "supergroup", "/go \\u00e9\\\"x\\\"") + "," +
+                       "{\"update_id\":2,\"callback_query\":{\"id\":\"9\",\"data\":\"vote:1\",\"from\":{},"
+                       "\"message\":{\"message_id\":3,\"chat\":{\"type\":\"private\",\"id\":7}}}}," +
+                       "{\"update_id\":3,\"poll\":{\"id\":\"1\"}}]}";
+    for (UpdateDecoder::Backend backend : {UpdateDecoder::Backend::NLOHMANN, UpdateDecoder::Backend::SIMDJSON})
+    {
+        if (!UpdateDecoder::available(backend))
+            continue;
+        CAPTURE(UpdateDecoder::backendToString(backend));
+        std::vector<UpdateFilter::Scan> scans;
+        std::vector<std::string> texts;
+        UpdateDecoder decoder(backend);
+        JSONReader::Status status = decoder.decodeUpdates(
+            body,
+            [&](const UpdateFilter::Scan &scan) -> NodeMessage *
+            {
+                scans.push_back(scan);
+                texts.push_back(scan.text != nullptr ? std::string(scan.text, scan.textLength) : "<none>");
+                return nullptr;
+            },
+            [](NodeMessage &, JSONReader::Status) {},
+            true);
+        CHECK(status == JSONReader::Status::OK);
+        REQUIRE(scans.size() == 3);
+
+        CHECK(scans[0].kind == UpdateFilter::Kind::MESSAGE);
+        CHECK(scans[0].chatType == Chat::Type::SUPERGROUP);
+        CHECK(scans[0].chatId == -100);
+        CHECK(texts[0] == "/go \xc3\xa9\"x\"");
+
+        CHECK(scans[1].kind == UpdateFilter::Kind::CALLBACK_QUERY);
+        CHECK(scans[1].hasChat);
+        CHECK(scans[1].chatId == 7);
+        CHECK(texts[1] == "vote:1");
+
+        CHECK(scans[2].kind == UpdateFilter::Kind::OTHER);
+        CHECK_FALSE(scans[2].hasChat);
+        CHECK(texts[2] == "<none>");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Telegram — filtered updates are acknowledged, not queued
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Telegram acknowledges updates its prefilter rejects")
+{
+    Telegram telegram("1:test", "http://127.0.0.1:1");
+    telegram.setUpdateFilter(UpdateFilter().kind(UpdateFilter::Kind::MESSAGE).chatType(Chat::Type::PRIVATE).textPrefix("/"));
+
+    uint64_t before = filteredCount();
+    std::string body = "{\"ok\":true,\"result\":[" + textUpdate(21, 5, "private", "/start") + "," +
+                       textUpdate(22, -100, "group", "/start") + "," + textUpdate(23, 5, "private", "hello") + "]}";
+    CHECK(telegram.parseGetUpdatesResponse(body));
+    CHECK(filteredCount() - before == 2);
+
+    NodeMessage message;
+    CHECK_FALSE(telegram.parseWebhookUpdate(textUpdate(24, 5, "private", "hi"), message));
+    CHECK(telegram.parseWebhookUpdate(textUpdate(25, 5, "private", "/help"), message));
+    CHECK(filteredCount() - before == 3);
+
+    // the queue is dropped and everything seen, filtered or not, is committed
+    telegram.clearUpdates();
+    CHECK(telegram.getCommittedUpdateId() == 25);
+}
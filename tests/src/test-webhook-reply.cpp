@@ -0,0 +1,135 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "doctest.h"
+#include "telegram.hpp"
+
+static const char *UPDATE =
+    "{\"update_id\":5,\"message\":{\"message_id\":9,\"date\":1700000000,"
+    "\"from\":{\"id\":42,\"is_bot\":false,\"first_name\":\"T\"},"
+    "\"chat\":{\"id\":42,\"type\":\"private\",\"first_name\":\"T\"},"
+    "\"text\":\"ping\"}}";
+
+// posts one delivery and returns the response body, or "" on failure
+static std::string post(int port, const std::string &body)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int attempt = 0; connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0; attempt++)
+    {
+        if (attempt == 50)
+        {
+            close(fd);
+            return "";
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    std::string request = "POST / HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: " + std::to_string(body.length()) + "\r\n\r\n" + body;
+    send(fd, request.data(), request.length(), MSG_NOSIGNAL);
+
+    std::string response;
+    char chunk[1024];
+    for (;;)
+    {
+        std::size_t headerEnd = response.find("\r\n\r\n");
+        if (headerEnd != std::string::npos)
+        {
+            std::size_t pos = response.find("Content-Length:");
+            std::size_t length = pos < headerEnd ? std::strtoul(response.c_str() + pos + 15, nullptr, 10) : 0;
+            if (response.length() >= headerEnd + 4 + length)
+            {
+                close(fd);
+                return response.substr(headerEnd + 4, length);
+            }
+        }
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            break;
+        response.append(chunk, static_cast<std::size_t>(n));
+    }
+    close(fd);
+    return "";
+}
+
+// port of a server started on port 0, or 0 if it does not come up
+static int waitForPort(const WebhookServer &server)
+{
+    for (int attempt = 0; server.getPort() == 0 && attempt < 100; attempt++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return server.getPort();
+}
+
+// ---------------------------------------------------------------------------
+// WebhookReply — response body
+// ---------------------------------------------------------------------------
+
+TEST_CASE("WebhookReply carries the method next to its parameters")
+{
+    CHECK(WebhookReply().empty());
+    CHECK(WebhookReply().toResponseBody().empty());
+
+    WebhookReply reply = WebhookReply::sendMessage(42, "pong \"1\"");
+    CHECK(reply.getType() == Request::Type::SEND_MESSAGE);
+    CHECK(reply.toResponseBody() == "{\"method\":\"sendMessage\",\"chat_id\":42,\"text\":\"pong \\\"1\\\"\"}");
+
+    CHECK(WebhookReply::sendChatAction(42, Chat::Action::TYPING).toResponseBody() ==
+          "{\"method\":\"sendChatAction\",\"chat_id\":42,\"action\":\"typing\"}");
+}
+
+// ---------------------------------------------------------------------------
+// WebhookServer — inline replies
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Webhook reply goes inline, or falls back to a plain 200 after the deadline")
+{
+    Telegram telegram("1:test", "http://127.0.0.1:1");
+    WebhookServer server;
+    WebhookServer::Config config;
+    config.listenAddress = "http://127.0.0.1:0";
+    config.replyDeadlineMs = 200;
+    server.configure(config);
+    telegram.setWebhookReplyCallback(
+        [](Telegram &, const NodeMessage &update)
+        {
+            WebhookReply reply;
+            update.processMessage(
+                [&](const Message &m)
+                {
+                    if (m.text == "slow")
+                        std::this_thread::sleep_for(std::chrono::milliseconds(600));
+                    reply = WebhookReply::sendMessage(m.chat.id, "pong");
+                });
+            return reply;
+        });
+
+    std::thread loop(
+        [&]()
+        {
+            server.run(&telegram);
+        });
+    int port = waitForPort(server);
+    REQUIRE(port > 0);
+
+    CHECK(post(port, UPDATE) == "{\"method\":\"sendMessage\",\"chat_id\":42,\"text\":\"pong\"}");
+
+    std::string slow(UPDATE);
+    slow.replace(slow.find("ping"), 4, "slow");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string body = post(port, slow);
+    CHECK(body.find("\"status\":\"success\"") != std::string::npos);
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(550));
+
+    server.stop();
+    loop.join();
+}
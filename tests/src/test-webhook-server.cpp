@@ -0,0 +1,209 @@
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "doctest.h"
+#include "telegram.hpp"
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+// a loopback connection whose reads give up after two seconds
+static int connectTo(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct timeval timeout = {2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// reads until the peer closes (true) or the read times out (false)
+static bool readUntilClosed(int fd, std::string &received)
+{
+    char chunk[1024];
+    for (;;)
+    {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n == 0)
+            return true;
+        if (n < 0)
+            return errno == ECONNRESET;
+        received.append(chunk, static_cast<std::size_t>(n));
+    }
+}
+
+// reads until the response headers are complete
+static bool readHeaders(int fd, std::string &received)
+{
+    char chunk[1024];
+    while (received.find("\r\n\r\n") == std::string::npos)
+    {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            return false;
+        received.append(chunk, static_cast<std::size_t>(n));
+    }
+    return true;
+}
+
+class RunningServer
+{
+public:
+    Telegram telegram;
+    WebhookServer server;
+    std::thread loop;
+
+    explicit RunningServer(const WebhookServer::Config &config) : telegram("1:test", "http://127.0.0.1:1"), server(), loop()
+    {
+        this->telegram.setWebhookCallback([](Telegram &, const NodeMessage &) {});
+        this->server.configure(config);
+        this->loop = std::thread(
+            [this]()
+            {
+                this->server.run(&this->telegram);
+            });
+        for (int attempt = 0; this->server.getPort() == 0 && attempt < 100; attempt++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ~RunningServer()
+    {
+        this->server.stop();
+        this->loop.join();
+    }
+};
+
+static WebhookServer::Config localConfig()
+{
+    WebhookServer::Config config;
+    config.listenAddress = "http://127.0.0.1:0";
+    return config;
+}
+
+// ---------------------------------------------------------------------------
+// WebhookServer — limits
+// ---------------------------------------------------------------------------
+
+TEST_CASE("WebhookServer answers 413 to a body over maxBodySize")
+{
+    WebhookServer::Config config = localConfig();
+    config.maxBodySize = 64;
+    RunningServer server(config);
+    REQUIRE(server.server.getPort() > 0);
+
+    int fd = connectTo(server.server.getPort());
+    REQUIRE(fd >= 0);
+    std::string request = "POST / HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 1000\r\n\r\n" + std::string(1000, 'x');
+    send(fd, request.data(), request.length(), MSG_NOSIGNAL);
+    std::string response;
+    CHECK(readUntilClosed(fd, response));
+    CHECK(response.compare(0, 12, "HTTP/1.1 413") == 0);
+    close(fd);
+}
+
+TEST_CASE("WebhookServer refuses connections beyond maxConnections")
+{
+    WebhookServer::Config config = localConfig();
+    config.maxConnections = 2;
+    RunningServer server(config);
+    REQUIRE(server.server.getPort() > 0);
+
+    int first = connectTo(server.server.getPort());
+    int second = connectTo(server.server.getPort());
+    REQUIRE(first >= 0);
+    REQUIRE(second >= 0);
+    for (int attempt = 0; server.server.getConnectionCount() < 2 && attempt < 100; attempt++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    int third = connectTo(server.server.getPort());
+    REQUIRE(third >= 0);
+    std::string received;
+    CHECK(readUntilClosed(third, received));
+    CHECK(received.empty());
+    close(third);
+
+    // the admitted ones are still served
+    std::string request = "POST / HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 2\r\n\r\n{}";
+    send(first, request.data(), request.length(), MSG_NOSIGNAL);
+    CHECK(readHeaders(first, received));
+    CHECK(received.compare(0, 12, "HTTP/1.1 200") == 0);
+    close(first);
+    close(second);
+}
+
+TEST_CASE("WebhookServer closes a connection idle for readTimeoutMs")
+{
+    WebhookServer::Config config = localConfig();
+    config.readTimeoutMs = 200;
+    RunningServer server(config);
+    REQUIRE(server.server.getPort() > 0);
+
+    int fd = connectTo(server.server.getPort());
+    REQUIRE(fd >= 0);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string received;
+    CHECK(readUntilClosed(fd, received));
+    std::chrono::steady_clock::duration idle = std::chrono::steady_clock::now() - start;
+    CHECK(idle >= std::chrono::milliseconds(150));
+    CHECK(idle < std::chrono::milliseconds(1500));
+    CHECK(received.empty());
+    close(fd);
+}
+
+// ---------------------------------------------------------------------------
+// WebhookServer — metrics endpoint
+// ---------------------------------------------------------------------------
+
+static std::string scrape(int port, const std::string &authorization)
+{
+    int fd = connectTo(port);
+    if (fd < 0)
+        return "";
+    std::string request = "GET /metrics HTTP/1.1\r\nHost: 127.0.0.1\r\n";
+    if (!authorization.empty())
+        request += "Authorization: " + authorization + "\r\n";
+    request += "\r\n";
+    send(fd, request.data(), request.length(), MSG_NOSIGNAL);
+    std::string received;
+    readHeaders(fd, received);
+    close(fd);
+    return received;
+}
+
+TEST_CASE("WebhookServer serves /metrics only when enabled and only with the token")
+{
+    {
+        RunningServer server(localConfig());
+        REQUIRE(server.server.getPort() > 0);
+        std::string response = scrape(server.server.getPort(), "");
+        CHECK(response.compare(0, 12, "HTTP/1.1 200") == 0);
+        CHECK(response.find("text/plain") == std::string::npos);
+    }
+
+    WebhookServer::Config config = localConfig();
+    config.metricsToken = "s3cret";
+    RunningServer server(config);
+    REQUIRE(server.server.getPort() > 0);
+    CHECK(scrape(server.server.getPort(), "").compare(0, 12, "HTTP/1.1 401") == 0);
+    CHECK(scrape(server.server.getPort(), "Bearer wrong").compare(0, 12, "HTTP/1.1 401") == 0);
+    std::string response = scrape(server.server.getPort(), "Bearer s3cret");
+    CHECK(response.compare(0, 12, "HTTP/1.1 200") == 0);
+    CHECK(response.find("text/plain") != std::string::npos);
+}
@@ -0,0 +1,440 @@
+#include <algorithm>
+#include <ctime>
+#include <stdexcept>
+#include "mock-bot-api.hpp"
+#include "json-writer.hpp"
+#include "nlohmann/json.hpp"
+#include "log.hpp"
+#include "utils/include/error.hpp"
+
+extern "C"
+{
+#include "mongoose.h"
+}
+
+namespace
+{
+    long long chatIdOf(const nlohmann::json &json, const std::string &body)
+    {
+        if (json.is_object() && json.contains("chat_id"))
+        {
+            const nlohmann::json &id = json["chat_id"];
+            if (id.is_number_integer())
+                return id.get<long long>();
+            if (id.is_string())
+                return std::strtoll(id.get<std::string>().c_str(), nullptr, 10);
+        }
+        // multipart uploads: the field value follows the part headers
+        std::size_t pos = body.find("name=\"chat_id\"");
+        if (pos == std::string::npos)
+            return 0;
+        pos = body.find("\r\n\r\n", pos);
+        return pos == std::string::npos ? 0 : std::strtoll(body.c_str() + pos + 4, nullptr, 10);
+    }
+
+    void writeUser(JSONWriter &json, long long id, bool isBot, const char *name)
+    {
+        json.beginObject()
+            .field("id", id)
+            .field("is_bot", isBot)
+            .field("first_name", name)
+            .field("username", name)
+            .endObject();
+    }
+
+    void writeChat(JSONWriter &json, long long id)
+    {
+        json.beginObject()
+            .field("id", id)
+            .field("type", "private")
+            .field("first_name", "user")
+            .field("username", "user")
+            .endObject();
+    }
+}
+
+MockBotApi::MockBotApi(const std::string &listenAddress)
+    : listenAddress(listenAddress),
+      running(false),
+      mgr(nullptr),
+      loop(),
+      latencyMs(0),
+      jitterMs(0),
+      rateLimitEvery(0),
+      retryAfter(1),
+      rng(12345),
+      nextUpdateId(1),
+      nextMessageId(1),
+      updates(),
+      pending(),
+      replies(),
+      methodCounts(),
+      methodBodies(),
+      requestCount(0),
+      rateLimitedCount(0),
+      mutex()
+{
+}
+
+MockBotApi::~MockBotApi()
+{
+    this->stop();
+}
+
+bool MockBotApi::start()
+{
+    if (this->running)
+        return true;
+
+    this->mgr = new struct mg_mgr;
+    mg_mgr_init(this->mgr);
+    struct mg_connection *listener = mg_http_listen(this->mgr, this->listenAddress.c_str(), MockBotApi::onHttp, this);
+    if (listener == NULL)
+    {
+        TG_LOG(Log::ERROR, "listen on %s failed!\n", this->listenAddress.c_str());
+        mg_mgr_free(this->mgr);
+        delete this->mgr;
+        this->mgr = nullptr;
+        return false;
+    }
+    // report the port actually bound, so port 0 can be used
+    this->listenAddress.replace(this->listenAddress.rfind(':') + 1, std::string::npos, std::to_string(mg_ntohs(listener->loc.port)));
+    this->running = true;
+    this->loop = std::thread(&MockBotApi::serve, this);
+    return true;
+}
+
+void MockBotApi::stop()
+{
+    if (!this->running)
+        return;
+    this->running = false;
+    this->loop.join();
+    mg_mgr_free(this->mgr);
+    delete this->mgr;
+    this->mgr = nullptr;
+
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->pending.clear();
+}
+
+const std::string &MockBotApi::getBaseUrl() const
+{
+    return this->listenAddress;
+}
+
+void MockBotApi::setLatency(int latencyMs, int jitterMs)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->latencyMs = std::max(0, latencyMs);
+    this->jitterMs = std::max(0, jitterMs);
+}
+
+void MockBotApi::setRateLimit(unsigned int every, int retryAfterSeconds)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->rateLimitEvery = every;
+    this->retryAfter = std::max(1, retryAfterSeconds);
+}
+
+void MockBotApi::setReply(const std::string &method, const std::string &body)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->replies[method] = body;
+}
+
+long long MockBotApi::pushUpdate(const std::string &updateJson, const std::string &token)
+{
+    long long updateId = 0;
+    try
+    {
+        updateId = nlohmann::json::parse(updateJson).at("update_id").get<long long>();
+    }
+    catch (const std::exception &e)
+    {
+        throw std::runtime_error(Error::common(__FILE__, __LINE__, __func__, "invalid input"));
+    }
+
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->updates[token].emplace_back(updateId, updateJson);
+    this->nextUpdateId = std::max(this->nextUpdateId, updateId + 1);
+    return updateId;
+}
+
+long long MockBotApi::pushMessage(long long chatId, const std::string &text, const std::string &token)
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    long long updateId = this->nextUpdateId++;
+
+    JSONWriter json;
+    json.beginObject().field("update_id", updateId).key("message").beginObject();
+    json.field("message_id", this->nextMessageId++).field("date", static_cast<long long>(time(nullptr)));
+    json.key("from");
+    writeUser(json, chatId, false, "user");
+    json.key("chat");
+    writeChat(json, chatId);
+    json.field("text", text).endObject().endObject();
+
+    this->updates[token].emplace_back(updateId, json.str());
+    return updateId;
+}
+
+std::string MockBotApi::updatesResponse(long long firstUpdateId, long long lastUpdateId, long long chatId)
+{
+    JSONWriter json;
+    json.beginObject().field("ok", true).key("result").beginArray();
+    for (long long updateId = firstUpdateId; updateId <= lastUpdateId; updateId++)
+    {
+        json.beginObject().field("update_id", updateId).key("message").beginObject();
+        json.field("message_id", updateId).field("date", 1700000000LL);
+        json.key("from");
+        writeUser(json, chatId, false, "user");
+        json.key("chat");
+        writeChat(json, chatId);
+        json.field("text", "hi").endObject().endObject();
+    }
+    json.endArray().endObject();
+    return json.str();
+}
+
+std::size_t MockBotApi::pendingUpdates() const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    std::size_t total = 0;
+    for (const std::pair<const std::string, std::deque<std::pair<long long, std::string>>> &queue : this->updates)
+        total += queue.second.size();
+    return total;
+}
+
+uint64_t MockBotApi::getRequestCount() const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    return this->requestCount;
+}
+
+uint64_t MockBotApi::getRequestCount(const std::string &method) const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    std::map<std::string, uint64_t>::const_iterator it = this->methodCounts.find(method);
+    return it == this->methodCounts.end() ? 0 : it->second;
+}
+
+std::vector<std::string> MockBotApi::getRequestBodies(const std::string &method) const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    std::map<std::string, std::vector<std::string>>::const_iterator it = this->methodBodies.find(method);
+    return it == this->methodBodies.end() ? std::vector<std::string>() : it->second;
+}
+
+uint64_t MockBotApi::getRateLimitedCount() const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    return this->rateLimitedCount;
+}
+
+void MockBotApi::serve()
+{
+    while (this->running)
+    {
+        bool waiting = false;
+        {
+            std::lock_guard<std::mutex> guard(this->mutex);
+            waiting = !this->pending.empty();
+        }
+        // short polls while replies are due so latency stays close to the setting
+        mg_mgr_poll(this->mgr, waiting ? 1 : 10);
+        this->flushPending();
+    }
+}
+
+void MockBotApi::flushPending()
+{
+    uint64_t now = mg_millis();
+    std::lock_guard<std::mutex> guard(this->mutex);
+    for (std::deque<Pending>::iterator it = this->pending.begin(); it != this->pending.end();)
+    {
+        if (it->due > now)
+        {
+            ++it;
+            continue;
+        }
+        if (it->longPoll && !this->collectUpdatesUnlocked(it->token, it->offset, it->limit, it->body) && now < it->expires)
+        {
+            ++it;
+            continue;
+        }
+
+        struct mg_connection *c = this->mgr->conns;
+        while (c != NULL && c->id != it->connection)
+            c = c->next;
+        if (c != NULL)
+            mg_http_reply(c, it->status, "Content-Type: application/json\r\n", "%.*s", static_cast<int>(it->body.length()), it->body.c_str());
+        it = this->pending.erase(it);
+    }
+}
+
+std::deque<std::pair<long long, std::string>> &MockBotApi::queueUnlocked(const std::string &token)
+{
+    std::map<std::string, std::deque<std::pair<long long, std::string>>>::iterator it = this->updates.find(token);
+    return it != this->updates.end() ? it->second : this->updates[""];
+}
+
+bool MockBotApi::collectUpdatesUnlocked(const std::string &token, long long offset, std::size_t limit, std::string &out)
+{
+    std::size_t count = 0;
+    out.assign("{\"ok\":true,\"result\":[");
+    for (const std::pair<long long, std::string> &update : this->queueUnlocked(token))
+    {
+        if (update.first < offset)
+            continue;
+        if (count == limit)
+            break;
+        if (count++ > 0)
+            out.push_back(',');
+        out.append(update.second);
+    }
+    out.append("]}");
+    return count > 0;
+}
+
+uint64_t MockBotApi::delayUnlocked()
+{
+    if (this->jitterMs == 0)
+        return static_cast<uint64_t>(this->latencyMs);
+    std::uniform_int_distribution<int> jitter(0, this->jitterMs);
+    return static_cast<uint64_t>(this->latencyMs + jitter(this->rng));
+}
+
+void MockBotApi::handle(const std::string &method, const std::string &body, Pending &reply)
+{
+    nlohmann::json json = nlohmann::json::parse(body, nullptr, false);
+    if (json.is_discarded() || !json.is_object())
+        json = nlohmann::json::object();
+
+    std::lock_guard<std::mutex> guard(this->mutex);
+    this->requestCount++;
+    this->methodCounts[method]++;
+    this->methodBodies[method].push_back(body);
+    reply.status = 200;
+    reply.due = mg_millis() + this->delayUnlocked();
+
+    if (this->rateLimitEvery > 0 && this->requestCount % this->rateLimitEvery == 0)
+    {
+        this->rateLimitedCount++;
+        JSONWriter out;
+        out.beginObject()
+            .field("ok", false)
+            .field("error_code", 429)
+            .field("description", "Too Many Requests: retry after " + std::to_string(this->retryAfter))
+            .key("parameters")
+            .beginObject()
+            .field("retry_after", this->retryAfter)
+            .endObject()
+            .endObject();
+        reply.status = 429;
+        reply.body = out.str();
+        return;
+    }
+
+    std::map<std::string, std::string>::const_iterator canned = this->replies.find(method);
+    if (canned != this->replies.end())
+    {
+        reply.body = canned->second;
+        return;
+    }
+
+    if (method == "getUpdates")
+    {
+        reply.offset = json.value("offset", 0LL);
+        reply.limit = static_cast<std::size_t>(std::min(100LL, std::max(1LL, json.value("limit", 100LL))));
+        // an offset confirms every update before it, as on the real service
+        std::deque<std::pair<long long, std::string>> &queue = this->queueUnlocked(reply.token);
+        while (!queue.empty() && queue.front().first < reply.offset)
+            queue.pop_front();
+        reply.longPoll = true;
+        reply.expires = reply.due + static_cast<uint64_t>(std::max(0LL, json.value("timeout", 0LL))) * 1000;
+        return;
+    }
+
+    JSONWriter out;
+    out.beginObject().field("ok", true).key("result");
+    if (method == "getMe")
+    {
+        writeUser(out, 1, true, "mock_bot");
+    }
+    else if (method == "getFile")
+    {
+        out.beginObject()
+            .field("file_id", json.value("file_id", std::string("file")))
+            .field("file_path", "files/mock.bin")
+            .endObject();
+    }
+    else if (method == "copyMessage")
+    {
+        out.beginObject().field("message_id", this->nextMessageId++).endObject();
+    }
+    else if (method == "copyMessages" || method == "forwardMessages")
+    {
+        out.beginArray();
+        if (json.contains("message_ids") && json["message_ids"].is_array())
+        {
+            for (std::size_t i = 0; i < json["message_ids"].size(); i++)
+                out.beginObject().field("message_id", this->nextMessageId++).endObject();
+        }
+        out.endArray();
+    }
+    else if (method.compare(0, 4, "send") == 0 || method.compare(0, 4, "edit") == 0 || method == "forwardMessage")
+    {
+        // edits keep the message they change; everything else is a new message
+        long long messageId = method.compare(0, 4, "edit") == 0 ? json.value("message_id", 0LL) : this->nextMessageId++;
+        out.beginObject()
+            .field("message_id", messageId)
+            .field("date", static_cast<long long>(time(nullptr)));
+        out.key("from");
+        writeUser(out, 1, true, "mock_bot");
+        out.key("chat");
+        writeChat(out, chatIdOf(json, body));
+        if (json.contains("text") && json["text"].is_string())
+            out.field("text", json["text"].get<std::string>());
+        out.endObject();
+    }
+    else
+    {
+        out.value(true);
+    }
+    out.endObject();
+    reply.body = out.str();
+}
+
+void MockBotApi::onHttp(struct mg_connection *c, int ev, void *ev_data)
+{
+    if (ev != MG_EV_HTTP_MSG)
+        return;
+
+    MockBotApi *api = static_cast<MockBotApi *>(c->fn_data);
+    struct mg_http_message *hm = static_cast<struct mg_http_message *>(ev_data);
+    struct mg_str caps[3];
+
+    if (mg_match(hm->uri, mg_str("/file/bot*/#"), caps))
+    {
+        mg_http_reply(c, 200, "Content-Type: application/octet-stream\r\n", "mock file content");
+        return;
+    }
+    if (!mg_match(hm->uri, mg_str("/bot*/*"), caps))
+    {
+        mg_http_reply(c, 404, "Content-Type: application/json\r\n", "{\"ok\":false,\"error_code\":404,\"description\":\"Not Found\"}");
+        return;
+    }
+
+    Pending reply;
+    reply.connection = c->id;
+    reply.token.assign(caps[0].buf, caps[0].len);
+    reply.longPoll = false;
+    reply.expires = 0;
+    reply.offset = 0;
+    reply.limit = 100;
+    api->handle(std::string(caps[1].buf, caps[1].len), std::string(hm->body.buf, hm->body.len), reply);
+
+    std::lock_guard<std::mutex> guard(api->mutex);
+    api->pending.push_back(reply);
+}
@@ -0,0 +1,109 @@
+#ifndef __MOCK_BOT_API_HPP__
+#define __MOCK_BOT_API_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct mg_connection;
+struct mg_mgr;
+
+/**
+ * In-process stand-in for the Telegram Bot API, for offline benchmarks and
+ * CI.
+ *
+ * Point a bot at it with `Telegram(token, mock.getBaseUrl())`. getUpdates
+ * serves the queued updates honouring offset, limit and timeout (long
+ * polls are held open); updates pushed for a token go to that bot only,
+ * the others to every bot without a queue of its own; send, edit and forwardMessage return a canned Message that
+ * echoes chat id and text; copy methods return fresh message ids; everything else answers `{"ok":true}`;
+ * setReply() replaces the answer of one method. Responses
+ * can be delayed and every n-th request can be answered with 429. Delays
+ * never block the event loop, so concurrent clients overlap as they would
+ * against the real service.
+ *
+ * The default address binds an ephemeral port; getBaseUrl() reports the
+ * bound one once start() returns.
+ */
+class MockBotApi
+{
+public:
+    MockBotApi(const std::string &listenAddress = "http://127.0.0.1:0");
+    ~MockBotApi();
+
+    bool start();
+    void stop();
+    const std::string &getBaseUrl() const;
+
+    void setLatency(int latencyMs, int jitterMs = 0);
+    void setRateLimit(unsigned int every, int retryAfterSeconds = 1);
+    void setReply(const std::string &method, const std::string &body);
+
+    long long pushUpdate(const std::string &updateJson, const std::string &token = "");
+    long long pushMessage(long long chatId, const std::string &text, const std::string &token = "");
+    std::size_t pendingUpdates() const;
+
+    // a getUpdates response with one text message per update id, for
+    // feeding Telegram::parseGetUpdatesResponse() directly
+    static std::string updatesResponse(long long firstUpdateId, long long lastUpdateId, long long chatId = 1);
+
+    uint64_t getRequestCount() const;
+    uint64_t getRequestCount(const std::string &method) const;
+    std::vector<std::string> getRequestBodies(const std::string &method) const;
+    uint64_t getRateLimitedCount() const;
+
+private:
+    class Pending
+    {
+    public:
+        unsigned long connection;
+        std::string token;
+        uint64_t due;
+        int status;
+        std::string body;
+        bool longPoll;
+        uint64_t expires;
+        long long offset;
+        std::size_t limit;
+    };
+
+    std::string listenAddress;
+    std::atomic<bool> running;
+    struct mg_mgr *mgr;
+    std::thread loop;
+
+    int latencyMs;
+    int jitterMs;
+    unsigned int rateLimitEvery;
+    int retryAfter;
+    std::minstd_rand rng;
+
+    long long nextUpdateId;
+    long long nextMessageId;
+    std::map<std::string, std::deque<std::pair<long long, std::string>>> updates;
+    std::deque<Pending> pending;
+    std::map<std::string, std::string> replies;
+    std::map<std::string, uint64_t> methodCounts;
+    std::map<std::string, std::vector<std::string>> methodBodies;
+    uint64_t requestCount;
+    uint64_t rateLimitedCount;
+
+    mutable std::mutex mutex;
+
+    void serve();
+    void flushPending();
+    std::deque<std::pair<long long, std::string>> &queueUnlocked(const std::string &token);
+    bool collectUpdatesUnlocked(const std::string &token, long long offset, std::size_t limit, std::string &out);
+    uint64_t delayUnlocked();
+    void handle(const std::string &method, const std::string &body, Pending &reply);
+    static void onHttp(struct mg_connection *c, int ev, void *ev_data);
+};
+
+#endif